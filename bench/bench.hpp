@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+namespace bench {
+
+// keeps the optimizer from discarding work whose result is never read
+template <class T> inline void do_not_optimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// runs fn() iters times and returns the mean cost of one call in ns
+template <class F> double ns_per_op(std::size_t iters, F&& fn) {
+  using clock = std::chrono::steady_clock;
+  fn(); // warm caches
+  auto start = clock::now();
+  for (std::size_t i = 0; i < iters; i++) {
+    fn();
+  }
+  std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+  return elapsed.count() / static_cast<double>(iters);
+}
+
+// scales the iteration count so every row runs for roughly the same time
+inline std::size_t iters_for(std::size_t work, std::size_t budget = 1 << 26) {
+  return work >= budget ? 1 : budget / work;
+}
+
+} // namespace bench
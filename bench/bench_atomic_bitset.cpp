@@ -0,0 +1,69 @@
+#include "../include/atomic_bitset.hpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Claim/release throughput of a shared 64K-slot map, lock-free atomic_bitset
+// against a bitset guarded by one mutex, for 1 up to hardware_concurrency
+// threads. Each thread claims a slot and releases it straight away, from a
+// hint of its own, from no hint, and under the mutex from its hint.
+
+constexpr std::size_t slots = 1 << 16;
+constexpr std::size_t ops = 1 << 18;
+
+template <class F> static double mops(std::size_t threads, F&& worker) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (std::size_t t = 0; t < threads; t++)
+    pool.emplace_back(worker, t, threads);
+  for (auto& th : pool)
+    th.join();
+  std::chrono::duration<double, std::micro> us =
+      std::chrono::steady_clock::now() - start;
+  return static_cast<double>(threads * ops) / us.count();
+}
+
+int main() {
+  std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::printf("%8s %14s %14s %14s\n", "threads", "hinted Mop/s",
+              "unhinted Mop/s", "mutex Mop/s");
+  for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+    nstd::atomic_bitset<slots> shared;
+    double lock_free = mops(threads, [&](std::size_t t, std::size_t n) {
+      for (std::size_t k = 0; k < ops; k++) {
+        std::size_t slot = shared.claim_first_zero(t * slots / n);
+        shared.fetch_reset(slot, std::memory_order_release);
+      }
+    });
+
+    nstd::atomic_bitset<slots> unhinted_map;
+    double unhinted = mops(threads, [&](std::size_t, std::size_t) {
+      for (std::size_t k = 0; k < ops; k++) {
+        std::size_t slot = unhinted_map.claim_first_zero();
+        unhinted_map.fetch_reset(slot, std::memory_order_release);
+      }
+    });
+
+    nstd::bitset<slots> guarded;
+    std::mutex m;
+    double locked = mops(threads, [&](std::size_t t, std::size_t n) {
+      for (std::size_t k = 0; k < ops; k++) {
+        std::size_t slot;
+        {
+          std::lock_guard lock(m);
+          // first clear slot from the thread's hint, as claim_first_zero does
+          slot = t * slots / n;
+          while (guarded[slot])
+            slot = (slot + 1) % slots;
+          guarded.set(slot);
+        }
+        std::lock_guard lock(m);
+        guarded.reset(slot);
+      }
+    });
+    std::printf("%8zu %14.1f %14.1f %14.1f\n", threads, lock_free, unhinted,
+                locked);
+  }
+}
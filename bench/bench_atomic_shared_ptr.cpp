@@ -0,0 +1,80 @@
+#include "../include/memory.hpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// load() throughput from 1 up to hardware_concurrency threads, all reading
+// one atomic_shared_ptr, against a shared_ptr behind a mutex. A writer
+// thread stores a new object every few microseconds throughout, so the
+// loads race the swaps they are built to survive. Each load still writes
+// the atomic word and the object's count, so rows past one thread show
+// what sharing those two cache lines costs.
+
+constexpr std::size_t ops = 1 << 20;
+
+template <class F> static double mops(std::size_t threads, F&& worker) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (std::size_t t = 0; t < threads; t++)
+    pool.emplace_back(worker);
+  for (auto& th : pool)
+    th.join();
+  std::chrono::duration<double, std::micro> us =
+      std::chrono::steady_clock::now() - start;
+  return static_cast<double>(threads * ops) / us.count();
+}
+
+// stores a fresh value with store until stopped
+template <class Store> static std::jthread writer(Store store) {
+  return std::jthread([store](std::stop_token stop) {
+    for (int i = 0; !stop.stop_requested(); i++) {
+      store(i);
+      std::this_thread::sleep_for(std::chrono::microseconds(5));
+    }
+  });
+}
+
+int main() {
+  std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::printf("%8s %14s %14s\n", "threads", "atomic Mop/s", "mutex Mop/s");
+  for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+    nstd::atomic_shared_ptr<int> a(nstd::make_shared<int>(0));
+    double ours;
+    {
+      auto w = writer([&](int i) { a.store(nstd::make_shared<int>(i)); });
+      ours = mops(threads, [&] {
+        for (std::size_t k = 0; k < ops; k++)
+          bench::do_not_optimize(*a.load());
+      });
+    }
+
+    std::mutex m;
+    nstd::shared_ptr<int> guarded = nstd::make_shared<int>(0);
+    auto locked_load = [&] {
+      std::lock_guard lock(m);
+      return guarded;
+    };
+    double theirs;
+    {
+      auto w = writer([&](int i) {
+        auto p = nstd::make_shared<int>(i);
+        std::lock_guard lock(m);
+        guarded.swap(p);
+      });
+      theirs = mops(threads, [&] {
+        for (std::size_t k = 0; k < ops; k++)
+          bench::do_not_optimize(*locked_load());
+      });
+    }
+    std::printf("%8zu %14.1f %14.1f\n", threads, ours, theirs);
+  }
+
+  // no writer: the claim, the count, the returning CAS and the release
+  nstd::atomic_shared_ptr<int> quiet(nstd::make_shared<int>(1));
+  double load = bench::ns_per_op(
+      ops, [&] { bench::do_not_optimize(quiet.load().get()); });
+  std::printf("uncontended load: %.1f ns\n", load);
+}
@@ -0,0 +1,82 @@
+#include "../include/bit_matrix.hpp"
+#include "bench.hpp"
+#include <memory>
+#include <random>
+
+// A 4096 x 4096 transpose by 64x64 tiles against setting it bit by bit,
+// column reads before and after a transpose, and a 1024^3 boolean product:
+// Four Russians against one row OR per set bit and against intersects() on
+// the transposed right-hand side.
+
+constexpr std::size_t n = 4096;
+constexpr std::size_t m = 1024;
+
+template <std::size_t R, std::size_t C>
+static void fill(nstd::bit_matrix<R, C>& a, unsigned seed, int density) {
+  std::mt19937_64 gen(seed);
+  for (std::size_t i = 0; i < R; i++) {
+    for (std::size_t j = 0; j < C; j++)
+      a[i][j] = static_cast<int>(gen() % 100) < density;
+  }
+}
+
+int main() {
+  auto a = std::make_unique<nstd::bit_matrix<n, n>>();
+  auto t = std::make_unique<nstd::bit_matrix<n, n>>();
+  fill(*a, 1, 50);
+
+  double naive = bench::ns_per_op(1, [&] {
+    for (std::size_t i = 0; i < n; i++) {
+      for (std::size_t j = 0; j < n; j++)
+        (*t)[j][i] = (*a)(i, j);
+    }
+    bench::do_not_optimize(*t);
+  });
+  double tiled = bench::ns_per_op(8, [&] {
+    *t = a->transpose();
+    bench::do_not_optimize(*t);
+  });
+  std::printf("transpose %zux%zu: bit by bit %.2f ms, 64x64 tiles %.2f ms\n",
+              n, n, naive / 1e6, tiled / 1e6);
+
+  double col = bench::ns_per_op(64, [&] {
+    bench::do_not_optimize(a->column(123).count());
+  });
+  double row = bench::ns_per_op(1 << 16, [&] {
+    bench::do_not_optimize((*t)[123].count());
+  });
+  std::printf("column count: column() %.0f ns, row of transpose %.0f ns\n",
+              col, row);
+
+  auto x = std::make_unique<nstd::bit_matrix<m, m>>();
+  auto y = std::make_unique<nstd::bit_matrix<m, m>>();
+  auto z = std::make_unique<nstd::bit_matrix<m, m>>();
+  std::printf("%8s %16s %16s %16s\n", "density", "row OR ms",
+              "intersects ms", "Four Russians ms");
+  for (int density : {1, 10, 50}) {
+    fill(*x, 2, density);
+    fill(*y, 3, density);
+    double rows = bench::ns_per_op(2, [&] {
+      z->reset();
+      for (std::size_t i = 0; i < m; i++) {
+        for (std::size_t k : (*x)[i].set_bits())
+          (*z)[i] |= (*y)[k];
+      }
+      bench::do_not_optimize(*z);
+    });
+    double dots = bench::ns_per_op(2, [&] {
+      auto yt = std::make_unique<nstd::bit_matrix<m, m>>(y->transpose());
+      for (std::size_t i = 0; i < m; i++) {
+        for (std::size_t j = 0; j < m; j++)
+          (*z)[i][j] = intersects((*x)[i], (*yt)[j]);
+      }
+      bench::do_not_optimize(*z);
+    });
+    double russians = bench::ns_per_op(2, [&] {
+      *z = *x * *y;
+      bench::do_not_optimize(*z);
+    });
+    std::printf("%7d%% %16.2f %16.2f %16.2f\n", density, rows / 1e6,
+                dots / 1e6, russians / 1e6);
+  }
+}
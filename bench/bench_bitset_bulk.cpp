@@ -0,0 +1,72 @@
+#include "../include/simd.hpp"
+#include "bench.hpp"
+#include <random>
+#include <vector>
+
+// Throughput of each dispatched kernel against the scalar fallback, on
+// 1 Mbit and 16 Mbit operands.
+
+namespace simd = nstd::detail::simd;
+
+static const char* name(simd::isa level) {
+  switch (level) {
+  case simd::isa::scalar:
+    return "scalar";
+  case simd::isa::sse2:
+    return "sse2";
+  case simd::isa::avx2:
+    return "avx2";
+  case simd::isa::avx512:
+    return "avx512";
+  }
+  return "?";
+}
+
+static void run(std::size_t bits) {
+  std::size_t n = bits / 64;
+  std::mt19937_64 gen(42);
+  std::vector<simd::word> a(n), b(n);
+  for (std::size_t i = 0; i < n; i++) {
+    a[i] = gen();
+    b[i] = gen();
+  }
+
+  std::size_t iters = bench::iters_for(n, 1 << 28);
+  double bytes = static_cast<double>(n * sizeof(simd::word));
+  std::printf("\n%zu bits, GB/s per operand\n", bits);
+  std::printf("%8s %8s %8s %8s %8s %8s\n", "isa", "and", "xor", "not", "count",
+              "equal");
+  for (auto level : {simd::isa::scalar, simd::isa::sse2, simd::isa::avx2,
+                     simd::isa::avx512}) {
+    if (level > simd::detected_isa())
+      break;
+    auto k = simd::kernels_for(level);
+    double t_and = bench::ns_per_op(iters, [&] {
+      k.bit_and(a.data(), b.data(), n);
+      bench::do_not_optimize(a[0]);
+    });
+    double t_xor = bench::ns_per_op(iters, [&] {
+      k.bit_xor(a.data(), b.data(), n);
+      bench::do_not_optimize(a[0]);
+    });
+    double t_not = bench::ns_per_op(iters, [&] {
+      k.bit_not(a.data(), n);
+      bench::do_not_optimize(a[0]);
+    });
+    double t_count = bench::ns_per_op(iters, [&] {
+      bench::do_not_optimize(k.count(a.data(), n));
+    });
+    double t_equal = bench::ns_per_op(iters, [&] {
+      bench::do_not_optimize(k.equal(a.data(), a.data(), n));
+    });
+    std::printf("%8s %8.2f %8.2f %8.2f %8.2f %8.2f\n", name(level),
+                bytes / t_and, bytes / t_xor, bytes / t_not, bytes / t_count,
+                bytes / t_equal);
+  }
+}
+
+int main() {
+  std::printf("dispatching to %s\n", name(simd::active().level));
+  run(1 << 20);
+  run(1 << 24);
+}
@@ -0,0 +1,60 @@
+#include "../include/bitset_distance.hpp"
+#include "bench.hpp"
+#include <random>
+#include <vector>
+
+// Hamming distance throughput in million fingerprints per second on one
+// core: a loop over (q ^ b).count() against hamming_distances() through
+// each kernel level this CPU supports. The base is 8 MiB of fingerprints.
+
+namespace simd = nstd::detail::simd;
+
+template <std::size_t N> static void run() {
+  using fp = nstd::bitset<N>;
+  const std::size_t n = (std::size_t{8} << 20) / sizeof(fp);
+  std::vector<fp> base(n);
+  std::mt19937_64 gen(1);
+  for (auto& b : base) {
+    for (std::size_t i = 0; i < N; i++)
+      b.set(i, gen() & 1);
+  }
+  fp query = base[n / 2];
+  std::vector<std::size_t> out(n);
+  std::size_t iters = bench::iters_for(n * N / 64, 1 << 27);
+  auto mfps = [&](double ns) { return n / ns * 1e3; };
+
+  double loop = bench::ns_per_op(iters, [&] {
+    for (std::size_t j = 0; j < n; j++)
+      out[j] = (query ^ base[j]).count();
+    bench::do_not_optimize(out.data());
+  });
+  std::printf("%6zu %10.1f", N, mfps(loop));
+
+  const simd::word* words = base.front().blocks().data();
+  for (auto level : {simd::isa::scalar, simd::isa::sse2, simd::isa::avx2,
+                     simd::isa::avx512}) {
+    if (level > simd::detected_isa()) {
+      std::printf(" %10s", "-");
+      continue;
+    }
+    auto k = simd::kernels_for(level);
+    double t = bench::ns_per_op(iters, [&] {
+      k.count_xor_many(query.blocks().data(), words, N / 64, n, out.data());
+      bench::do_not_optimize(out.data());
+    });
+    std::printf(" %10.1f", mfps(t));
+  }
+  double api = bench::ns_per_op(iters, [&] {
+    nstd::hamming_distances(query, base, out);
+    bench::do_not_optimize(out.data());
+  });
+  std::printf(" %10.1f\n", mfps(api));
+}
+
+int main() {
+  std::printf("%6s %10s %10s %10s %10s %10s %10s\n", "bits", "(q^b).count",
+              "scalar", "sse2", "avx2", "avx512", "batched");
+  run<256>();
+  run<1024>();
+  run<4096>();
+}
@@ -0,0 +1,55 @@
+#include "../include/bitset.hpp"
+#include "bench.hpp"
+#include <memory>
+#include <random>
+
+// Lazy expressions against the same work done with eager temporaries, on
+// 1 Mbit and 16 Mbit operands.
+
+template <std::size_t N> static void run() {
+  using bs = nstd::bitset<N>;
+  // too large for the stack
+  auto a = std::make_unique<bs>(), b = std::make_unique<bs>(),
+       c = std::make_unique<bs>(), r = std::make_unique<bs>(),
+       t1 = std::make_unique<bs>(), t2 = std::make_unique<bs>();
+  std::mt19937_64 gen(7);
+  for (std::size_t i = 0; i < N; i++) {
+    a->set(i, gen() & 1);
+    b->set(i, gen() & 1);
+    c->set(i, gen() & 1);
+  }
+
+  std::size_t iters = bench::iters_for(N / 64, 1 << 24);
+  double eager_expr = bench::ns_per_op(iters, [&] {
+    *t1 = *a;
+    *t1 &= *b;
+    *t2 = *c;
+    t2->flip();
+    *t1 |= *t2;
+    *r = *t1;
+    bench::do_not_optimize(*r);
+  });
+  double lazy_expr = bench::ns_per_op(iters, [&] {
+    *r = (*a & *b) | ~*c;
+    bench::do_not_optimize(*r);
+  });
+  double eager_count = bench::ns_per_op(iters, [&] {
+    *t1 = *b;
+    t1->flip();
+    *t1 &= *a;
+    bench::do_not_optimize(t1->count());
+  });
+  double lazy_count = bench::ns_per_op(iters, [&] {
+    bench::do_not_optimize(nstd::count(*a & ~*b));
+  });
+
+  std::printf("%10zu %14.1f %14.1f %14.1f %14.1f\n", N, eager_expr / 1000,
+              lazy_expr / 1000, eager_count / 1000, lazy_count / 1000);
+}
+
+int main() {
+  std::printf("%10s %14s %14s %14s %14s\n", "bits", "(a&b)|~c us",
+              "lazy us", "count(a&~b) us", "lazy us");
+  run<(1 << 20)>();
+  run<(1 << 24)>();
+}
@@ -0,0 +1,97 @@
+#include "../include/bitset.hpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <bitset>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// nstd::hash<bitset<N>> against std::hash<std::bitset<N>> and against
+// hashing to_string(), per call and in GB/s, then deduplicating a million
+// 256-bit state masks in an open-addressing table with each hash.
+
+template <std::size_t N> static void row() {
+  auto ours = std::make_unique<nstd::bitset<N>>();
+  auto theirs = std::make_unique<std::bitset<N>>();
+  std::mt19937_64 gen(N);
+  for (std::size_t i = 0; i < N; i++) {
+    bool bit = gen() & 1;
+    ours->set(i, bit);
+    theirs->set(i, bit);
+  }
+  std::size_t iters = bench::iters_for(N / 8, 1 << 28);
+  double nstd_ns = bench::ns_per_op(iters, [&] {
+    bench::do_not_optimize(nstd::hash<nstd::bitset<N>>{}(*ours));
+  });
+  double std_ns = bench::ns_per_op(iters, [&] {
+    bench::do_not_optimize(std::hash<std::bitset<N>>{}(*theirs));
+  });
+  double str_ns = bench::ns_per_op(bench::iters_for(N, 1 << 24), [&] {
+    bench::do_not_optimize(std::hash<std::string>{}(ours->to_string()));
+  });
+  std::printf("%8zu %12.1f %12.1f %12.1f %10.1f %10.1f\n", N, nstd_ns, std_ns,
+              str_ns, N / 8 / nstd_ns, N / 8 / std_ns);
+}
+
+// Linear-probing set of masks, the table shape the hash is meant for.
+// Returns ns per insert and sets probes to the mean probe count.
+template <class Bitset, class Hash>
+static double dedup(const std::vector<Bitset>& masks, double& probes) {
+  constexpr std::size_t slots = std::size_t{1} << 21;
+  std::vector<Bitset> table(slots);
+  std::vector<char> used(slots);
+  std::size_t steps = 0;
+  double ns = bench::ns_per_op(1, [&] {
+    std::fill(used.begin(), used.end(), 0);
+    steps = 0;
+    for (const auto& m : masks) {
+      std::size_t i = Hash{}(m) & (slots - 1);
+      while (used[i] && !(table[i] == m)) {
+        i = (i + 1) & (slots - 1);
+        steps++;
+      }
+      used[i] = 1;
+      table[i] = m;
+    }
+  });
+  probes = 1.0 + static_cast<double>(steps) / masks.size();
+  return ns / masks.size();
+}
+
+int main() {
+  std::printf("%8s %12s %12s %12s %10s %10s\n", "bits", "nstd ns", "std ns",
+              "to_string ns", "nstd GB/s", "std GB/s");
+  row<64>();
+  row<256>();
+  row<1024>();
+  row<8192>();
+  row<1 << 16>();
+  row<1 << 20>();
+
+  // a million 256-bit state masks, a quarter of them repeats
+  std::vector<nstd::bitset<256>> ours;
+  std::vector<std::bitset<256>> theirs;
+  std::mt19937_64 gen(1);
+  for (int i = 0; i < 1000000; i++) {
+    std::uint64_t seed = gen() % 4 ? gen() : gen() % 1000;
+    nstd::bitset<256> a;
+    std::bitset<256> b;
+    for (int w = 0; w < 4; w++) {
+      std::uint64_t bits = nstd::detail::mix64(seed + w);
+      a.deposit(64 * w, bits, 64);
+      b |= std::bitset<256>{bits} << (64 * w);
+    }
+    ours.push_back(a);
+    theirs.push_back(b);
+  }
+  double ours_probes, theirs_probes;
+  double ours_ns = dedup<nstd::bitset<256>, nstd::hash<nstd::bitset<256>>>(
+      ours, ours_probes);
+  double theirs_ns = dedup<std::bitset<256>, std::hash<std::bitset<256>>>(
+      theirs, theirs_probes);
+  std::printf("dedup 1M 256-bit masks, linear probing at 50%% load:\n"
+              "  nstd %.1f ns/insert, %.2f probes; std %.1f ns/insert, "
+              "%.2f probes\n",
+              ours_ns, ours_probes, theirs_ns, theirs_probes);
+}
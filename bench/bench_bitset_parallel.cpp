@@ -0,0 +1,51 @@
+#include "../include/bitset_parallel.hpp"
+#include "bench.hpp"
+#include <random>
+#include <thread>
+
+// count, |= and << on dynamic_bitsets from 256 KiB to 256 MiB with 1, 2, 4
+// and all hardware threads, in GB/s of bitset read. One thread is the serial
+// member; the smallest size sits below the parallel threshold and should
+// read the same in every column.
+
+using dbs = nstd::dynamic_bitset<>;
+
+template <class F> double gbps(std::size_t bytes, F f) {
+  double ns = bench::ns_per_op(bench::iters_for(bytes, 1 << 30), f);
+  return static_cast<double>(bytes) / ns;
+}
+
+int main() {
+  unsigned hw = std::thread::hardware_concurrency();
+  std::printf("hardware threads: %u\n", hw);
+  const unsigned threads[] = {1, 2, 4, hw};
+
+  for (const char* op : {"count", "or", "shift"}) {
+    std::printf("\n%s\n%10s %8s %8s %8s %8s\n", op, "MiB", "1", "2", "4",
+                "hw");
+    for (std::size_t mib : {0, 8, 64, 256}) {
+      std::size_t bytes = mib ? mib << 20 : std::size_t{1} << 18;
+      std::size_t n = bytes * 8;
+      dbs a(n), b(n);
+      std::mt19937_64 gen(mib);
+      for (std::size_t i = 0; i < n; i += 1 + gen() % 7)
+        a.set(i);
+      for (std::size_t i = 0; i < n; i += 1 + gen() % 5)
+        b.set(i);
+
+      std::printf("%10.2f", static_cast<double>(bytes) / (1 << 20));
+      for (unsigned t : threads) {
+        nstd::parallel_policy p{t};
+        std::printf(" %8.2f", gbps(bytes, [&] {
+                      if (op[0] == 'c')
+                        bench::do_not_optimize(nstd::count(p, a));
+                      else if (op[0] == 'o')
+                        nstd::or_assign(p, a, b);
+                      else
+                        nstd::shift_left(p, a, 129);
+                    }));
+      }
+      std::printf("\n");
+    }
+  }
+}
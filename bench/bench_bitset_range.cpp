@@ -0,0 +1,50 @@
+#include "../include/bitset.hpp"
+#include "bench.hpp"
+#include <cstdint>
+#include <random>
+
+// Range updates and field access against the per-bit loops they replace.
+
+int main() {
+  constexpr std::size_t n = 1 << 16;
+  nstd::bitset<n> b;
+  std::mt19937_64 gen(1);
+
+  std::printf("%8s %14s %14s\n", "range", "per-bit (ns)", "set_range (ns)");
+  for (std::size_t len : {10, 100, 10000}) {
+    double loop = bench::ns_per_op(1 << 12, [&] {
+      std::size_t first = gen() % (n - len);
+      for (std::size_t i = first; i < first + len; i++)
+        b.set(i);
+      bench::do_not_optimize(b);
+    });
+    double range = bench::ns_per_op(1 << 12, [&] {
+      std::size_t first = gen() % (n - len);
+      b.set_range(first, first + len);
+      bench::do_not_optimize(b);
+    });
+    std::printf("%8zu %14.1f %14.1f\n", len, loop, range);
+  }
+
+  // 16 scattered flags out of each 64-bit window
+  const std::uint64_t mask = 0x8421'8421'8421'8421;
+  double loop = bench::ns_per_op(1 << 20, [&] {
+    std::size_t pos = gen() % (n - 64);
+    std::uint64_t v = 0;
+    std::size_t k = 0;
+    for (std::size_t i = 0; i < 64; i++) {
+      if ((mask >> i) & 1)
+        v |= std::uint64_t{b[pos + i]} << k++;
+    }
+    bench::do_not_optimize(v);
+  });
+  double gather = bench::ns_per_op(1 << 20, [&] {
+    bench::do_not_optimize(b.gather(gen() % (n - 64), mask));
+  });
+  double field = bench::ns_per_op(1 << 20, [&] {
+    bench::do_not_optimize(b.extract<24>(gen() % (n - 64)));
+  });
+  std::printf("gather 16 flags: per-bit %.1f ns, gather %.1f ns; "
+              "extract<24> %.1f ns\n",
+              loop, gather, field);
+}
@@ -0,0 +1,37 @@
+#include "../include/bitset.hpp"
+#include "bench.hpp"
+#include <memory>
+
+// Shift cost should grow with the number of blocks (N / 64), not with N.
+
+template <std::size_t N> void run() {
+  auto b = std::make_unique<nstd::bitset<N>>();
+  for (std::size_t i = 0; i < N; i += 3) {
+    b->set(i);
+  }
+
+  constexpr std::size_t words = (N + 63) / 64;
+  std::size_t iters = bench::iters_for(words);
+  double lhs = bench::ns_per_op(iters, [&] {
+    *b <<= 67;
+    bench::do_not_optimize(*b);
+  });
+  double rhs = bench::ns_per_op(iters, [&] {
+    *b >>= 67;
+    bench::do_not_optimize(*b);
+  });
+  std::printf("%10zu %8zu %12.1f %12.1f %10.3f\n", N, words, lhs, rhs,
+              lhs / static_cast<double>(words));
+}
+
+int main() {
+  std::printf("%10s %8s %12s %12s %10s\n", "bits", "words", "<<= (ns)",
+              ">>= (ns)", "ns/word");
+  run<1 << 10>();
+  run<1 << 12>();
+  run<1 << 14>();
+  run<1 << 16>();
+  run<1 << 18>();
+  run<1 << 20>();
+  run<(1 << 20) + 37>();
+}
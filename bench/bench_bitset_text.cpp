@@ -0,0 +1,72 @@
+#include "../include/bitset.hpp"
+#include "bench.hpp"
+#include <bitset>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+// Text conversion throughput in MB of '0'/'1' characters per second:
+// to_string, the string constructor and the stream operators, against
+// std::bitset doing the same.
+
+template <std::size_t N> static void run() {
+  auto a = std::make_unique<nstd::bitset<N>>();
+  auto ra = std::make_unique<std::bitset<N>>();
+  std::mt19937_64 gen(5);
+  for (std::size_t i = 0; i < N; i++) {
+    bool bit = gen() & 1;
+    a->set(i, bit);
+    ra->set(i, bit);
+  }
+  std::string text = a->to_string();
+  std::size_t iters = bench::iters_for(N / 64, 1 << 22);
+  auto mbps = [](double ns) { return N / ns * 1e3; };
+
+  double fmt = bench::ns_per_op(iters, [&] {
+    bench::do_not_optimize(a->to_string());
+  });
+  double std_fmt = bench::ns_per_op(iters, [&] {
+    bench::do_not_optimize(ra->to_string());
+  });
+  double parse = bench::ns_per_op(iters, [&] {
+    *a = nstd::bitset<N>(text);
+    bench::do_not_optimize(*a);
+  });
+  double std_parse = bench::ns_per_op(iters, [&] {
+    *ra = std::bitset<N>(text);
+    bench::do_not_optimize(*ra);
+  });
+  double out = bench::ns_per_op(iters, [&] {
+    std::ostringstream os;
+    os << *a;
+    bench::do_not_optimize(os);
+  });
+  double std_out = bench::ns_per_op(iters, [&] {
+    std::ostringstream os;
+    os << *ra;
+    bench::do_not_optimize(os);
+  });
+  double in = bench::ns_per_op(iters, [&] {
+    std::istringstream is(text);
+    is >> *a;
+    bench::do_not_optimize(*a);
+  });
+  double std_in = bench::ns_per_op(iters, [&] {
+    std::istringstream is(text);
+    is >> *ra;
+    bench::do_not_optimize(*ra);
+  });
+
+  std::printf("%9zu %9.0f %9.0f %9.0f %9.0f %9.0f %9.0f %9.0f %9.0f\n", N,
+              mbps(fmt), mbps(std_fmt), mbps(parse), mbps(std_parse),
+              mbps(out), mbps(std_out), mbps(in), mbps(std_in));
+}
+
+int main() {
+  std::printf("%9s %9s %9s %9s %9s %9s %9s %9s %9s\n", "bits", "to_str",
+              "std", "parse", "std", "<<", "std", ">>", "std");
+  run<256>();
+  run<4096>();
+  run<1 << 20>();
+}
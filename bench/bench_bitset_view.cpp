@@ -0,0 +1,66 @@
+#include "../include/bitset_view.hpp"
+#include "../include/dynamic_bitset.hpp"
+#include "bench.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Persisting a 32 MiB bitmap as to_string() text, against copying the binary
+// file with from_bytes() and opening it in place under a bitset_view.
+
+static double ms_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+int main() {
+  constexpr std::size_t n = std::size_t{1} << 28;
+  nstd::dynamic_bitset<> b(n);
+  std::mt19937_64 gen(1);
+  for (std::size_t i = 0; i < n; i += 1 + gen() % 64)
+    b.set(i);
+
+  char path[] = "/tmp/nstd_bench_viewXXXXXX";
+  int fd = mkstemp(path);
+  auto bytes = b.as_bytes();
+  if (fd < 0 || write(fd, bytes.data(), bytes.size()) !=
+                    static_cast<ssize_t>(bytes.size())) {
+    std::perror("write");
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::string text = b.to_string();
+  double format_ms = ms_since(start);
+  bench::do_not_optimize(text);
+
+  void* map = mmap(nullptr, bytes.size(), PROT_READ, MAP_PRIVATE, fd, 0);
+  start = std::chrono::steady_clock::now();
+  auto copy = nstd::dynamic_bitset<>::from_bytes(
+      {static_cast<const std::byte*>(map), bytes.size()}, n);
+  double copy_ms = ms_since(start);
+
+  start = std::chrono::steady_clock::now();
+  nstd::bitset_view view({static_cast<const std::byte*>(map), bytes.size()},
+                         n);
+  double view_us = ms_since(start) * 1000;
+  bench::do_not_optimize(view);
+
+  std::printf("%zu MiB: to_string %.1f ms (8x the bytes), from_bytes "
+              "%.1f ms, view open %.2f us\n",
+              bytes.size() >> 20, format_ms, copy_ms, view_us);
+  std::printf("view count %zu, copy count %zu\n", view.count(),
+              copy.count());
+  munmap(map, bytes.size());
+  close(fd);
+  std::remove(path);
+}
+#else
+int main() { std::puts("bench_bitset_view needs mmap"); }
+#endif
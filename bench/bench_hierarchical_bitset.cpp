@@ -0,0 +1,62 @@
+#include "../include/hierarchical_bitset.hpp"
+#include "bench.hpp"
+#include <memory>
+#include <random>
+
+// find_first/find_next on a 16 Mbit mask against the flat bitset scan, and
+// an ID allocator loop: take the lowest free slot and release a random one.
+
+constexpr std::size_t n = std::size_t{1} << 24;
+
+int main() {
+  // a single set bit at the far end: the flat scan reads every word
+  auto h = std::make_unique<nstd::hierarchical_bitset<n>>();
+  auto flat = std::make_unique<nstd::bitset<n, std::uint64_t>>();
+  h->set(n - 1);
+  flat->set(n - 1);
+  double flat_first = bench::ns_per_op(
+      1 << 10, [&] { bench::do_not_optimize(flat->find_first()); });
+  double hier_first = bench::ns_per_op(
+      1 << 20, [&] { bench::do_not_optimize(h->find_first()); });
+  std::printf("find_first, last bit only: flat %.1f ns, hierarchical %.1f ns\n",
+              flat_first, hier_first);
+
+  std::printf("%10s %16s %16s\n", "set bits", "flat ns/bit", "hier ns/bit");
+  for (std::size_t ones : {16, 1024, 65536}) {
+    h->reset();
+    std::mt19937_64 gen(ones);
+    for (std::size_t k = 0; k < ones; k++)
+      h->set(gen() % n);
+    *flat = h->bits();
+    double flat_walk = bench::ns_per_op(8, [&] {
+      std::size_t sum = 0;
+      for (auto i = flat->find_first(); i != flat->npos; i = flat->find_next(i))
+        sum += i;
+      bench::do_not_optimize(sum);
+    });
+    double hier_walk = bench::ns_per_op(8, [&] {
+      std::size_t sum = 0;
+      for (auto i = h->find_first(); i != h->npos; i = h->find_next(i))
+        sum += i;
+      bench::do_not_optimize(sum);
+    });
+    std::size_t count = h->count();
+    std::printf("%10zu %16.1f %16.1f\n", count, flat_walk / count,
+                hier_walk / count);
+  }
+
+  // 1M slots, 1000 of them free at any time
+  constexpr std::size_t slots = std::size_t{1} << 20;
+  auto pool = std::make_unique<nstd::hierarchical_bitset<slots>>();
+  std::mt19937_64 gen(7);
+  for (int k = 0; k < 1000; k++)
+    pool->set(gen() % slots);
+  double alloc = bench::ns_per_op(1 << 22, [&] {
+    std::size_t slot = pool->find_first();
+    pool->reset(slot);
+    pool->set(gen() % slots);
+    bench::do_not_optimize(slot);
+  });
+  std::printf("allocator take + release: %.1f ns, %.1fM ops/s\n", alloc,
+              1e3 / alloc);
+}
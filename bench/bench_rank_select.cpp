@@ -0,0 +1,75 @@
+#include "../include/dynamic_bitset.hpp"
+#include "../include/rank_select.hpp"
+#include "bench.hpp"
+#include <random>
+#include <vector>
+
+// rank1/select1 through the directory against the linear prefix scan
+// (popcount of every block before the query position).
+
+static std::size_t scan_rank(const nstd::dynamic_bitset<>& b, std::size_t pos) {
+  auto words = b.blocks();
+  std::size_t rank = 0;
+  for (std::size_t w = 0; w < pos / 64; w++)
+    rank += std::popcount(words[w]);
+  if (pos % 64)
+    rank += std::popcount(words[pos / 64] & ((std::size_t{1} << (pos % 64)) - 1));
+  return rank;
+}
+
+static std::size_t scan_select(const nstd::dynamic_bitset<>& b, std::size_t k) {
+  auto words = b.blocks();
+  for (std::size_t w = 0; w < words.size(); w++) {
+    std::size_t ones = std::popcount(words[w]);
+    if (k < ones) {
+      std::size_t word = words[w];
+      for (std::size_t i = 0; i < k; i++)
+        word &= word - 1;
+      return w * 64 + std::countr_zero(word);
+    }
+    k -= ones;
+  }
+  return nstd::detail::npos;
+}
+
+int main() {
+  std::mt19937_64 gen(1);
+  std::printf("%12s %8s %10s %12s %12s %12s %12s\n", "bits", "density",
+              "overhead", "rank (ns)", "scan (ns)", "select (ns)", "scan (ns)");
+  for (std::size_t bits : {std::size_t{1} << 20, std::size_t{1} << 24,
+                           std::size_t{1} << 28}) {
+    for (double density : {0.01, 0.5}) {
+      nstd::dynamic_bitset<> b(bits);
+      std::bernoulli_distribution coin(density);
+      for (std::size_t i = 0; i < bits; i++)
+        if (coin(gen))
+          b.set(i);
+      nstd::rank_select rs(b);
+
+      std::vector<std::size_t> positions(1024), ks(1024);
+      for (auto& p : positions)
+        p = gen() % bits;
+      for (auto& k : ks)
+        k = gen() % rs.count();
+
+      std::size_t q = 0;
+      double rank = bench::ns_per_op(1 << 20, [&] {
+        bench::do_not_optimize(rs.rank1(positions[q++ % 1024]));
+      });
+      double select = bench::ns_per_op(1 << 20, [&] {
+        bench::do_not_optimize(rs.select1(ks[q++ % 1024]));
+      });
+      std::size_t scan_iters = bench::iters_for(bits / 64, 1 << 24);
+      double rank_scan = bench::ns_per_op(scan_iters, [&] {
+        bench::do_not_optimize(scan_rank(b, positions[q++ % 1024]));
+      });
+      double select_scan = bench::ns_per_op(scan_iters, [&] {
+        bench::do_not_optimize(scan_select(b, ks[q++ % 1024]));
+      });
+      double overhead = 100.0 * static_cast<double>(rs.directory_bytes()) /
+                        static_cast<double>(bits / 8);
+      std::printf("%12zu %8.2f %9.2f%% %12.1f %12.1f %12.1f %12.1f\n", bits,
+                  density, overhead, rank, rank_scan, select, select_scan);
+    }
+  }
+}
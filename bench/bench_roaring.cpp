@@ -0,0 +1,59 @@
+#include "../include/dynamic_bitset.hpp"
+#include "../include/roaring.hpp"
+#include "bench.hpp"
+#include <random>
+
+// Memory and AND/OR cost of roaring_bitmap against a flat dynamic_bitset
+// over the same 2^26-value universe, for sparse, clustered and dense sets.
+
+constexpr std::size_t universe = std::size_t{1} << 26;
+
+struct dataset {
+  const char* name;
+  nstd::roaring_bitmap a, b;
+  nstd::dynamic_bitset<> fa{universe}, fb{universe};
+};
+
+static void add(dataset& d, bool left, std::uint32_t v) {
+  (left ? d.a : d.b).add(v);
+  (left ? d.fa : d.fb).set(v);
+}
+
+int main() {
+  std::mt19937 gen(3);
+  dataset sets[3];
+  sets[0].name = "sparse";
+  sets[1].name = "runs";
+  sets[2].name = "dense";
+  for (int i = 0; i < 2; i++) {
+    for (int k = 0; k < 50000; k++)
+      add(sets[0], i == 0, gen() % universe);
+    for (int k = 0; k < 200; k++) {
+      std::uint32_t start = gen() % (universe - 10000);
+      for (std::uint32_t v = start; v < start + 5000; v++)
+        add(sets[1], i == 0, v);
+    }
+    for (std::size_t v = 0; v < universe; v++)
+      if (gen() % 2 == 0)
+        add(sets[2], i == 0, static_cast<std::uint32_t>(v));
+  }
+
+  std::printf("%8s %12s %12s %12s %12s %12s %12s\n", "set", "values",
+              "roaring KiB", "flat KiB", "and (us)", "flat and", "or (us)");
+  for (auto& d : sets) {
+    d.a.optimize();
+    d.b.optimize();
+    double r_and = bench::ns_per_op(20, [&] {
+      bench::do_not_optimize((d.a & d.b).cardinality());
+    });
+    double r_or = bench::ns_per_op(20, [&] {
+      bench::do_not_optimize((d.a | d.b).cardinality());
+    });
+    double f_and = bench::ns_per_op(20, [&] {
+      bench::do_not_optimize((d.fa & d.fb).count());
+    });
+    std::printf("%8s %12zu %12zu %12zu %12.1f %12.1f %12.1f\n", d.name,
+                d.a.cardinality(), d.a.memory_bytes() / 1024, universe / 8192,
+                r_and / 1000, f_and / 1000, r_or / 1000);
+  }
+}
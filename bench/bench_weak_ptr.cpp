@@ -0,0 +1,53 @@
+#include "../include/memory.hpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// weak_ptr::lock() throughput from 1 up to hardware_concurrency threads, all
+// locking one shared object, against std::weak_ptr. Each lock takes and
+// drops a strong reference, so every thread hits the same count with a
+// compare-exchange and a decrement; the single-thread row is the cost of
+// the pair uncontended.
+
+constexpr std::size_t ops = 1 << 20;
+
+template <class F> static double mops(std::size_t threads, F&& worker) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (std::size_t t = 0; t < threads; t++)
+    pool.emplace_back(worker);
+  for (auto& th : pool)
+    th.join();
+  std::chrono::duration<double, std::micro> us =
+      std::chrono::steady_clock::now() - start;
+  return static_cast<double>(threads * ops) / us.count();
+}
+
+int main() {
+  std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::printf("%8s %14s %14s\n", "threads", "nstd Mop/s", "std Mop/s");
+  for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+    auto p = nstd::make_shared<int>(1);
+    nstd::weak_ptr<int> w(p);
+    double ours = mops(threads, [&] {
+      for (std::size_t k = 0; k < ops; k++)
+        bench::do_not_optimize(*w.lock());
+    });
+
+    auto sp = std::make_shared<int>(1);
+    std::weak_ptr<int> sw(sp);
+    double theirs = mops(threads, [&] {
+      for (std::size_t k = 0; k < ops; k++)
+        bench::do_not_optimize(*sw.lock());
+    });
+    std::printf("%8zu %14.1f %14.1f\n", threads, ours, theirs);
+  }
+
+  // lock() on an expired pointer is one load, no write
+  nstd::weak_ptr<int> gone(nstd::make_shared<int>(1));
+  double expired = bench::ns_per_op(
+      ops, [&] { bench::do_not_optimize(gone.lock().get()); });
+  std::printf("expired lock: %.1f ns\n", expired);
+}
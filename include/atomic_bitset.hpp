@@ -0,0 +1,192 @@
+#pragma once
+
+#include "bitset.hpp"
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <stdexcept>
+
+namespace nstd {
+
+// Fixed-size bitset whose blocks are std::atomic words, for free-slot maps
+// shared between threads. Single-bit updates are one atomic RMW on the
+// owning block and never block; there is no lock anywhere.
+//
+// claim_first_zero() finds a clear bit with countr_zero and sets it with a
+// CAS on that block, retrying only when another thread changed the same
+// block in between. Maps longer than a 64-byte line start on one, and a
+// line holds 512 bits, so threads stay off each other's lines only when
+// their hints are 512 bits apart or more. Without a hint each thread starts
+// at a line of its own, scattered over the map; a map shorter than one line
+// per thread is shared however the claims are spread.
+//
+// The bulk readers (count, any, find_first, snapshot, ...) load each block
+// with memory_order_relaxed. Each block is read atomically, but the result
+// is not a snapshot of the whole set while writers are running.
+template <std::size_t N> class atomic_bitset {
+  // same blocks as bitset<N>, so small maps stay small
+  using block_t = typename bitset<N>::block_type;
+  constexpr static std::size_t block_t_bitsize = detail::block_bits<block_t>;
+  constexpr static std::size_t num_blocks =
+      (N + block_t_bitsize - 1) / block_t_bitsize;
+
+public:
+  constexpr static std::size_t npos = detail::npos;
+
+  atomic_bitset() noexcept = default;
+
+  // stores the bits of init; not atomic with respect to other threads
+  explicit atomic_bitset(const bitset<N>& init) noexcept {
+    for (std::size_t i = 0; i < num_blocks; i++)
+      data[i].store(init.data[i], std::memory_order_relaxed);
+  }
+
+  atomic_bitset(const atomic_bitset&) = delete;
+  atomic_bitset& operator=(const atomic_bitset&) = delete;
+
+  constexpr std::size_t size() const noexcept { return N; }
+
+  bool test(std::size_t pos,
+            std::memory_order order = std::memory_order_seq_cst) const {
+    check(pos, "Attempted to test bit out of range");
+    block_t word = data[pos / block_t_bitsize].load(order);
+    return (word >> (pos % block_t_bitsize)) & 1;
+  }
+
+  // sets the bit and returns its previous value
+  bool test_and_set(std::size_t pos,
+                    std::memory_order order = std::memory_order_seq_cst) {
+    check(pos, "Attempted to set bit out of range");
+    block_t bit = bit_of(pos);
+    return (data[pos / block_t_bitsize].fetch_or(bit, order) & bit) != 0;
+  }
+
+  // clears the bit and returns its previous value
+  bool fetch_reset(std::size_t pos,
+                   std::memory_order order = std::memory_order_seq_cst) {
+    check(pos, "Attempted to reset bit out of range");
+    block_t bit = bit_of(pos);
+    return (data[pos / block_t_bitsize].fetch_and(static_cast<block_t>(~bit),
+                                                  order) &
+            bit) != 0;
+  }
+
+  // flips the bit and returns its previous value
+  bool fetch_flip(std::size_t pos,
+                  std::memory_order order = std::memory_order_seq_cst) {
+    check(pos, "Attempted to flip bit out of range");
+    block_t bit = bit_of(pos);
+    return (data[pos / block_t_bitsize].fetch_xor(bit, order) & bit) != 0;
+  }
+
+  // Atomically sets one clear bit and returns its index, or npos if every
+  // bit was set when its block was looked at. The search starts at the
+  // block holding hint, or at the calling thread's own line when hint is
+  // npos or out of range, and wraps around. Pass 0 for the lowest clear bit.
+  std::size_t claim_first_zero(
+      std::size_t hint = npos,
+      std::memory_order order = std::memory_order_acq_rel) noexcept {
+    std::size_t start =
+        hint < N ? hint / block_t_bitsize : thread_start_block();
+    for (std::size_t k = 0; k < num_blocks; k++) {
+      std::size_t i =
+          start + k < num_blocks ? start + k : start + k - num_blocks;
+      block_t mask = i == num_blocks - 1 ? last_block_mask
+                                         : detail::all_ones<block_t>;
+      block_t word = data[i].load(std::memory_order_relaxed);
+      while (auto free = static_cast<block_t>(~word & mask)) {
+        auto bit = static_cast<block_t>(free & -free);
+        // on failure word is reloaded and the next clear bit is tried
+        if (data[i].compare_exchange_weak(
+                word, static_cast<block_t>(word | bit), order,
+                std::memory_order_relaxed))
+          return i * block_t_bitsize +
+                 static_cast<std::size_t>(std::countr_zero(bit));
+      }
+    }
+    return npos;
+  }
+
+  // clears every bit; each block is stored separately
+  void reset(std::memory_order order = std::memory_order_seq_cst) noexcept {
+    for (auto& block : data)
+      block.store(0, order);
+  }
+
+  // relaxed bulk readers
+
+  std::size_t count() const noexcept {
+    std::size_t sum = 0;
+    for (const auto& block : data)
+      sum += std::popcount(block.load(std::memory_order_relaxed));
+    return sum;
+  }
+
+  bool any() const noexcept {
+    for (const auto& block : data)
+      if (block.load(std::memory_order_relaxed))
+        return true;
+    return false;
+  }
+
+  bool none() const noexcept { return !any(); }
+
+  bool all() const noexcept { return count() == N; }
+
+  std::size_t find_first() const noexcept {
+    for (std::size_t i = 0; i < num_blocks; i++) {
+      if (block_t word = data[i].load(std::memory_order_relaxed))
+        return i * block_t_bitsize +
+               static_cast<std::size_t>(std::countr_zero(word));
+    }
+    return npos;
+  }
+
+  bitset<N> snapshot() const noexcept {
+    bitset<N> ret;
+    for (std::size_t i = 0; i < num_blocks; i++)
+      ret.data[i] = data[i].load(std::memory_order_relaxed);
+    return ret;
+  }
+
+private:
+  constexpr static block_t last_block_mask =
+      N % block_t_bitsize == 0
+          ? detail::all_ones<block_t>
+          : static_cast<block_t>(
+                (static_cast<block_t>(1) << (N % block_t_bitsize)) - 1);
+
+  constexpr static std::size_t line_bytes = 64;
+  constexpr static std::size_t blocks_per_line =
+      line_bytes / sizeof(block_t);
+  constexpr static std::size_t num_lines =
+      (num_blocks + blocks_per_line - 1) / blocks_per_line;
+
+  // maps under a line keep their natural alignment and size
+  alignas(num_lines > 1 ? line_bytes : alignof(std::atomic<block_t>))
+      std::atomic<block_t> data[num_blocks]{};
+
+  // The first block of the line this thread starts claiming from. Threads
+  // are numbered in the order they first ask, and the number is multiplied
+  // by an odd constant so that neighbours land far apart and a thread that
+  // fills its line does not run straight into the next one's.
+  static std::size_t thread_start_block() noexcept {
+    static std::atomic<std::size_t> next_thread{0};
+    thread_local std::size_t line =
+        next_thread.fetch_add(1, std::memory_order_relaxed) * 0x9e3779b9u %
+        num_lines;
+    return line * blocks_per_line;
+  }
+
+  static void check(std::size_t pos, const char* what) {
+    if (pos >= N)
+      throw std::out_of_range{what};
+  }
+
+  static block_t bit_of(std::size_t pos) noexcept {
+    return static_cast<block_t>(static_cast<block_t>(1)
+                                << (pos % block_t_bitsize));
+  }
+};
+
+} // namespace nstd
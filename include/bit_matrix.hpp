@@ -0,0 +1,221 @@
+#pragma once
+
+#include "bitset.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace nstd {
+
+namespace detail {
+
+// Transposes a 64x64 bit block in place, bit c of m[r] trading places with
+// bit r of m[c]. Each round swaps the off-diagonal quadrants of every j x j
+// sub-block, halving j from 32 to 1, so the whole block takes 6 * 32 masked
+// exchanges instead of 4096 single-bit moves.
+constexpr void transpose64(std::uint64_t* m) noexcept {
+  std::uint64_t mask = 0x00000000ffffffffULL;
+  for (std::size_t j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+    for (std::size_t k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+      std::uint64_t t = ((m[k] >> j) ^ m[k | j]) & mask;
+      m[k] ^= t << j;
+      m[k | j] ^= t;
+    }
+  }
+}
+
+} // namespace detail
+
+// R x C boolean matrix stored row-major, each row a bitset<C, uint64_t>, so
+// the rows form one contiguous run of words. Row access is free; whole-matrix
+// &=, |= and ^= are single calls to the bitset word kernels over that run.
+//
+// Column access costs a bit test per row. For many column queries take
+// transpose() once, which rearranges 64x64 tiles with detail::transpose64,
+// and read the columns as rows of the result.
+//
+// The matrices live inline like bitset, so large ones belong on the heap.
+template <std::size_t R, std::size_t C> class bit_matrix {
+  static_assert(R > 0 && C > 0, "bit_matrix needs at least one row and column");
+
+  using word = std::uint64_t;
+  constexpr static std::size_t word_bits = 64;
+  constexpr static std::size_t row_words = (C + word_bits - 1) / word_bits;
+
+public:
+  using row_type = bitset<C, word>;
+
+  bit_matrix() noexcept = default;
+
+  constexpr std::size_t rows() const noexcept { return R; }
+  constexpr std::size_t cols() const noexcept { return C; }
+
+  // row i, unchecked like bitset::operator[]
+  row_type& operator[](std::size_t i) noexcept { return rows_[i]; }
+  const row_type& operator[](std::size_t i) const noexcept { return rows_[i]; }
+
+  bool operator()(std::size_t i, std::size_t j) const noexcept {
+    return rows_[i][j];
+  }
+
+  bool test(std::size_t i, std::size_t j) const {
+    check(i, j);
+    return rows_[i][j];
+  }
+
+  bit_matrix& set(std::size_t i, std::size_t j, bool val = true) {
+    check(i, j);
+    rows_[i].set(j, val);
+    return *this;
+  }
+
+  bit_matrix& reset(std::size_t i, std::size_t j) {
+    check(i, j);
+    rows_[i].reset(j);
+    return *this;
+  }
+
+  bit_matrix& reset() noexcept {
+    std::fill_n(words(), R * row_words, word{0});
+    return *this;
+  }
+
+  // column j as a bitset, one bit test per row
+  bitset<R, word> column(std::size_t j) const {
+    if (j >= C)
+      throw std::out_of_range{"column out of range"};
+    bitset<R, word> ret;
+    for (std::size_t i = 0; i < R; i++)
+      ret.data[i / word_bits] |= static_cast<word>(rows_[i][j])
+                                 << (i % word_bits);
+    return ret;
+  }
+
+  std::size_t count() const noexcept {
+    return detail::block_count(words(), R * row_words);
+  }
+
+  bool any() const noexcept {
+    return detail::block_any(words(), R * row_words);
+  }
+
+  bool none() const noexcept { return !any(); }
+
+  bit_matrix& operator&=(const bit_matrix& rhs) noexcept {
+    detail::block_and(words(), rhs.words(), R * row_words);
+    return *this;
+  }
+
+  bit_matrix& operator|=(const bit_matrix& rhs) noexcept {
+    detail::block_or(words(), rhs.words(), R * row_words);
+    return *this;
+  }
+
+  bit_matrix& operator^=(const bit_matrix& rhs) noexcept {
+    detail::block_xor(words(), rhs.words(), R * row_words);
+    return *this;
+  }
+
+  bool operator==(const bit_matrix& rhs) const noexcept {
+    return detail::block_equal(words(), rhs.words(), R * row_words);
+  }
+
+  // The C x R matrix with bit (j, i) = bit (i, j). Tiles past the last row
+  // or column are zero-padded, which the zero bits above C already are.
+  bit_matrix<C, R> transpose() const noexcept {
+    bit_matrix<C, R> ret;
+    word tile[word_bits];
+    for (std::size_t bi = 0; bi < R; bi += word_bits) {
+      std::size_t h = std::min(word_bits, R - bi);
+      for (std::size_t bj = 0; bj < C; bj += word_bits) {
+        std::size_t w = std::min(word_bits, C - bj);
+        for (std::size_t r = 0; r < h; r++)
+          tile[r] = rows_[bi + r].data[bj / word_bits];
+        std::fill(tile + h, tile + word_bits, word{0});
+        detail::transpose64(tile);
+        for (std::size_t c = 0; c < w; c++)
+          ret.rows_[bj + c].data[bi / word_bits] = tile[c];
+      }
+    }
+    return ret;
+  }
+
+  template <std::size_t, std::size_t> friend class bit_matrix;
+
+  template <std::size_t M, std::size_t K, std::size_t N>
+  friend bit_matrix<M, N> operator*(const bit_matrix<M, K>& a,
+                                    const bit_matrix<K, N>& b);
+
+private:
+  std::array<row_type, R> rows_{};
+
+  // the rows are their words back to back, as in bitset_distance.hpp
+  static_assert(sizeof(row_type) == row_words * sizeof(word));
+
+  word* words() noexcept { return rows_[0].data; }
+  const word* words() const noexcept { return rows_[0].data; }
+
+  static void check(std::size_t i, std::size_t j) {
+    if (i >= R || j >= C)
+      throw std::out_of_range{"matrix position out of range"};
+  }
+};
+
+template <std::size_t R, std::size_t C>
+bit_matrix<R, C> operator&(bit_matrix<R, C> lhs,
+                           const bit_matrix<R, C>& rhs) noexcept {
+  return lhs &= rhs;
+}
+
+template <std::size_t R, std::size_t C>
+bit_matrix<R, C> operator|(bit_matrix<R, C> lhs,
+                           const bit_matrix<R, C>& rhs) noexcept {
+  return lhs |= rhs;
+}
+
+template <std::size_t R, std::size_t C>
+bit_matrix<R, C> operator^(bit_matrix<R, C> lhs,
+                           const bit_matrix<R, C>& rhs) noexcept {
+  return lhs ^= rhs;
+}
+
+// Boolean product over (or, and): row i of a * b is the OR of the rows k of
+// b for which a(i, k) is set. A sparse a takes exactly that, one row OR per
+// set bit. A dense one uses the Four Russians method: for each group of
+// eight rows of b the ORs of all 256 subsets go in a table, and each row of
+// a then takes one table OR per byte. The cheaper of the two row-OR counts,
+// count() against K / 8 * (256 + M), picks the method.
+template <std::size_t M, std::size_t K, std::size_t N>
+bit_matrix<M, N> operator*(const bit_matrix<M, K>& a,
+                           const bit_matrix<K, N>& b) {
+  using word = std::uint64_t;
+  bit_matrix<M, N> ret;
+  if (a.count() <= (K + 7) / 8 * (256 + M)) {
+    for (std::size_t i = 0; i < M; i++) {
+      for (std::size_t k : a.rows_[i].set_bits())
+        ret.rows_[i] |= b.rows_[k];
+    }
+  } else {
+    auto table = std::make_unique<bitset<N, word>[]>(256);
+    for (std::size_t g = 0; g < K; g += 8) {
+      std::size_t group = std::min<std::size_t>(8, K - g);
+      // each subset is a smaller subset plus its lowest row
+      for (std::size_t s = 1; s < (std::size_t{1} << group); s++) {
+        table[s] = table[s & (s - 1)];
+        table[s] |= b.rows_[g + static_cast<std::size_t>(std::countr_zero(s))];
+      }
+      for (std::size_t i = 0; i < M; i++) {
+        auto byte = (a.rows_[i].blocks()[g / 64] >> (g % 64)) & 0xff;
+        if (byte)
+          ret.rows_[i] |= table[byte];
+      }
+    }
+  }
+  return ret;
+}
+
+} // namespace nstd
@@ -1,25 +1,801 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
+#include <climits>
+#include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <ios>
-#include <iosfwd>
+#include <istream>
+#include <iterator>
 #include <limits>
+#include <ostream>
 #include <ranges>
+#include <span>
 #include <stdexcept>
+#include <streambuf>
 #include <string>
+#include <type_traits>
+#include <utility>
+
+#include "simd.hpp"
 
 namespace nstd {
 
-template <std::size_t N> class bitset {
+namespace detail {
+
+// smallest unsigned type that holds N bits, up to a full std::size_t
+template <std::size_t N>
+using default_block_t = std::conditional_t<
+    N <= 8, std::uint8_t,
+    std::conditional_t<N <= 16, std::uint16_t,
+                       std::conditional_t<N <= 32, std::uint32_t, std::size_t>>>;
+
+} // namespace detail
+
+template <std::size_t N, class Block = detail::default_block_t<N>>
+class bitset;
+template <std::size_t N> class atomic_bitset;
+template <std::size_t R, std::size_t C> class bit_matrix;
+// primary template, as in functional.hpp
+template <class T> struct hash;
+
+namespace detail {
+// mutable block access for the free bulk operations in bitset_parallel.hpp
+struct block_access;
+} // namespace detail
+template <class Block, class Allocator> class dynamic_bitset;
+
+namespace detail {
+
+// A block is any unsigned integer type, including unsigned __int128 where the
+// compiler has it. std::popcount and friends and std::numeric_limits do not
+// accept __int128 in strict mode, so the kernels below count bits through
+// these helpers instead.
+
+template <class Block>
+inline constexpr std::size_t block_bits = CHAR_BIT * sizeof(Block);
+
+template <class Block>
+inline constexpr Block all_ones = static_cast<Block>(~Block{0});
+
+template <class Block> constexpr int bit_popcount(Block w) noexcept {
+  if constexpr (sizeof(Block) > sizeof(std::uint64_t)) {
+    return std::popcount(static_cast<std::uint64_t>(w)) +
+           std::popcount(static_cast<std::uint64_t>(w >> 64));
+  } else {
+    return std::popcount(w);
+  }
+}
+
+template <class Block> constexpr int bit_countr_zero(Block w) noexcept {
+  if constexpr (sizeof(Block) > sizeof(std::uint64_t)) {
+    auto low = static_cast<std::uint64_t>(w);
+    return low ? std::countr_zero(low)
+               : 64 + std::countr_zero(static_cast<std::uint64_t>(w >> 64));
+  } else {
+    return std::countr_zero(w);
+  }
+}
+
+template <class Block> constexpr int bit_countl_zero(Block w) noexcept {
+  if constexpr (sizeof(Block) > sizeof(std::uint64_t)) {
+    auto high = static_cast<std::uint64_t>(w >> 64);
+    return high ? std::countl_zero(high)
+                : 64 + std::countl_zero(static_cast<std::uint64_t>(w));
+  } else {
+    return std::countl_zero(w);
+  }
+}
+
+// Word-level kernels over a block array in which bit i lives at position
+// i % digits of block i / digits. Bits shifted past the last block are
+// dropped, so callers with a partial last block must mask it afterwards.
+
+template <class Block>
+constexpr void shift_left(Block* data, std::size_t n,
+                          std::size_t pos) noexcept {
+  constexpr std::size_t bits = block_bits<Block>;
+  const std::size_t words = pos / bits;
+  const std::size_t offset = pos % bits;
+  if (words >= n) {
+    std::fill_n(data, n, Block{0});
+    return;
+  }
+
+  if (offset == 0) {
+    std::copy_backward(data, data + n - words, data + n);
+  } else {
+    // carry the high bits of each source word into its upper neighbour
+    for (std::size_t i = n - 1; i > words; i--) {
+      data[i] = static_cast<Block>(data[i - words] << offset) |
+                static_cast<Block>(data[i - words - 1] >> (bits - offset));
+    }
+    data[words] = static_cast<Block>(data[0] << offset);
+  }
+  std::fill_n(data, words, Block{0});
+}
+
+template <class Block>
+constexpr void shift_right(Block* data, std::size_t n,
+                           std::size_t pos) noexcept {
+  constexpr std::size_t bits = block_bits<Block>;
+  const std::size_t words = pos / bits;
+  const std::size_t offset = pos % bits;
+  if (words >= n) {
+    std::fill_n(data, n, Block{0});
+    return;
+  }
+
+  if (offset == 0) {
+    std::copy(data + words, data + n, data);
+  } else {
+    // carry the low bits of each source word into its lower neighbour
+    for (std::size_t i = 0; i + words + 1 < n; i++) {
+      data[i] = static_cast<Block>(data[i + words] >> offset) |
+                static_cast<Block>(data[i + words + 1] << (bits - offset));
+    }
+    data[n - words - 1] = static_cast<Block>(data[n - 1] >> offset);
+  }
+  std::fill_n(data + n - words, words, Block{0});
+}
+
+// Applies op(block, mask) to every block overlapping bits [first, last),
+// where mask selects the bits of that block inside the range. Only the two
+// edge blocks get a partial mask.
+template <class Block, class Op>
+constexpr void block_range(Block* data, std::size_t first, std::size_t last,
+                 Op op) noexcept {
+  if (first >= last)
+    return;
+  constexpr std::size_t bits = block_bits<Block>;
+  const std::size_t lo = first / bits, hi = (last - 1) / bits;
+  auto lo_mask = static_cast<Block>(all_ones<Block> << (first % bits));
+  auto hi_mask =
+      static_cast<Block>(all_ones<Block> >> (bits - 1 - (last - 1) % bits));
+  if (lo == hi) {
+    op(data[lo], static_cast<Block>(lo_mask & hi_mask));
+    return;
+  }
+  op(data[lo], lo_mask);
+  for (std::size_t i = lo + 1; i < hi; i++) {
+    op(data[i], all_ones<Block>);
+  }
+  op(data[hi], hi_mask);
+}
+
+template <class Block>
+constexpr void set_range(Block* data, std::size_t first,
+                         std::size_t last) noexcept {
+  block_range(data, first, last, [](Block& b, Block m) { b |= m; });
+}
+
+template <class Block>
+constexpr void reset_range(Block* data, std::size_t first,
+                           std::size_t last) noexcept {
+  block_range(data, first, last,
+              [](Block& b, Block m) { b &= static_cast<Block>(~m); });
+}
+
+template <class Block>
+constexpr void flip_range(Block* data, std::size_t first,
+                          std::size_t last) noexcept {
+  block_range(data, first, last, [](Block& b, Block m) { b ^= m; });
+}
+
+// low width bits set, for width in [0, 64]
+constexpr std::uint64_t low_bits(std::size_t width) noexcept {
+  return width >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << width) - 1;
+}
+
+// Bits [pos, pos + width) as an integer, bit pos lowest; width <= 64. With
+// 64-bit blocks the field spans at most two of them.
+template <class Block>
+constexpr std::uint64_t load_field(const Block* data, std::size_t pos,
+                         std::size_t width) noexcept {
+  constexpr std::size_t bits = block_bits<Block>;
+  std::uint64_t ret = 0;
+  for (std::size_t done = 0; done < width;) {
+    std::size_t offset = (pos + done) % bits;
+    std::size_t take = std::min(bits - offset, width - done);
+    auto chunk = static_cast<std::uint64_t>(data[(pos + done) / bits] >> offset);
+    ret |= (chunk & low_bits(take)) << done;
+    done += take;
+  }
+  return ret;
+}
+
+// overwrites bits [pos, pos + width) with the low width bits of value
+template <class Block>
+constexpr void store_field(Block* data, std::size_t pos, std::size_t width,
+                 std::uint64_t value) noexcept {
+  constexpr std::size_t bits = block_bits<Block>;
+  for (std::size_t done = 0; done < width;) {
+    std::size_t offset = (pos + done) % bits;
+    std::size_t take = std::min(bits - offset, width - done);
+    auto mask = static_cast<Block>(static_cast<Block>(low_bits(take))
+                                   << offset);
+    auto chunk = static_cast<Block>(
+        static_cast<Block>((value >> done) & low_bits(take)) << offset);
+    Block& b = data[(pos + done) / bits];
+    b = static_cast<Block>((b & ~mask) | chunk);
+    done += take;
+  }
+}
+
+// Binary layout shared by bitset, dynamic_bitset and bitset_view: n bits
+// take (n + 7) / 8 bytes, bit i is bit i % 8 of byte i / 8, and the bits
+// past n in the last byte are zero. This is the little-endian byte order of
+// the blocks for every block width, so on a little-endian host the first
+// bytes of the block array already are the serialized form.
+
+inline constexpr std::size_t bytes_for(std::size_t n) noexcept {
+  return (n + 7) / 8;
+}
+
+// Fills zeroed blocks from bytes in the layout above. Throws if the length
+// is wrong for n bits or a bit past n is set.
+template <class Block>
+void load_bytes(std::span<const std::byte> bytes, std::size_t n, Block* out) {
+  if (bytes.size() != bytes_for(n))
+    throw std::invalid_argument{"byte count does not match the bit count"};
+  if (n % 8 && std::to_integer<unsigned>(bytes.back()) >> (n % 8))
+    throw std::invalid_argument{"bits set past the end of the bitset"};
+  if constexpr (std::endian::native == std::endian::little) {
+    if (!bytes.empty())
+      std::memcpy(out, bytes.data(), bytes.size());
+  } else {
+    for (std::size_t i = 0; i < bytes.size(); i++) {
+      out[i / sizeof(Block)] |= static_cast<Block>(
+          static_cast<Block>(std::to_integer<unsigned>(bytes[i]))
+          << (8 * (i % sizeof(Block))));
+    }
+  }
+}
+
+// Bulk operations go through the runtime-dispatched kernels in simd.hpp once
+// the array is long enough to amortize the indirect call; shorter arrays,
+// blocks other than 64-bit words and constant evaluation use the plain loops.
+template <class Block>
+constexpr void block_and(Block* dst, const Block* src, std::size_t n) noexcept {
+  if constexpr (std::is_same_v<Block, simd::word>) {
+    if (!std::is_constant_evaluated() && n >= simd::min_words)
+      return simd::active().bit_and(dst, src, n);
+  }
+  for (std::size_t i = 0; i < n; i++) {
+    dst[i] &= src[i];
+  }
+}
+
+template <class Block>
+constexpr void block_or(Block* dst, const Block* src, std::size_t n) noexcept {
+  if constexpr (std::is_same_v<Block, simd::word>) {
+    if (!std::is_constant_evaluated() && n >= simd::min_words)
+      return simd::active().bit_or(dst, src, n);
+  }
+  for (std::size_t i = 0; i < n; i++) {
+    dst[i] |= src[i];
+  }
+}
+
+template <class Block>
+constexpr void block_xor(Block* dst, const Block* src, std::size_t n) noexcept {
+  if constexpr (std::is_same_v<Block, simd::word>) {
+    if (!std::is_constant_evaluated() && n >= simd::min_words)
+      return simd::active().bit_xor(dst, src, n);
+  }
+  for (std::size_t i = 0; i < n; i++) {
+    dst[i] ^= src[i];
+  }
+}
+
+template <class Block>
+constexpr void block_flip(Block* dst, std::size_t n) noexcept {
+  if constexpr (std::is_same_v<Block, simd::word>) {
+    if (!std::is_constant_evaluated() && n >= simd::min_words)
+      return simd::active().bit_not(dst, n);
+  }
+  for (std::size_t i = 0; i < n; i++) {
+    dst[i] = static_cast<Block>(~dst[i]);
+  }
+}
+
+template <class Block>
+constexpr std::size_t block_count(const Block* src, std::size_t n) noexcept {
+  if constexpr (std::is_same_v<Block, simd::word>) {
+    if (!std::is_constant_evaluated() && n >= simd::min_words)
+      return simd::active().count(src, n);
+  }
+  std::size_t sum = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    sum += bit_popcount(src[i]);
+  }
+  return sum;
+}
+
+template <class Block>
+constexpr bool block_any(const Block* src, std::size_t n) noexcept {
+  if constexpr (std::is_same_v<Block, simd::word>) {
+    if (!std::is_constant_evaluated() && n >= simd::min_words)
+      return simd::active().any(src, n);
+  }
+  for (std::size_t i = 0; i < n; i++) {
+    if (src[i])
+      return true;
+  }
+  return false;
+}
+
+// true if all n blocks have every bit set
+template <class Block>
+constexpr bool block_all(const Block* src, std::size_t n) noexcept {
+  if constexpr (std::is_same_v<Block, simd::word>) {
+    if (!std::is_constant_evaluated() && n >= simd::min_words)
+      return simd::active().all(src, n);
+  }
+  for (std::size_t i = 0; i < n; i++) {
+    if (src[i] != all_ones<Block>)
+      return false;
+  }
+  return true;
+}
+
+template <class Block>
+constexpr bool block_equal(const Block* lhs, const Block* rhs,
+                           std::size_t n) noexcept {
+  if constexpr (std::is_same_v<Block, simd::word>) {
+    if (!std::is_constant_evaluated() && n >= simd::min_words)
+      return simd::active().equal(lhs, rhs, n);
+  }
+  for (std::size_t i = 0; i < n; i++) {
+    if (lhs[i] != rhs[i])
+      return false;
+  }
+  return true;
+}
+
+// murmur3's fmix64
+constexpr std::uint64_t mix64(std::uint64_t h) noexcept {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  return h ^ (h >> 33);
+}
+
+// the 128-bit product of a and b, high half xor low half
+constexpr std::uint64_t mul_fold(std::uint64_t a, std::uint64_t b) noexcept {
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 p = static_cast<unsigned __int128>(a) * b;
+  return static_cast<std::uint64_t>(p) ^ static_cast<std::uint64_t>(p >> 64);
+#else
+  std::uint64_t a_lo = a & 0xffffffffU, a_hi = a >> 32;
+  std::uint64_t b_lo = b & 0xffffffffU, b_hi = b >> 32;
+  std::uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo;
+  std::uint64_t mid = (ll >> 32) + (lh & 0xffffffffU) + (hl & 0xffffffffU);
+  std::uint64_t hi = a_hi * b_hi + (lh >> 32) + (hl >> 32) + (mid >> 32);
+  return (a * b) ^ hi;
+#endif
+}
+
+// Hash of the first n bits of data, for nstd::hash of bitset and
+// dynamic_bitset. It depends only on n and the words of the binary layout,
+// so equal bits of equal size hash equal whatever the block type. Fewer
+// than simd::hash_lanes words are mixed one after another; longer arrays
+// are accumulated with simd::hash_stripes, a scramble interval at a time,
+// and the tail words go into the lanes one by one.
+template <class Block>
+std::size_t hash_bits(const Block* data, std::size_t n) noexcept {
+  using simd::word;
+  constexpr std::size_t lanes = simd::hash_lanes;
+  constexpr std::size_t chunk = lanes * simd::hash_scramble;
+  const std::size_t words = (n + 63) / 64;
+  auto word_at = [&](std::size_t i) -> word {
+    if constexpr (std::is_same_v<Block, word>) {
+      return data[i];
+    } else {
+      return load_field(data, 64 * i, std::min<std::size_t>(64, n - 64 * i));
+    }
+  };
+
+  word h = n * 0x9e3779b97f4a7c15ULL;
+  if (words < lanes) {
+    for (std::size_t i = 0; i < words; i++)
+      h = std::rotl(h ^ word_at(i) * 0xc2b2ae3d27d4eb4fULL, 31) *
+          0x9e3779b97f4a7c15ULL;
+    return static_cast<std::size_t>(mix64(h));
+  }
+
+  word acc[lanes];
+  for (std::size_t l = 0; l < lanes; l++)
+    acc[l] = simd::hash_scramble_key[l] ^ n;
+  const auto& k = simd::active();
+  std::size_t done = 0;
+  while (words - done >= lanes) {
+    std::size_t len = std::min(chunk, (words - done) / lanes * lanes);
+    if constexpr (std::is_same_v<Block, word>) {
+      k.hash_stripes(acc, data + done, len / lanes);
+    } else {
+      word buf[chunk];
+      for (std::size_t i = 0; i < len; i++)
+        buf[i] = word_at(done + i);
+      k.hash_stripes(acc, buf, len / lanes);
+    }
+    done += len;
+  }
+  for (; done < words; done++)
+    simd::scalar::hash_word(acc, done % lanes, word_at(done));
+  // lanes merge in pairs through independent wide multiplies, so the
+  // finish costs about one mix64 rather than eight chained ones
+  for (std::size_t l = 0; l < lanes; l += 2)
+    h += mul_fold(acc[l] ^ simd::hash_secret[l],
+                  acc[l + 1] ^ simd::hash_secret[l + 1]);
+  return static_cast<std::size_t>(mix64(h));
+}
+
+// Proxy for a single bit, shared by bitset and dynamic_bitset.
+template <class Block> class bit_reference {
 public:
-  class reference;
+  template <std::size_t, class> friend class nstd::bitset;
+  template <class, class> friend class nstd::dynamic_bitset;
+
+  bit_reference() = delete;
+  bit_reference(const bit_reference&) = default;
+  ~bit_reference() = default;
+
+  constexpr bit_reference& operator=(bool x) noexcept {
+    auto bit = static_cast<Block>(static_cast<Block>(1) << bit_idx);
+    if (x) {
+      block |= bit;
+    } else {
+      block &= all_ones<Block> ^ bit;
+    }
+    return *this;
+  };
+
+  // assigns the bit rhs refers to, not the reference itself
+  constexpr bit_reference& operator=(const bit_reference& rhs) noexcept {
+    return *this = static_cast<bool>(rhs);
+  };
+
+  constexpr bool operator~() const noexcept {
+    return !static_cast<bool>(*this);
+  }
+
+  constexpr operator bool() const noexcept {
+    return (block & (static_cast<Block>(1) << bit_idx)) != 0;
+  };
+
+  constexpr bit_reference& flip() noexcept {
+    *this = ~(*this);
+    return *this;
+  };
+
+private:
+  Block& block;
+  std::size_t bit_idx;
+
+  constexpr bit_reference(Block& block_, std::size_t bit_idx_) noexcept
+      : block(block_), bit_idx(bit_idx_) {}
+};
+
+// Scans for set bits a block at a time: empty blocks cost one compare and
+// each set bit one countr_zero, so walking k set bits is O(k + n).
+
+inline constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+// index of the first set bit at or after pos, or npos
+template <class Block>
+constexpr std::size_t find_from(const Block* data, std::size_t n,
+                      std::size_t pos) noexcept {
+  constexpr std::size_t bits = block_bits<Block>;
+  std::size_t i = pos / bits;
+  if (i >= n)
+    return npos;
+  Block word = data[i] & static_cast<Block>(all_ones<Block>
+                                            << (pos % bits));
+  while (!word) {
+    if (++i == n)
+      return npos;
+    word = data[i];
+  }
+  return i * bits + bit_countr_zero(word);
+}
+
+// index of the last set bit, or npos
+template <class Block>
+constexpr std::size_t find_last(const Block* data, std::size_t n) noexcept {
+  constexpr std::size_t bits = block_bits<Block>;
+  for (std::size_t i = n; i-- > 0;) {
+    if (data[i])
+      return i * bits + bits - 1 - bit_countl_zero(data[i]);
+  }
+  return npos;
+}
+
+// Forward range over the indices of the set bits, in increasing order. It
+// only borrows the blocks, so it is invalidated by anything that reallocates
+// them.
+template <class Block>
+class set_bit_view : public std::ranges::view_interface<set_bit_view<Block>> {
+public:
+  class iterator {
+  public:
+    using value_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::forward_iterator_tag;
+
+    iterator() = default;
+
+    constexpr std::size_t operator*() const noexcept {
+      return idx * block_bits<Block> +
+             bit_countr_zero(word);
+    }
+
+    constexpr iterator& operator++() noexcept {
+      // drop the lowest set bit
+      word &= static_cast<Block>(word - 1);
+      skip_empty();
+      return *this;
+    }
+
+    constexpr iterator operator++(int) noexcept {
+      auto ret = *this;
+      ++*this;
+      return ret;
+    }
+
+    constexpr bool operator==(const iterator& rhs) const noexcept {
+      return idx == rhs.idx && word == rhs.word;
+    }
+
+    constexpr bool operator==(std::default_sentinel_t) const noexcept {
+      return idx == n;
+    }
+
+  private:
+    friend class set_bit_view;
+
+    const Block* data = nullptr;
+    std::size_t n = 0;
+    std::size_t idx = 0;
+    // bits of data[idx] not yet visited
+    Block word = 0;
+
+    constexpr iterator(const Block* data_, std::size_t n_) noexcept
+        : data(data_), n(n_), word(n_ ? data_[0] : Block{0}) {
+      skip_empty();
+    }
+
+    constexpr void skip_empty() noexcept {
+      while (!word && idx < n) {
+        if (++idx < n)
+          word = data[idx];
+      }
+    }
+  };
+
+  set_bit_view() = default;
+
+  constexpr set_bit_view(const Block* data_, std::size_t n_) noexcept
+      : data(data_), n(n_) {}
+
+  constexpr iterator begin() const noexcept { return iterator{data, n}; }
+
+  constexpr std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+  const Block* data = nullptr;
+  std::size_t n = 0;
+};
+
+// Text conversion shared by bitset and dynamic_bitset. Text position i is
+// bit i, as in the string constructors. Plain char text over 64-bit blocks
+// goes through the SIMD kernels; everything else takes the loops.
+template <class charT, class traits, class Block>
+inline constexpr bool simd_text =
+    std::same_as<Block, simd::word> && std::same_as<charT, char> &&
+    std::same_as<traits, std::char_traits<char>>;
+
+// Packs text[i] == one into bit i of out, zeroing the ceil(n / bits) blocks
+// it covers. Returns the index of the first character that is neither zero
+// nor one, or n.
+template <class traits, class charT, class Block>
+std::size_t parse_bits(const charT* text, std::size_t n, charT zero,
+                       charT one, Block* out) noexcept {
+  if constexpr (simd_text<charT, traits, Block>) {
+    return simd::active().parse(text, n, zero, one, out);
+  } else {
+    constexpr std::size_t bits = block_bits<Block>;
+    std::fill_n(out, (n + bits - 1) / bits, Block{0});
+    for (std::size_t i = 0; i < n; i++) {
+      if (traits::eq(text[i], one)) {
+        out[i / bits] |= static_cast<Block>(Block{1} << (i % bits));
+      } else if (!traits::eq(text[i], zero)) {
+        return i;
+      }
+    }
+    return n;
+  }
+}
+
+// Writes the first n bits of src, bit n - 1 first, as in to_string.
+template <class traits, class charT, class Block>
+void format_bits(const Block* src, std::size_t n, charT zero, charT one,
+                 charT* out) noexcept {
+  if constexpr (simd_text<charT, traits, Block>) {
+    simd::active().format(src, n, zero, one, out);
+  } else {
+    constexpr std::size_t bits = block_bits<Block>;
+    for (std::size_t i = n; i-- > 0;) {
+      *out++ = (src[i / bits] >> (i % bits)) & 1 ? one : zero;
+    }
+  }
+}
+
+// length of the leading run of zero/one characters in text[0, n)
+template <class traits, class charT>
+std::size_t bit_prefix(const charT* text, std::size_t n, charT zero,
+                       charT one) noexcept {
+  if constexpr (simd_text<charT, traits, simd::word>) {
+    simd::word scratch[64];
+    std::size_t done = 0;
+    while (done < n) {
+      std::size_t len = std::min<std::size_t>(n - done, 64 * 64);
+      std::size_t valid = parse_bits<traits>(text + done, len, zero, one,
+                                              scratch);
+      done += valid;
+      if (valid < len)
+        break;
+    }
+    return done;
+  } else {
+    std::size_t i = 0;
+    while (i < n && (traits::eq(text[i], zero) || traits::eq(text[i], one)))
+      i++;
+    return i;
+  }
+}
+
+// The get area pointers of a streambuf are protected. A pointer to the
+// inherited member formed through a derived class is still a pointer to a
+// member of the base, so it can be applied to any streambuf.
+template <class charT, class traits>
+struct get_area : std::basic_streambuf<charT, traits> {
+  using base = std::basic_streambuf<charT, traits>;
+
+  static const charT* next(base& buf) { return (buf.*&get_area::gptr)(); }
+  static const charT* end(base& buf) { return (buf.*&get_area::egptr)(); }
+  static void advance(base& buf, std::size_t n) {
+    (buf.*&get_area::gbump)(static_cast<int>(n));
+  }
+};
+
+// Extracts at most max '0'/'1' characters as operator>> does, stopping at
+// end of input or at the first other character, which stays in the stream.
+// Buffered input is consumed straight from the streambuf's get area, one
+// refill at a time, instead of a peek() and get() per character.
+template <class charT, class traits>
+std::basic_string<charT, traits>
+read_bits(std::basic_istream<charT, traits>& is, std::size_t max) {
+  std::basic_string<charT, traits> str;
+  // the sentry skips leading whitespace
+  typename std::basic_istream<charT, traits>::sentry sentry(is);
+  if (!sentry)
+    return str;
+
+  using area = get_area<charT, traits>;
+  charT zero = is.widen('0'), one = is.widen('1');
+  auto& buf = *is.rdbuf();
+  while (str.size() < max) {
+    auto c = buf.sgetc();
+    if (traits::eq_int_type(c, traits::eof())) {
+      is.setstate(std::ios_base::eofbit);
+      break;
+    }
+    auto avail = static_cast<std::size_t>(area::end(buf) - area::next(buf));
+    if (avail == 0) {
+      // an unbuffered streambuf hands out one character at a time
+      charT ch = traits::to_char_type(c);
+      if (!traits::eq(ch, zero) && !traits::eq(ch, one))
+        break;
+      str.push_back(ch);
+      buf.sbumpc();
+      continue;
+    }
+    std::size_t len = std::min(avail, max - str.size());
+    std::size_t valid = bit_prefix<traits>(area::next(buf), len, zero, one);
+    str.append(area::next(buf), valid);
+    area::advance(buf, valid);
+    if (valid < len)
+      break;
+  }
+  return str;
+}
+
+// Inserts the first n bits of src as operator<< does. Without a field width
+// the text is formatted in chunks and handed to the streambuf with sputn.
+template <class charT, class traits, class Block>
+std::basic_ostream<charT, traits>&
+write_bits(std::basic_ostream<charT, traits>& os, const Block* src,
+           std::size_t n) {
+  charT zero = os.widen('0'), one = os.widen('1');
+  if (os.width() > 0) {
+    // padding and adjustment are left to the string inserter
+    std::basic_string<charT, traits> str(n, zero);
+    format_bits<traits>(src, n, zero, one, str.data());
+    return os << str;
+  }
+
+  typename std::basic_ostream<charT, traits>::sentry sentry(os);
+  if (!sentry)
+    return os;
+  constexpr std::size_t chunk = 4096;
+  charT text[chunk];
+  // the first chunk takes the top n % chunk bits, so the rest start on a
+  // block boundary
+  for (std::size_t last = n; last > 0;) {
+    std::size_t len = last % chunk ? last % chunk : chunk;
+    last -= len;
+    format_bits<traits>(src + last / block_bits<Block>, len, zero, one, text);
+    if (os.rdbuf()->sputn(text, static_cast<std::streamsize>(len)) !=
+        static_cast<std::streamsize>(len)) {
+      os.setstate(std::ios_base::badbit);
+      break;
+    }
+  }
+  return os;
+}
+
+// Lazy bitset expressions, defined after bitset. bitset_type names the
+// bitset an expression evaluates to; bitset itself does not have it.
+template <class Derived, class Bitset> class bitset_expr;
+template <class Op, class L, class R> class bitset_binary_expr;
+template <class E> class bitset_not_expr;
+template <class E, class F>
+constexpr void for_each_tile(const E& e, F&& f) noexcept;
+
+template <class E, class Bitset>
+concept expression_of =
+    std::same_as<typename std::remove_cvref_t<E>::bitset_type, Bitset>;
+
+} // namespace detail
+
+// Block is the unsigned integer type the bits are stored in. By default it
+// is the smallest of uint8_t..uint32_t that holds N bits, and std::size_t
+// beyond that, so bitset<4> is one byte. Wider blocks such as unsigned
+// __int128 can be chosen explicitly; the bulk operations only reach the SIMD
+// kernels for 64-bit blocks, which already process 256 or 512 bits per step.
+template <std::size_t N, class Block> class bitset {
+  static_assert(static_cast<Block>(-1) > Block{0},
+                "bitset blocks must be an unsigned integer type");
+
+  using block_t = Block;
+  constexpr static std::size_t block_t_bitsize = detail::block_bits<block_t>;
+  constexpr static std::size_t num_blocks =
+      (N + block_t_bitsize - 1) / block_t_bitsize;
+
+public:
+  using block_type = Block;
+  using reference = detail::bit_reference<block_t>;
 
   constexpr bitset() noexcept {}
 
   constexpr bitset(unsigned long long val) noexcept {
-    std::size_t M = std::min(N, block_t_bitsize);
-    data[0] |= val;
+    constexpr std::size_t ull_bits =
+        std::numeric_limits<unsigned long long>::digits;
+    // val spans several blocks when they are narrower than 64 bits
+    for (std::size_t i = 0; i < num_blocks && i * block_t_bitsize < ull_bits;
+         i++) {
+      data[i] = static_cast<block_t>(val >> (i * block_t_bitsize));
+    }
+    if constexpr (num_blocks > 0) {
+      data[num_blocks - 1] &= last_block_mask;
+    }
   }
 
   template <class charT = char, class traits = std::char_traits<charT>,
@@ -32,101 +808,168 @@ public:
           std::basic_string<charT, traits, Allocator>::npos,
       charT zero = charT('0'), charT one = charT('1')) {
 
-    using str_t = std::basic_string<charT, traits, Allocator>;
     if (pos > str.size())
       throw std::out_of_range{"string starting index out of range"};
 
-    std::size_t idx = 0;
-    while (idx < std::min(N, n == str_t::npos ? str.size() : n)) {
-      if (str[pos + idx] != zero && str[pos + idx] != one) {
-        throw std::invalid_argument{"non-0/1 char in str"};
-      } else if (str[pos + idx] == one) {
-        set(pos + idx);
-      }
-      idx++;
-    }
+    std::size_t len = std::min({N, n, str.size() - pos});
+    if (detail::parse_bits<traits>(str.data() + pos, len, zero, one, data) !=
+        len)
+      throw std::invalid_argument{"non-0/1 char in str"};
+  }
+
+  // evaluates a lazy expression such as (a & b) | ~c in a single pass
+  template <detail::expression_of<bitset> E>
+  constexpr bitset(const E& expr) noexcept {
+    assign(expr, [](block_t* dst, const block_t* src, std::size_t n) {
+      std::copy_n(src, n, dst);
+    });
+  }
+
+  template <detail::expression_of<bitset> E>
+  constexpr bitset& operator=(const E& expr) noexcept {
+    return assign(expr, [](block_t* dst, const block_t* src, std::size_t n) {
+      std::copy_n(src, n, dst);
+    });
   }
 
   // 20.9.2.2, bitset operations
-  bitset<N>& operator&=(const bitset<N>& rhs) noexcept {
-    for (std::size_t i = 0; i < num_blocks; i++) {
-      data[i] &= rhs.data[i];
-    }
+  constexpr bitset& operator&=(const bitset& rhs) noexcept {
+    detail::block_and(data, rhs.data, num_blocks);
     return *this;
   };
 
-  bitset<N>& operator|=(const bitset<N>& rhs) noexcept {
-    for (std::size_t i = 0; i < num_blocks; i++) {
-      data[i] |= rhs.data[i];
-    }
+  constexpr bitset& operator|=(const bitset& rhs) noexcept {
+    detail::block_or(data, rhs.data, num_blocks);
     return *this;
   };
 
-  bitset<N>& operator^=(const bitset<N>& rhs) noexcept {
-    for (std::size_t i = 0; i < num_blocks; i++) {
-      data[i] ^= rhs.data[i];
-    }
+  constexpr bitset& operator^=(const bitset& rhs) noexcept {
+    detail::block_xor(data, rhs.data, num_blocks);
     return *this;
   };
 
-  bitset<N>& operator<<=(std::size_t pos) noexcept {
-    namespace sv = std::ranges::views;
-    for (std::size_t i : sv::iota(pos, N) | sv::reverse) {
-      set_unchecked(i, (*this)[i - pos]);
-    }
-    for (std::size_t i = 0; i < pos; i++) {
-      if (i % block_t_bitsize == 0 && i + block_t_bitsize < pos) {
-        data[i / block_t_bitsize] = 0;
-        i += block_t_bitsize - 1;
-      } else {
-        reset_unchecked(i);
-      }
-    }
-    return *this;
+  template <detail::expression_of<bitset> E>
+  constexpr bitset& operator&=(const E& expr) noexcept {
+    return assign(expr, detail::block_and<block_t>);
   }
 
-  bitset<N>& operator>>=(std::size_t pos) noexcept {
-    for (std::size_t i = 0; i + pos < N; i++) {
-      set_unchecked(i, (*this)[i + pos]);
-    }
-    for (std::size_t i = N - pos; i < N; i++) {
-      if (i % block_t_bitsize == 0) {
-        data[i / block_t_bitsize] = 0;
-        i += block_t_bitsize - 1;
-      } else {
-        reset_unchecked(i);
-      }
-    }
+  template <detail::expression_of<bitset> E>
+  constexpr bitset& operator|=(const E& expr) noexcept {
+    return assign(expr, detail::block_or<block_t>);
+  }
+
+  template <detail::expression_of<bitset> E>
+  constexpr bitset& operator^=(const E& expr) noexcept {
+    return assign(expr, detail::block_xor<block_t>);
+  }
+
+  constexpr bitset& operator<<=(std::size_t pos) noexcept {
+    detail::shift_left(data, num_blocks, pos);
+    return sanitize();
+  }
+
+  constexpr bitset& operator>>=(std::size_t pos) noexcept {
+    detail::shift_right(data, num_blocks, pos);
     return *this;
   };
 
-  bitset<N>& set() noexcept { return set_unchecked(); };
+  constexpr bitset& set() noexcept { return set_unchecked(); };
 
-  bitset<N>& set(std::size_t pos, bool val = true) {
+  constexpr bitset& set(std::size_t pos, bool val = true) {
     if (pos >= N)
       throw std::out_of_range{"Attempted to set bit out of range"};
     return set_unchecked(pos, val);
   }
 
-  bitset<N>& reset() noexcept { return reset_unchecked(); }
+  constexpr bitset& reset() noexcept { return reset_unchecked(); }
 
-  bitset<N>& reset(std::size_t pos) { 
-    if(pos >= N) {
+  constexpr bitset& reset(std::size_t pos) {
+    if (pos >= N) {
       throw std::out_of_range{"Attempted to reset bit out of range"};
     }
-    return reset_unchecked(pos); 
+    return reset_unchecked(pos);
   }
 
-  bitset<N> operator~() const noexcept { return this->flip(); }
+  // Set, clear or flip bits [first, last), a whole block at a time. These
+  // are not overloads of set(pos, val) and friends: set(i, n) with an
+  // integer n already means "set bit i to bool(n)".
+  constexpr bitset& set_range(std::size_t first, std::size_t last) {
+    check_range(first, last);
+    detail::set_range(data, first, last);
+    return *this;
+  }
 
-  bitset<N>& flip() noexcept {
-    for (std::size_t i = 0; i < num_blocks; i++) {
-      data[i] = ~data[i];
-    }
+  constexpr bitset& reset_range(std::size_t first, std::size_t last) {
+    check_range(first, last);
+    detail::reset_range(data, first, last);
+    return *this;
+  }
+
+  constexpr bitset& flip_range(std::size_t first, std::size_t last) {
+    check_range(first, last);
+    detail::flip_range(data, first, last);
     return *this;
   }
 
-  bitset<N>& flip(std::size_t pos) {
+  // The W-bit field starting at pos, with bit pos as its lowest bit.
+  template <std::size_t W>
+  constexpr unsigned long long extract(std::size_t pos) const {
+    static_assert(W > 0 && W <= 64, "extract reads at most 64 bits");
+    check_range(pos, pos + W);
+    return detail::load_field(data, pos, W);
+  }
+
+  // Overwrites bits [pos, pos + width) with the low width bits of value.
+  constexpr bitset& deposit(std::size_t pos, unsigned long long value,
+                            std::size_t width) {
+    if (width > 64)
+      throw std::out_of_range{"deposit writes at most 64 bits"};
+    check_range(pos, pos + width);
+    detail::store_field(data, pos, width, value);
+    return *this;
+  }
+
+  // Bits pos + i for each set bit i of mask, packed into the low bits of the
+  // result in order; pext when the CPU has BMI2.
+  constexpr unsigned long long gather(std::size_t pos,
+                                     unsigned long long mask) const {
+    std::size_t width = std::bit_width(mask);
+    check_range(pos, pos + width);
+    std::uint64_t field = detail::load_field(data, pos, width);
+    return std::is_constant_evaluated()
+               ? detail::simd::scalar::pext(field, mask)
+               : detail::simd::active().pext(field, mask);
+  }
+
+  // The inverse of gather: bit j of value goes to pos + i, where i is the
+  // j-th set bit of mask. Bits outside mask are left alone.
+  constexpr bitset& scatter(std::size_t pos, unsigned long long mask,
+                            unsigned long long value) {
+    std::size_t width = std::bit_width(mask);
+    check_range(pos, pos + width);
+    std::uint64_t field = detail::load_field(data, pos, width);
+    field = (field & ~mask) | (std::is_constant_evaluated()
+                                   ? detail::simd::scalar::pdep(value, mask)
+                                   : detail::simd::active().pdep(value, mask));
+    detail::store_field(data, pos, width, field);
+    return *this;
+  }
+
+  // lazy; a temporary operand is moved into the expression
+  constexpr detail::bitset_not_expr<const bitset&> operator~() const& noexcept {
+    return detail::bitset_not_expr<const bitset&>{*this};
+  }
+
+  constexpr detail::bitset_not_expr<bitset> operator~() && noexcept {
+    return detail::bitset_not_expr<bitset>{std::move(*this)};
+  }
+
+  constexpr bitset& flip() noexcept {
+    detail::block_flip(data, num_blocks);
+    return sanitize();
+  }
+
+  constexpr bitset& flip(std::size_t pos) {
     std::size_t block_idx = pos / block_t_bitsize;
     std::size_t bit = pos - (block_t_bitsize * block_idx);
     data[block_idx] ^= static_cast<block_t>(1) << bit;
@@ -141,170 +984,185 @@ public:
   }
 
   // for b[i];
-  reference operator[](std::size_t pos) {
+  constexpr reference operator[](std::size_t pos) {
     std::size_t block_idx = pos / block_t_bitsize;
     std::size_t bit = pos - (block_t_bitsize * block_idx);
     return reference{data[block_idx], bit};
   }
 
   // for b[i];
-  unsigned long to_ulong() const {
-    for (std::size_t i = 1; i < num_blocks; i++) {
-      if (data[i])
+  constexpr unsigned long to_ulong() const {
+    constexpr std::size_t ulong_bits =
+        std::numeric_limits<unsigned long>::digits;
+    unsigned long ret = 0;
+    for (std::size_t i = 0; i < num_blocks; i++) {
+      std::size_t offset = i * block_t_bitsize;
+      // set bits at or above ulong_bits do not fit; a block wider than
+      // unsigned long can hold some of them itself
+      bool overflow = offset >= ulong_bits
+                          ? data[i] != 0
+                          : block_t_bitsize > ulong_bits - offset &&
+                                (data[i] >> (ulong_bits - offset)) != 0;
+      if (overflow)
         throw std::overflow_error{"Incurred overflow upon attempting to "
                                   "convert bitset to unsigned long"};
+      if (offset < ulong_bits)
+        ret |= static_cast<unsigned long>(data[i]) << offset;
     }
-    return static_cast<unsigned long>(data[0]);
+    return ret;
   }
 
-  unsigned long long to_ullong() const { return to_ulong(); }
+  constexpr unsigned long long to_ullong() const { return to_ulong(); }
 
   template <class charT = char, class traits = std::char_traits<charT>,
             class Allocator = std::allocator<charT>>
   std::basic_string<charT, traits, Allocator>
   to_string(charT zero = charT('0'), charT one = charT('1')) const {
     std::basic_string<charT, traits, Allocator> ret(N, zero);
-
-    for (std::size_t i = 0; i < N; i++) {
-      if (test(i))
-        ret[N - i - 1] = one;
-    }
+    detail::format_bits<traits>(data, N, zero, one, ret.data());
     return ret;
   }
 
-  std::size_t count() const noexcept {
-    std::size_t sum = 0;
-    for (std::size_t i = 0; i < num_blocks; i++) {
-      sum += std::popcount(data[i]);
-    }
-    return sum;
+  constexpr std::size_t count() const noexcept {
+    return detail::block_count(data, num_blocks);
   }
 
   constexpr std::size_t size() const noexcept { return N; }
 
-  bool operator==(const bitset<N>& rhs) const noexcept {
-    for (std::size_t i = 0; i < num_blocks; i++) {
-      if (data[i] != rhs.data[i])
-        return false;
-    }
-    return true;
+  // set-bit search; each returns npos when there is no such bit
+  constexpr static std::size_t npos = detail::npos;
+
+  constexpr std::size_t find_first() const noexcept {
+    return detail::find_from(data, num_blocks, 0);
   }
 
-  bool test(std::size_t pos) const {
+  // first set bit strictly after pos
+  constexpr std::size_t find_next(std::size_t pos) const noexcept {
+    return pos >= N - 1 ? npos : detail::find_from(data, num_blocks, pos + 1);
+  }
+
+  constexpr std::size_t find_last() const noexcept {
+    return detail::find_last(data, num_blocks);
+  }
+
+  // indices of the set bits in increasing order
+  constexpr detail::set_bit_view<block_t> set_bits() const noexcept {
+    return {data, num_blocks};
+  }
+
+  // raw block access, for structures layered on top of bitset
+  constexpr std::span<const block_t, num_blocks> blocks() const noexcept {
+    return std::span<const block_t, num_blocks>{data};
+  }
+
+  // The bits in the binary layout described at detail::bytes_for, viewed in
+  // place. Only little-endian hosts store the blocks in that byte order.
+  std::span<const std::byte, (N + 7) / 8> as_bytes() const noexcept
+    requires(std::endian::native == std::endian::little)
+  {
+    return std::span<const std::byte, (N + 7) / 8>{
+        reinterpret_cast<const std::byte*>(data), (N + 7) / 8};
+  }
+
+  // Reads the layout written by as_bytes(). Throws invalid_argument unless
+  // there are exactly (N + 7) / 8 bytes with no bit set past N.
+  static bitset from_bytes(std::span<const std::byte> bytes) {
+    bitset ret;
+    detail::load_bytes(bytes, N, ret.data);
+    return ret;
+  }
+
+  constexpr bool operator==(const bitset& rhs) const noexcept {
+    return detail::block_equal(data, rhs.data, num_blocks);
+  }
+
+  constexpr bool test(std::size_t pos) const {
     if (pos >= N)
       throw std::out_of_range{"Attempted to test bit out of range"};
     return (*this)[pos];
   }
 
-  bool all() const noexcept {
-    block_t mask = std::numeric_limits<block_t>::max();
-    for (std::size_t i = 0; i < num_blocks; i++) {
-      if (mask != (mask & data[i]))
-        return false;
-    }
-    return true;
+  constexpr bool all() const noexcept {
+    return detail::block_all(data, num_blocks - 1) &&
+           data[num_blocks - 1] == last_block_mask;
   }
 
-  bool any() const noexcept {
-    block_t mask = 0;
-    for (std::size_t i = 0; i < num_blocks; i++) {
-      mask |= data[i];
-      if (mask)
-        return true;
-    }
-    return false;
+  constexpr bool any() const noexcept {
+    return detail::block_any(data, num_blocks);
   }
 
-  bool none() const noexcept { return !any(); }
+  constexpr bool none() const noexcept { return !any(); }
 
-  bitset<N> operator<<(std::size_t pos) const noexcept {
+  constexpr bitset operator<<(std::size_t pos) const noexcept {
     auto ret = *this;
     ret <<= pos;
     return ret;
   }
 
-  bitset<N> operator>>(std::size_t pos) const noexcept {
+  constexpr bitset operator>>(std::size_t pos) const noexcept {
     auto ret = *this;
     ret >>= pos;
     return ret;
   }
 
-  template <class charT, class traits>
-  friend std::basic_istream<charT, traits>&
-  operator>>(std::basic_istream<charT, traits>& is, bitset<N>& x);
+  friend class atomic_bitset<N>;
+  template <std::size_t, std::size_t> friend class bit_matrix;
+  friend struct detail::block_access;
 
-  private:
-  using block_t = std::size_t;
-  constexpr static std::size_t block_t_bitsize = 8 * sizeof(block_t);
-  constexpr static std::size_t num_blocks =
-      (N + block_t_bitsize - 1) / block_t_bitsize;
+private:
+  // bits of the last block that lie below N; everything above is kept zero so
+  // that count(), all(), == and the shifts can work on whole blocks
+  constexpr static block_t last_block_mask =
+      N % block_t_bitsize == 0
+          ? detail::all_ones<block_t>
+          : static_cast<block_t>(
+                (static_cast<block_t>(1) << (N % block_t_bitsize)) - 1);
 
   block_t data[num_blocks]{};
 
-  bitset<N>& set_unchecked();
-
-  bitset<N>& set_unchecked(std::size_t pos, bool val = true);
-
-  bitset<N>& reset_unchecked() noexcept;
-
-  bitset<N>& reset_unchecked(std::size_t pos);
-
-  // need a non-noexcept impl to reuse in bitshift operators
-};
-
-template <std::size_t N> class bitset<N>::reference {
-public:
-  friend class bitset;
-
-  reference() = delete;
-  reference(const reference&) = default;
-  ~reference() = default;
-
-  reference& operator=(bool x) noexcept {
-    auto bit = static_cast<block_t>(1) << bit_idx;
-    if (x) {
-      block |= bit;
-    } else {
-      block &= std::numeric_limits<block_t>::max() ^ bit;
-    }
+  constexpr bitset& sanitize() noexcept {
+    data[num_blocks - 1] &= last_block_mask;
     return *this;
-  };
+  }
 
-  reference& operator=(const reference& rhs) noexcept {
-    block = rhs.block;
-    bit_idx = rhs.bit_idx;
-    return *this;
-  };
+  // combines each evaluated tile of expr into data with kernel(dst, src, n);
+  // the tile goes through a buffer because expr may read *this
+  template <class E, class Kernel>
+  constexpr bitset& assign(const E& expr, Kernel kernel) noexcept {
+    detail::for_each_tile(expr, [&](std::size_t first, std::size_t n,
+                                    const block_t* tile) {
+      kernel(data + first, tile, n);
+      return true;
+    });
+    return sanitize();
+  }
 
-  bool operator~() const noexcept { return !static_cast<bool>(*this); }
+  constexpr static void check_range(std::size_t first, std::size_t last) {
+    if (first > last || last > N)
+      throw std::out_of_range{"bit range out of range"};
+  }
 
-  operator bool() const noexcept {
-    return (block & (static_cast<block_t>(1) << bit_idx)) != 0;
-  };
+  constexpr bitset& set_unchecked();
 
-  reference& flip() noexcept {
-    *this = ~(*this);
-    return *this;
-  };
+  constexpr bitset& set_unchecked(std::size_t pos, bool val = true);
 
-private:
-  block_t& block;
-  std::size_t bit_idx;
+  constexpr bitset& reset_unchecked() noexcept;
 
-  reference(block_t& block_, std::size_t bit_idx_) noexcept
-      : block(block_), bit_idx(bit_idx_) {}
+  constexpr bitset& reset_unchecked(std::size_t pos);
 };
 
-template <std::size_t N> bitset<N>& bitset<N>::set_unchecked() {
-  block_t mask = std::numeric_limits<block_t>::max();
+template <std::size_t N, class Block>
+constexpr bitset<N, Block>& bitset<N, Block>::set_unchecked() {
+  block_t mask = detail::all_ones<block_t>;
   for (std::size_t i = 0; i < num_blocks; i++) {
     data[i] |= mask;
   }
-  return *this;
+  return sanitize();
 }
 
-template <std::size_t N>
-bitset<N>& bitset<N>::set_unchecked(std::size_t pos, bool val) {
+template <std::size_t N, class Block>
+constexpr bitset<N, Block>& bitset<N, Block>::set_unchecked(std::size_t pos,
+                                                          bool val) {
   if (!val)
     return reset_unchecked(pos);
   std::size_t block_idx = pos / block_t_bitsize;
@@ -313,79 +1171,356 @@ bitset<N>& bitset<N>::set_unchecked(std::size_t pos, bool val) {
   return *this;
 }
 
-template <std::size_t N> bitset<N>& bitset<N>::reset_unchecked() noexcept {
+template <std::size_t N, class Block>
+constexpr bitset<N, Block>& bitset<N, Block>::reset_unchecked() noexcept {
   for (std::size_t i = 0; i < num_blocks; i++) {
     data[i] &= 0;
   }
   return *this;
 }
 
-template <std::size_t N>
-bitset<N>& bitset<N>::reset_unchecked(std::size_t pos) {
+template <std::size_t N, class Block>
+constexpr bitset<N, Block>& bitset<N, Block>::reset_unchecked(std::size_t pos) {
   std::size_t block_idx = pos / block_t_bitsize;
   std::size_t bit = pos - (block_t_bitsize * block_idx);
-  block_t mask = std::numeric_limits<block_t>::max();
+  block_t mask = detail::all_ones<block_t>;
   data[block_idx] &= mask ^ (static_cast<block_t>(1) << bit);
   return *this;
 }
 
-template <std::size_t N>
-bitset<N> operator&(const bitset<N>& lhs, const bitset<N>& rhs) noexcept {
-  bitset<N> res(lhs);
-  res &= rhs;
-  return res;
+namespace detail {
+
+// Expression templates for bitset. a & b, a | b, a ^ b and ~a build nodes
+// that hold bitset operands by reference, or by value when the operand is a
+// temporary, so nothing is computed until the expression is assigned to a
+// bitset or reduced with count/any/none/all.
+//
+// Evaluation walks the result in tiles of tile_bytes. Each node produces its
+// tile in a stack buffer with the block_* kernels, so the SIMD dispatch still
+// applies. The tiles stay in L1, and every operand is read from memory once
+// however many operators the expression has.
+
+inline constexpr std::size_t tile_bytes = 2048;
+
+template <class T> struct is_bitset : std::false_type {};
+template <std::size_t N, class Block>
+struct is_bitset<bitset<N, Block>> : std::true_type {};
+
+template <class T>
+concept bitset_operand =
+    is_bitset<std::remove_cvref_t<T>>::value ||
+    requires { typename std::remove_cvref_t<T>::bitset_type; };
+
+template <class T> struct bitset_of {
+  using type = typename T::bitset_type;
+};
+template <std::size_t N, class Block> struct bitset_of<bitset<N, Block>> {
+  using type = bitset<N, Block>;
+};
+template <class T>
+using bitset_of_t = typename bitset_of<std::remove_cvref_t<T>>::type;
+
+// N read from the type, without building a bitset<N> to ask
+template <class Bitset> struct bitset_size;
+template <std::size_t N, class Block>
+struct bitset_size<bitset<N, Block>>
+    : std::integral_constant<std::size_t, N> {};
+template <class Bitset>
+inline constexpr std::size_t bitset_size_v = bitset_size<Bitset>::value;
+
+template <class L, class R>
+concept bitset_operands = bitset_operand<L> && bitset_operand<R> &&
+                          std::same_as<bitset_of_t<L>, bitset_of_t<R>>;
+
+// how a node stores an operand: named bitsets by reference, everything else
+// (temporary bitsets and other nodes) by value
+template <class T>
+using operand_t =
+    std::conditional_t<is_bitset<std::remove_cvref_t<T>>::value &&
+                           std::is_lvalue_reference_v<T>,
+                       const std::remove_cvref_t<T>&, std::remove_cvref_t<T>>;
+
+// writes blocks [first, first + n) of e to out; bits above N may be set
+template <class E, class Block>
+constexpr void eval_tile(const E& e, std::size_t first, std::size_t n,
+               Block* out) noexcept {
+  if constexpr (is_bitset<E>::value) {
+    std::copy_n(e.blocks().data() + first, n, out);
+  } else {
+    e.eval(first, n, out);
+  }
 }
 
-template <std::size_t N>
-bitset<N> operator|(const bitset<N>& lhs, const bitset<N>& rhs) noexcept {
-  bitset<N> res(lhs);
-  res |= rhs;
-  return res;
+// calls f(first, n, tile) for each tile of e with the bits above N cleared,
+// until f returns false
+template <class E, class F>
+constexpr void for_each_tile(const E& e, F&& f) noexcept {
+  using block = typename bitset_of_t<E>::block_type;
+  constexpr std::size_t bits = bitset_size_v<bitset_of_t<E>>;
+  constexpr std::size_t digits = block_bits<block>;
+  constexpr std::size_t num_blocks = (bits + digits - 1) / digits;
+  constexpr std::size_t tile_blocks =
+      std::min(tile_bytes / sizeof(block), num_blocks);
+  alignas(64) block tile[tile_blocks];
+  for (std::size_t first = 0; first < num_blocks; first += tile_blocks) {
+    std::size_t n = std::min(tile_blocks, num_blocks - first);
+    eval_tile(e, first, n, tile);
+    if (first + n == num_blocks && bits % digits)
+      tile[n - 1] &= static_cast<block>((block{1} << (bits % digits)) - 1);
+    if (!f(first, n, static_cast<const block*>(tile)))
+      return;
+  }
 }
 
-template <std::size_t N>
-bitset<N> operator^(const bitset<N>& lhs, const bitset<N>& rhs) noexcept {
-  bitset<N> res(lhs);
-  res ^= rhs;
-  return res;
+struct and_op {
+  template <class Block>
+  constexpr static void apply(Block* dst, const Block* src,
+                              std::size_t n) noexcept {
+    block_and(dst, src, n);
+  }
 };
 
-template <class charT, class traits, std::size_t N>
-std::basic_istream<charT, traits>&
-operator>>(std::basic_istream<charT, traits>& is, bitset<N>& x) {
-  // basic_istream::widen => Converts a character to its equivalent in the
-  // current locale. The result is converted from char to character type used
-  // within the stream if needed.
-  auto zero = is.widen('0'), one = is.widen('1'), ws = is.widen(' ');
+struct or_op {
+  template <class Block>
+  constexpr static void apply(Block* dst, const Block* src,
+                              std::size_t n) noexcept {
+    block_or(dst, src, n);
+  }
+};
 
-  std::size_t idx = 0;
-  std::basic_string<charT, traits> str(N, zero);
-  charT test_c;
+struct xor_op {
+  template <class Block>
+  constexpr static void apply(Block* dst, const Block* src,
+                              std::size_t n) noexcept {
+    block_xor(dst, src, n);
+  }
+};
+
+// Members shared by every node. Reductions are fused; the rest evaluate
+// only the blocks they need, or materialize the bitset.
+template <class Derived, class Bitset> class bitset_expr {
+  using block = typename Bitset::block_type;
+  constexpr static std::size_t N = bitset_size_v<Bitset>;
 
-  while (is >> test_c && test_c == ws) {
-  }; // clang-format moment
+public:
+  using bitset_type = Bitset;
+
+  constexpr std::size_t size() const noexcept { return N; }
 
-  while (str.size() < N && is >> test_c) {
-    if (test_c == zero || test_c == one) {
-      str[idx++] = test_c;
+  constexpr std::size_t count() const noexcept {
+    std::size_t sum = 0;
+    for_each_tile(self(), [&](std::size_t, std::size_t n, const block* tile) {
+      sum += block_count(tile, n);
+      return true;
+    });
+    return sum;
+  }
+
+  constexpr bool any() const noexcept {
+    bool found = false;
+    for_each_tile(self(), [&](std::size_t, std::size_t n, const block* tile) {
+      found = block_any(tile, n);
+      return !found;
+    });
+    return found;
+  }
+
+  constexpr bool none() const noexcept { return !any(); }
+
+  constexpr bool all() const noexcept { return count() == N; }
+
+  constexpr bool operator[](std::size_t pos) const noexcept {
+    block word;
+    eval_tile(self(), pos / block_bits<block>, 1, &word);
+    return (word >> (pos % block_bits<block>)) & 1;
+  }
+
+  constexpr bool test(std::size_t pos) const {
+    if (pos >= N)
+      throw std::out_of_range{"Attempted to test bit out of range"};
+    return (*this)[pos];
+  }
+
+  constexpr unsigned long to_ulong() const {
+    return Bitset(self()).to_ulong();
+  }
+
+  constexpr unsigned long long to_ullong() const { return to_ulong(); }
+
+  template <class charT = char, class traits = std::char_traits<charT>,
+            class Allocator = std::allocator<charT>>
+  std::basic_string<charT, traits, Allocator>
+  to_string(charT zero = charT('0'), charT one = charT('1')) const {
+    return Bitset(self()).template to_string<charT, traits, Allocator>(zero,
+                                                                       one);
+  }
+
+private:
+  constexpr const Derived& self() const noexcept {
+    return static_cast<const Derived&>(*this);
+  }
+};
+
+template <class Op, class L, class R>
+class bitset_binary_expr
+    : public bitset_expr<bitset_binary_expr<Op, L, R>, bitset_of_t<L>> {
+  using block = typename bitset_of_t<L>::block_type;
+
+public:
+  constexpr bitset_binary_expr(L l_, R r_) noexcept
+      : l(static_cast<L&&>(l_)), r(static_cast<R&&>(r_)) {}
+
+  constexpr void eval(std::size_t first, std::size_t n,
+                      block* out) const noexcept {
+    using left = std::remove_cvref_t<L>;
+    using right = std::remove_cvref_t<R>;
+    // a bitset operand is read in place; all three ops are commutative
+    if constexpr (is_bitset<right>::value) {
+      eval_tile(l, first, n, out);
+      Op::apply(out, r.blocks().data() + first, n);
+    } else if constexpr (is_bitset<left>::value) {
+      eval_tile(r, first, n, out);
+      Op::apply(out, l.blocks().data() + first, n);
     } else {
-      break;
+      alignas(64) block tmp[tile_bytes / sizeof(block)];
+      eval_tile(l, first, n, out);
+      eval_tile(r, first, n, tmp);
+      Op::apply(out, static_cast<const block*>(tmp), n);
     }
   }
 
-  if (N > 0 && idx == 0) {
+private:
+  L l;
+  R r;
+};
+
+template <class E>
+class bitset_not_expr : public bitset_expr<bitset_not_expr<E>, bitset_of_t<E>> {
+  using block = typename bitset_of_t<E>::block_type;
+
+public:
+  constexpr explicit bitset_not_expr(E e_) noexcept : e(static_cast<E&&>(e_)) {}
+
+  constexpr void eval(std::size_t first, std::size_t n,
+                      block* out) const noexcept {
+    eval_tile(e, first, n, out);
+    block_flip(out, n);
+  }
+
+private:
+  E e;
+};
+
+} // namespace detail
+
+template <class L, class R>
+  requires detail::bitset_operands<L, R>
+constexpr auto operator&(L&& lhs, R&& rhs) noexcept {
+  return detail::bitset_binary_expr<detail::and_op, detail::operand_t<L>,
+                                    detail::operand_t<R>>{
+      static_cast<L&&>(lhs), static_cast<R&&>(rhs)};
+}
+
+template <class L, class R>
+  requires detail::bitset_operands<L, R>
+constexpr auto operator|(L&& lhs, R&& rhs) noexcept {
+  return detail::bitset_binary_expr<detail::or_op, detail::operand_t<L>,
+                                    detail::operand_t<R>>{
+      static_cast<L&&>(lhs), static_cast<R&&>(rhs)};
+}
+
+template <class L, class R>
+  requires detail::bitset_operands<L, R>
+constexpr auto operator^(L&& lhs, R&& rhs) noexcept {
+  return detail::bitset_binary_expr<detail::xor_op, detail::operand_t<L>,
+                                    detail::operand_t<R>>{
+      static_cast<L&&>(lhs), static_cast<R&&>(rhs)};
+}
+
+template <class E>
+  requires(!detail::is_bitset<std::remove_cvref_t<E>>::value &&
+           detail::bitset_operand<E>)
+constexpr auto operator~(E&& expr) noexcept {
+  return detail::bitset_not_expr<std::remove_cvref_t<E>>{
+      static_cast<E&&>(expr)};
+}
+
+// Reductions over a bitset or an expression; on an expression none of them
+// materializes the result, and any/none/intersects stop at the first tile
+// with a set bit.
+
+template <detail::bitset_operand E>
+constexpr std::size_t count(const E& expr) noexcept {
+  return expr.count();
+}
+
+template <detail::bitset_operand E>
+constexpr bool any(const E& expr) noexcept {
+  return expr.any();
+}
+
+template <detail::bitset_operand E>
+constexpr bool none(const E& expr) noexcept {
+  return expr.none();
+}
+
+template <detail::bitset_operand E>
+constexpr bool all(const E& expr) noexcept {
+  return expr.all();
+}
+
+// compares without materializing either side
+template <class L, class R>
+  requires detail::bitset_operands<L, R> &&
+           (!detail::is_bitset<L>::value || !detail::is_bitset<R>::value)
+constexpr bool operator==(const L& lhs, const R& rhs) noexcept {
+  return (lhs ^ rhs).none();
+}
+
+// true if lhs and rhs have a set bit in common
+template <class L, class R>
+  requires detail::bitset_operands<L, R>
+constexpr bool intersects(const L& lhs, const R& rhs) noexcept {
+  return (lhs & rhs).any();
+}
+
+template <class charT, class traits, std::size_t N, class Block>
+std::basic_istream<charT, traits>&
+operator>>(std::basic_istream<charT, traits>& is, bitset<N, Block>& x) {
+  auto str = detail::read_bits(is, N);
+  if (N > 0 && str.empty()) {
     is.setstate(std::ios_base::failbit);
+    return is;
   }
 
-  x = bitset<N>{str};
+  // basic_istream::widen => Converts a character to its equivalent in the
+  // current locale. The result is converted from char to character type used
+  // within the stream if needed.
+  x = bitset<N, Block>{str, 0, N, is.widen('0'), is.widen('1')};
   return is;
 }
 
-template <class charT, class traits, std::size_t N>
+template <class charT, class traits, std::size_t N, class Block>
 std::basic_ostream<charT, traits>&
-operator<<(std::basic_ostream<charT, traits>& os, const bitset<N>& x) {
-  os << x.to_string();
-  return os;
+operator<<(std::basic_ostream<charT, traits>& os, const bitset<N, Block>& x) {
+  return detail::write_bits(os, x.blocks().data(), N);
+}
+
+// word-at-a-time hash of the bits, see detail::hash_bits
+template <std::size_t N, class Block> struct hash<bitset<N, Block>> {
+  std::size_t operator()(const bitset<N, Block>& x) const noexcept {
+    return detail::hash_bits(x.blocks().data(), N);
+  }
 };
 
 } // namespace nstd
+
+// so std::unordered_set and friends pick it up by default
+template <std::size_t N, class Block>
+struct std::hash<nstd::bitset<N, Block>> : nstd::hash<nstd::bitset<N, Block>> {
+};
+
+template <class Block>
+inline constexpr bool
+    std::ranges::enable_borrowed_range<nstd::detail::set_bit_view<Block>> =
+        true;
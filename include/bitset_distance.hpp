@@ -0,0 +1,193 @@
+#pragma once
+
+#include "bitset.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+namespace nstd {
+
+// Batched pair counts over arrays of bitset fingerprints, for similarity
+// search. Each function takes one query or a range of queries, a contiguous
+// range of base fingerprints, and a caller-supplied output buffer:
+//
+//   hamming_distances     popcount(a ^ b)
+//   intersection_counts   popcount(a & b)
+//   union_counts          popcount(a | b)
+//   jaccard_similarities  popcount(a & b) / popcount(a | b), 1 if both empty
+//
+// With one query, out[j] is the result for base[j]. With many queries out is
+// row-major, out[i * base.size() + j] for queries[i] and base[j], and the
+// base is walked in L1-sized tiles so each tile is reused across all
+// queries before moving on. out must hold at least that many results;
+// otherwise invalid_argument is thrown.
+//
+// Fingerprints with 64-bit blocks go through one kernel call per query and
+// tile, which is AVX-512 VPOPCNTDQ, AVX2 or popcnt depending on the CPU.
+// Other block types fall back to counting expressions pair by pair.
+
+namespace detail {
+
+template <class R, class Bitset>
+concept fingerprints_of =
+    std::ranges::contiguous_range<R> && std::ranges::sized_range<R> &&
+    std::same_as<std::ranges::range_value_t<R>, Bitset>;
+
+template <class R>
+concept fingerprints =
+    std::ranges::contiguous_range<R> && std::ranges::sized_range<R> &&
+    is_bitset<std::ranges::range_value_t<R>>::value;
+
+// base fingerprints per tile in the many-to-many loops; also bounds the
+// stack buffers of the Jaccard loops
+template <class Bitset>
+inline constexpr std::size_t tile_items =
+    std::clamp<std::size_t>(16384 / sizeof(Bitset), 1, 256);
+
+template <simd::pair_op Op, std::size_t N, class Block>
+void count_pairs(const bitset<N, Block>& q, const bitset<N, Block>* base,
+                 std::size_t n, std::size_t* out) noexcept {
+  if constexpr (std::is_same_v<Block, simd::word>) {
+    constexpr std::size_t words = decltype(q.blocks())::extent;
+    // a bitset is exactly its blocks, so an array of them is one run of
+    // words
+    static_assert(sizeof(bitset<N, Block>) == words * sizeof(Block));
+    const auto& k = simd::active();
+    auto kernel = Op == simd::pair_op::bit_and  ? k.count_and_many
+                  : Op == simd::pair_op::bit_or ? k.count_or_many
+                                                : k.count_xor_many;
+    if (n > 0)
+      kernel(q.blocks().data(), base->blocks().data(), words, n, out);
+  } else {
+    for (std::size_t j = 0; j < n; j++) {
+      if constexpr (Op == simd::pair_op::bit_and) {
+        out[j] = (q & base[j]).count();
+      } else if constexpr (Op == simd::pair_op::bit_or) {
+        out[j] = (q | base[j]).count();
+      } else {
+        out[j] = (q ^ base[j]).count();
+      }
+    }
+  }
+}
+
+template <std::size_t N, class Block>
+void jaccard_pairs(const bitset<N, Block>& q, const bitset<N, Block>* base,
+                   std::size_t n, double* out) noexcept {
+  constexpr std::size_t chunk = tile_items<bitset<N, Block>>;
+  std::size_t both[chunk], either[chunk];
+  for (std::size_t first = 0; first < n; first += chunk) {
+    std::size_t len = std::min(chunk, n - first);
+    count_pairs<simd::pair_op::bit_and>(q, base + first, len, both);
+    count_pairs<simd::pair_op::bit_or>(q, base + first, len, either);
+    for (std::size_t j = 0; j < len; j++) {
+      out[first + j] = either[j] ? static_cast<double>(both[j]) /
+                                       static_cast<double>(either[j])
+                                 : 1.0;
+    }
+  }
+}
+
+template <class T> void check_output(std::span<T> out, std::size_t needed) {
+  if (out.size() < needed)
+    throw std::invalid_argument{"output buffer too small"};
+}
+
+template <simd::pair_op Op, class Q, class R>
+void count_pairs_many(const Q& queries, const R& base,
+                      std::span<std::size_t> out) {
+  using Bitset = std::ranges::range_value_t<R>;
+  std::size_t n = std::ranges::size(base);
+  check_output(out, std::ranges::size(queries) * n);
+  const Bitset* b = std::ranges::data(base);
+  for (std::size_t first = 0; first < n; first += tile_items<Bitset>) {
+    std::size_t len = std::min(tile_items<Bitset>, n - first);
+    std::size_t row = 0;
+    for (const Bitset& q : queries) {
+      count_pairs<Op>(q, b + first, len, out.data() + row + first);
+      row += n;
+    }
+  }
+}
+
+} // namespace detail
+
+template <std::size_t N, class Block,
+          detail::fingerprints_of<bitset<N, Block>> R>
+void hamming_distances(const bitset<N, Block>& query, const R& base,
+                       std::span<std::size_t> out) {
+  detail::check_output(out, std::ranges::size(base));
+  detail::count_pairs<detail::simd::pair_op::bit_xor>(
+      query, std::ranges::data(base), std::ranges::size(base), out.data());
+}
+
+template <std::size_t N, class Block,
+          detail::fingerprints_of<bitset<N, Block>> R>
+void intersection_counts(const bitset<N, Block>& query, const R& base,
+                         std::span<std::size_t> out) {
+  detail::check_output(out, std::ranges::size(base));
+  detail::count_pairs<detail::simd::pair_op::bit_and>(
+      query, std::ranges::data(base), std::ranges::size(base), out.data());
+}
+
+template <std::size_t N, class Block,
+          detail::fingerprints_of<bitset<N, Block>> R>
+void union_counts(const bitset<N, Block>& query, const R& base,
+                  std::span<std::size_t> out) {
+  detail::check_output(out, std::ranges::size(base));
+  detail::count_pairs<detail::simd::pair_op::bit_or>(
+      query, std::ranges::data(base), std::ranges::size(base), out.data());
+}
+
+template <std::size_t N, class Block,
+          detail::fingerprints_of<bitset<N, Block>> R>
+void jaccard_similarities(const bitset<N, Block>& query, const R& base,
+                          std::span<double> out) {
+  detail::check_output(out, std::ranges::size(base));
+  detail::jaccard_pairs(query, std::ranges::data(base),
+                        std::ranges::size(base), out.data());
+}
+
+template <detail::fingerprints Q,
+          detail::fingerprints_of<std::ranges::range_value_t<Q>> R>
+void hamming_distances(const Q& queries, const R& base,
+                       std::span<std::size_t> out) {
+  detail::count_pairs_many<detail::simd::pair_op::bit_xor>(queries, base, out);
+}
+
+template <detail::fingerprints Q,
+          detail::fingerprints_of<std::ranges::range_value_t<Q>> R>
+void intersection_counts(const Q& queries, const R& base,
+                         std::span<std::size_t> out) {
+  detail::count_pairs_many<detail::simd::pair_op::bit_and>(queries, base, out);
+}
+
+template <detail::fingerprints Q,
+          detail::fingerprints_of<std::ranges::range_value_t<Q>> R>
+void union_counts(const Q& queries, const R& base,
+                  std::span<std::size_t> out) {
+  detail::count_pairs_many<detail::simd::pair_op::bit_or>(queries, base, out);
+}
+
+template <detail::fingerprints Q,
+          detail::fingerprints_of<std::ranges::range_value_t<Q>> R>
+void jaccard_similarities(const Q& queries, const R& base,
+                          std::span<double> out) {
+  using Bitset = std::ranges::range_value_t<R>;
+  std::size_t n = std::ranges::size(base);
+  detail::check_output(out, std::ranges::size(queries) * n);
+  const Bitset* b = std::ranges::data(base);
+  for (std::size_t first = 0; first < n; first += detail::tile_items<Bitset>) {
+    std::size_t len = std::min(detail::tile_items<Bitset>, n - first);
+    std::size_t row = 0;
+    for (const Bitset& q : queries) {
+      detail::jaccard_pairs(q, b + first, len, out.data() + row + first);
+      row += n;
+    }
+  }
+}
+
+} // namespace nstd
@@ -0,0 +1,294 @@
+#pragma once
+
+#include "bitset.hpp"
+#include "dynamic_bitset.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace nstd {
+
+// Opt-in multi-threaded bulk operations for bitsets of many megabytes, where
+// one core cannot keep the memory bus busy:
+//
+//   count(par, b)                        any(par, b)
+//   and_assign(par, dst, src)            or_assign, xor_assign
+//   flip(par, b)                         shift_left(par, b, pos), shift_right
+//
+// Each works on a bitset or dynamic_bitset and leaves it exactly as the
+// serial member would. The blocks are split into contiguous chunks, one per
+// thread, whose boundaries fall on 64-byte cache lines of the blocks' actual
+// addresses, so no two threads write the same line wherever the storage
+// starts; count() and any() combine one partial result per chunk at the end.
+//
+// Below parallel_min_bytes of blocks, or with a single thread, the call is
+// the serial member and nothing else. Above it every thread gets at least
+// parallel_chunk_bytes, enough to outweigh starting it. The calling thread
+// takes the first chunk, and if a thread cannot be started it takes the
+// chunks that thread would have had.
+
+struct parallel_policy {
+  // threads to use, the calling one included; 0 means hardware_concurrency()
+  unsigned threads = 0;
+};
+
+inline constexpr parallel_policy par{};
+
+namespace detail {
+
+inline constexpr std::size_t parallel_min_bytes = std::size_t{1} << 21;
+inline constexpr std::size_t parallel_chunk_bytes = std::size_t{1} << 18;
+
+// mutable blocks and padding cleanup for the operations below
+struct block_access {
+  template <std::size_t N, class Block>
+  static std::span<Block> blocks(bitset<N, Block>& b) noexcept {
+    return b.data;
+  }
+
+  template <class Block, class Alloc>
+  static std::span<Block> blocks(dynamic_bitset<Block, Alloc>& b) noexcept {
+    return {b.data_, b.num_blocks()};
+  }
+
+  // zeroes the bits of the last block past size()
+  template <class B> static void sanitize(B& b) noexcept { b.sanitize(); }
+};
+
+template <class B>
+concept parallel_bitset =
+    requires(B& b) { block_access::blocks(b); };
+
+// [first(k), last(k)) for k < count cover n blocks. Every boundary but 0
+// and n is a multiple of per less skew, the blocks between the storage's
+// first block and the cache line it starts in.
+struct chunking {
+  std::size_t n, per, skew, count;
+
+  std::size_t first(std::size_t k) const noexcept {
+    return k ? k * per - skew : 0;
+  }
+  std::size_t last(std::size_t k) const noexcept {
+    return std::min(n, (k + 1) * per - skew);
+  }
+};
+
+// count is 1 when the operation should run serially
+template <class Block>
+chunking make_chunks(parallel_policy policy, const Block* data,
+                     std::size_t n) noexcept {
+  std::size_t bytes = n * sizeof(Block);
+  if (bytes < parallel_min_bytes || policy.threads == 1)
+    return {n, n, 0, 1};
+  std::size_t threads = policy.threads ? policy.threads
+                                       : std::thread::hardware_concurrency();
+  threads = std::clamp<std::size_t>(threads, 1, bytes / parallel_chunk_bytes);
+  std::size_t line = std::max<std::size_t>(1, 64 / sizeof(Block));
+  std::size_t skew = reinterpret_cast<std::uintptr_t>(data) % 64 /
+                     sizeof(Block);
+  std::size_t per = (n + skew + threads - 1) / threads;
+  per = (per + line - 1) / line * line;
+  return {n, per, skew, (n + skew + per - 1) / per};
+}
+
+// runs f(k, first, last) for every chunk, chunk 0 on the calling thread
+template <class F> void run_chunks(const chunking& c, F f) noexcept {
+  std::vector<std::jthread> threads;
+  std::size_t k = 1;
+  try {
+    threads.reserve(c.count - 1);
+    for (; k < c.count; k++)
+      threads.emplace_back(f, k, c.first(k), c.last(k));
+  } catch (...) {
+    // out of threads or memory: the rest run here
+  }
+  f(std::size_t{0}, c.first(0), c.last(0));
+  for (; k < c.count; k++)
+    f(k, c.first(k), c.last(k));
+}
+
+// Shifts split into chunks, in two passes. The first copies the source
+// blocks each chunk reads from outside itself, since their owners are about
+// to overwrite them. The second shifts every chunk on its own with the
+// serial kernel, which fills the blocks nearest the incoming side with
+// zeros, and ORs the saved neighbours' bits into those blocks.
+template <class Block>
+void parallel_shift(const chunking& c, std::span<Block> data, std::size_t pos,
+                    bool left) {
+  constexpr std::size_t bits = block_bits<Block>;
+  const std::size_t n = data.size();
+  const std::size_t words = pos / bits;
+  const std::size_t offset = pos % bits;
+  if (words >= n) {
+    run_chunks(c, [&](std::size_t, std::size_t a, std::size_t b) {
+      std::fill(data.begin() + a, data.begin() + b, Block{0});
+    });
+    return;
+  }
+
+  // chunk k reads source blocks [lo[k], hi[k]) owned by other chunks
+  std::vector<std::size_t> lo(c.count), hi(c.count);
+  std::vector<std::vector<Block>> saved(c.count);
+  for (std::size_t k = 0; k < c.count; k++) {
+    std::size_t a = c.first(k), b = c.last(k);
+    if (left) {
+      lo[k] = a > words ? a - words - 1 : 0;
+      hi[k] = std::min(a, b > words ? b - words : 0);
+    } else {
+      lo[k] = std::max(b, a + words);
+      hi[k] = std::min(n, b + words + 1);
+    }
+    hi[k] = std::max(lo[k], hi[k]);
+    saved[k].resize(hi[k] - lo[k]);
+  }
+  run_chunks(c, [&](std::size_t k, std::size_t, std::size_t) {
+    std::copy(data.begin() + lo[k], data.begin() + hi[k], saved[k].begin());
+  });
+
+  run_chunks(c, [&](std::size_t k, std::size_t a, std::size_t b) {
+    // source block i, which lies in the saved copy
+    auto saved_at = [&](std::size_t i) { return saved[k][i - lo[k]]; };
+    if (left) {
+      detail::shift_left(data.data() + a, b - a, pos);
+      for (std::size_t i = a; i < b && i <= a + words; i++) {
+        if (i >= words && i - words < a)
+          data[i] |= static_cast<Block>(saved_at(i - words) << offset);
+        if (offset && i > words && i - words - 1 < a)
+          data[i] |= static_cast<Block>(saved_at(i - words - 1) >>
+                                        (bits - offset));
+      }
+    } else {
+      detail::shift_right(data.data() + a, b - a, pos);
+      for (std::size_t i = b; i-- > a && i + words + 1 >= b;) {
+        if (i + words >= b && i + words < n)
+          data[i] |= static_cast<Block>(saved_at(i + words) >> offset);
+        if (offset && i + words + 1 >= b && i + words + 1 < n)
+          data[i] |= static_cast<Block>(saved_at(i + words + 1)
+                                        << (bits - offset));
+      }
+    }
+  });
+}
+
+template <class B> void check_parallel_sizes(const B& dst, const B& src) {
+  if (dst.size() != src.size())
+    throw std::invalid_argument{"dynamic_bitset operands differ in size"};
+}
+
+} // namespace detail
+
+template <detail::parallel_bitset B>
+std::size_t count(parallel_policy policy, const B& b) {
+  auto blocks = b.blocks();
+  auto c = detail::make_chunks(policy, blocks.data(), blocks.size());
+  if (c.count == 1)
+    return b.count();
+  std::vector<std::size_t> partial(c.count);
+  detail::run_chunks(c, [&](std::size_t k, std::size_t first,
+                            std::size_t last) {
+    partial[k] = detail::block_count(blocks.data() + first, last - first);
+  });
+  return std::accumulate(partial.begin(), partial.end(), std::size_t{0});
+}
+
+template <detail::parallel_bitset B>
+bool any(parallel_policy policy, const B& b) {
+  auto blocks = b.blocks();
+  auto c = detail::make_chunks(policy, blocks.data(), blocks.size());
+  if (c.count == 1)
+    return b.any();
+  std::vector<char> partial(c.count);
+  detail::run_chunks(c, [&](std::size_t k, std::size_t first,
+                            std::size_t last) {
+    partial[k] = detail::block_any(blocks.data() + first, last - first);
+  });
+  return std::find(partial.begin(), partial.end(), 1) != partial.end();
+}
+
+// dst op= src; dynamic_bitset operands of different sizes throw
+// invalid_argument, as the members do
+template <detail::parallel_bitset B>
+B& and_assign(parallel_policy policy, B& dst, const B& src) {
+  detail::check_parallel_sizes(dst, src);
+  auto d = detail::block_access::blocks(dst);
+  auto c = detail::make_chunks(policy, d.data(), d.size());
+  if (c.count == 1)
+    return dst &= src;
+  detail::run_chunks(c, [&](std::size_t, std::size_t first, std::size_t last) {
+    detail::block_and(d.data() + first, src.blocks().data() + first,
+                      last - first);
+  });
+  return dst;
+}
+
+template <detail::parallel_bitset B>
+B& or_assign(parallel_policy policy, B& dst, const B& src) {
+  detail::check_parallel_sizes(dst, src);
+  auto d = detail::block_access::blocks(dst);
+  auto c = detail::make_chunks(policy, d.data(), d.size());
+  if (c.count == 1)
+    return dst |= src;
+  detail::run_chunks(c, [&](std::size_t, std::size_t first, std::size_t last) {
+    detail::block_or(d.data() + first, src.blocks().data() + first,
+                     last - first);
+  });
+  return dst;
+}
+
+template <detail::parallel_bitset B>
+B& xor_assign(parallel_policy policy, B& dst, const B& src) {
+  detail::check_parallel_sizes(dst, src);
+  auto d = detail::block_access::blocks(dst);
+  auto c = detail::make_chunks(policy, d.data(), d.size());
+  if (c.count == 1)
+    return dst ^= src;
+  detail::run_chunks(c, [&](std::size_t, std::size_t first, std::size_t last) {
+    detail::block_xor(d.data() + first, src.blocks().data() + first,
+                      last - first);
+  });
+  return dst;
+}
+
+template <detail::parallel_bitset B>
+B& flip(parallel_policy policy, B& b) noexcept {
+  auto d = detail::block_access::blocks(b);
+  auto c = detail::make_chunks(policy, d.data(), d.size());
+  if (c.count == 1)
+    return b.flip();
+  detail::run_chunks(c, [&](std::size_t, std::size_t first, std::size_t last) {
+    detail::block_flip(d.data() + first, last - first);
+  });
+  detail::block_access::sanitize(b);
+  return b;
+}
+
+// b <<= pos and b >>= pos. The parallel path keeps a copy of the blocks
+// each chunk takes from its neighbours, at most the whole bitset when pos
+// is longer than a chunk, and throws bad_alloc if that copy cannot be made.
+template <detail::parallel_bitset B>
+B& shift_left(parallel_policy policy, B& b, std::size_t pos) {
+  auto d = detail::block_access::blocks(b);
+  auto c = detail::make_chunks(policy, d.data(), d.size());
+  if (c.count == 1)
+    return b <<= pos;
+  detail::parallel_shift(c, d, pos, true);
+  detail::block_access::sanitize(b);
+  return b;
+}
+
+template <detail::parallel_bitset B>
+B& shift_right(parallel_policy policy, B& b, std::size_t pos) {
+  auto d = detail::block_access::blocks(b);
+  auto c = detail::make_chunks(policy, d.data(), d.size());
+  if (c.count == 1)
+    return b >>= pos;
+  detail::parallel_shift(c, d, pos, false);
+  return b;
+}
+
+} // namespace nstd
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "bitset.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+namespace nstd {
+
+// Read-only bitset over bytes in the binary layout of bitset::as_bytes()
+// (see detail::bytes_for), such as a region of a memory-mapped file. The
+// whole 64-bit words of the region are read in place; only the final
+// partial word is copied into the view, so nothing is read past the end of
+// the region even when it stops mid-page. Opening a view costs the same for
+// a kilobyte as for gigabytes.
+//
+// The region must be 8-byte aligned, which any mmap() offset is, and must
+// outlive the view. Words are read in host byte order, so the view needs a
+// little-endian host.
+class bitset_view {
+  static_assert(std::endian::native == std::endian::little,
+                "bitset_view reads the little-endian layout in place");
+
+  using word = detail::simd::word;
+  constexpr static std::size_t word_bits = 64;
+
+public:
+  constexpr static std::size_t npos = detail::npos;
+
+  bitset_view() noexcept = default;
+
+  // Throws invalid_argument unless bytes holds exactly (num_bits + 7) / 8
+  // bytes, is 8-byte aligned and has no bit set past num_bits.
+  bitset_view(std::span<const std::byte> bytes, std::size_t num_bits)
+      : bytes_(bytes), size_(num_bits), full_(bytes.size() / sizeof(word)) {
+    if (bytes.size() != detail::bytes_for(num_bits))
+      throw std::invalid_argument{"byte count does not match the bit count"};
+    if (reinterpret_cast<std::uintptr_t>(bytes.data()) % alignof(word))
+      throw std::invalid_argument{"bitset_view needs 8-byte aligned bytes"};
+    if (num_bits % 8 &&
+        std::to_integer<unsigned>(bytes.back()) >> (num_bits % 8))
+      throw std::invalid_argument{"bits set past the end of the bitset"};
+    if (bytes.size() % sizeof(word))
+      std::memcpy(&tail_, bytes.data() + full_ * sizeof(word),
+                  bytes.size() % sizeof(word));
+  }
+
+  std::size_t size() const noexcept { return size_; }
+
+  // the viewed bytes, for handing on to from_bytes() or a file
+  std::span<const std::byte> as_bytes() const noexcept { return bytes_; }
+
+  bool operator[](std::size_t pos) const noexcept {
+    return (word_at(pos / word_bits) >> (pos % word_bits)) & 1;
+  }
+
+  bool test(std::size_t pos) const {
+    if (pos >= size_)
+      throw std::out_of_range{"Attempted to test bit out of range"};
+    return (*this)[pos];
+  }
+
+  std::size_t count() const noexcept {
+    return detail::block_count(words(), full_) +
+           static_cast<std::size_t>(std::popcount(tail_));
+  }
+
+  bool any() const noexcept {
+    return tail_ != 0 || detail::block_any(words(), full_);
+  }
+
+  bool none() const noexcept { return !any(); }
+
+  bool all() const noexcept {
+    // the first size() / 64 words are whole and always read in place
+    std::size_t whole = size_ / word_bits, rest = size_ % word_bits;
+    return detail::block_all(words(), whole) &&
+           (rest == 0 || word_at(whole) == detail::low_bits(rest));
+  }
+
+  // set-bit search; each returns npos when there is no such bit
+  std::size_t find_first() const noexcept { return find_from(0); }
+
+  // first set bit strictly after pos
+  std::size_t find_next(std::size_t pos) const noexcept {
+    return pos + 1 >= size_ ? npos : find_from(pos + 1);
+  }
+
+private:
+  std::span<const std::byte> bytes_;
+  std::size_t size_ = 0;
+  // words read in place, and the partial word after them
+  std::size_t full_ = 0;
+  word tail_ = 0;
+
+  const word* words() const noexcept {
+    return reinterpret_cast<const word*>(bytes_.data());
+  }
+
+  word word_at(std::size_t i) const noexcept {
+    return i < full_ ? words()[i] : tail_;
+  }
+
+  std::size_t find_from(std::size_t pos) const noexcept {
+    if (pos < full_ * word_bits) {
+      std::size_t found = detail::find_from(words(), full_, pos);
+      if (found != npos)
+        return found;
+      pos = full_ * word_bits;
+    }
+    std::size_t offset = pos - full_ * word_bits;
+    if (offset >= word_bits)
+      return npos;
+    word rest = tail_ & (~word{0} << offset);
+    return rest ? full_ * word_bits +
+                      static_cast<std::size_t>(std::countr_zero(rest))
+                : npos;
+  }
+};
+
+} // namespace nstd
@@ -0,0 +1,498 @@
+#pragma once
+
+#include "bitset.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace nstd {
+
+// A bitset whose size is chosen at runtime. Blocks are laid out exactly as in
+// bitset<N>, and every bulk operation goes through the same detail:: kernels,
+// so both types share one set of (SIMD-dispatched) word loops.
+//
+// Only the first num_blocks() blocks are ever initialized; reserve() leaves
+// the rest of the capacity untouched. Bits of the last block at or above
+// size() are kept zero.
+template <class Block = std::size_t, class Allocator = std::allocator<Block>>
+class dynamic_bitset {
+  static_assert(std::is_unsigned_v<Block>,
+                "dynamic_bitset blocks must be unsigned integers");
+
+  using alloc_traits = std::allocator_traits<Allocator>;
+
+public:
+  using block_type = Block;
+  using allocator_type = Allocator;
+  using size_type = std::size_t;
+  using reference = detail::bit_reference<Block>;
+
+  constexpr static size_type bits_per_block =
+      std::numeric_limits<Block>::digits;
+  constexpr static size_type npos = detail::npos;
+
+  dynamic_bitset() noexcept(noexcept(Allocator())) : dynamic_bitset(Allocator()) {}
+
+  explicit dynamic_bitset(const Allocator& alloc) noexcept : alloc_(alloc) {}
+
+  explicit dynamic_bitset(size_type num_bits, unsigned long long val = 0,
+                          const Allocator& alloc = Allocator())
+      : alloc_(alloc) {
+    resize(num_bits);
+    for (size_type i = 0; i < num_blocks() && val; i++) {
+      data_[i] = static_cast<Block>(val);
+      val = bits_per_block < 64 ? val >> bits_per_block : 0;
+    }
+    sanitize();
+  }
+
+  dynamic_bitset(const dynamic_bitset& other)
+      : alloc_(alloc_traits::select_on_container_copy_construction(
+            other.alloc_)) {
+    assign_blocks(other);
+  }
+
+  dynamic_bitset(dynamic_bitset&& other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        capacity_(std::exchange(other.capacity_, 0)),
+        alloc_(std::move(other.alloc_)) {}
+
+  ~dynamic_bitset() { deallocate(); }
+
+  dynamic_bitset& operator=(const dynamic_bitset& rhs) {
+    if (this != &rhs) {
+      if constexpr (alloc_traits::propagate_on_container_copy_assignment::
+                        value) {
+        if (alloc_ != rhs.alloc_) {
+          deallocate();
+        }
+        alloc_ = rhs.alloc_;
+      }
+      assign_blocks(rhs);
+    }
+    return *this;
+  }
+
+  dynamic_bitset& operator=(dynamic_bitset&& rhs) noexcept(
+      alloc_traits::propagate_on_container_move_assignment::value ||
+      alloc_traits::is_always_equal::value) {
+    if (this == &rhs) {
+      return *this;
+    }
+    if constexpr (alloc_traits::propagate_on_container_move_assignment::
+                      value ||
+                  alloc_traits::is_always_equal::value) {
+      deallocate();
+      if constexpr (alloc_traits::propagate_on_container_move_assignment::
+                        value) {
+        alloc_ = std::move(rhs.alloc_);
+      }
+      data_ = std::exchange(rhs.data_, nullptr);
+      size_ = std::exchange(rhs.size_, 0);
+      capacity_ = std::exchange(rhs.capacity_, 0);
+    } else if (alloc_ == rhs.alloc_) {
+      deallocate();
+      data_ = std::exchange(rhs.data_, nullptr);
+      size_ = std::exchange(rhs.size_, 0);
+      capacity_ = std::exchange(rhs.capacity_, 0);
+    } else {
+      assign_blocks(rhs);
+    }
+    return *this;
+  }
+
+  void swap(dynamic_bitset& other) noexcept {
+    using std::swap;
+    if constexpr (alloc_traits::propagate_on_container_swap::value) {
+      swap(alloc_, other.alloc_);
+    }
+    swap(data_, other.data_);
+    swap(size_, other.size_);
+    swap(capacity_, other.capacity_);
+  }
+
+  allocator_type get_allocator() const noexcept { return alloc_; }
+
+  // size and capacity
+  size_type size() const noexcept { return size_; }
+
+  size_type num_blocks() const noexcept { return blocks_for(size_); }
+
+  size_type capacity() const noexcept { return capacity_ * bits_per_block; }
+
+  bool empty() const noexcept { return size_ == 0; }
+
+  // grows the allocation to hold num_bits without initializing the new blocks
+  void reserve(size_type num_bits) {
+    if (blocks_for(num_bits) > capacity_) {
+      reallocate(blocks_for(num_bits));
+    }
+  }
+
+  void shrink_to_fit() {
+    if (num_blocks() < capacity_) {
+      reallocate(num_blocks());
+    }
+  }
+
+  void resize(size_type num_bits, bool val = false) {
+    size_type old_size = size_;
+    size_type old_blocks = num_blocks();
+    size_type new_blocks = blocks_for(num_bits);
+    if (new_blocks > capacity_) {
+      reallocate(std::max(new_blocks, 2 * capacity_));
+    }
+
+    Block fill = val ? std::numeric_limits<Block>::max() : Block{0};
+    if (new_blocks > old_blocks) {
+      std::fill(data_ + old_blocks, data_ + new_blocks, fill);
+    }
+    size_ = num_bits;
+    if (val && num_bits > old_size && old_size % bits_per_block != 0) {
+      // the old last block has zeros above old_size that now become visible
+      data_[old_blocks - 1] |= static_cast<Block>(
+          std::numeric_limits<Block>::max() << (old_size % bits_per_block));
+    }
+    sanitize();
+  }
+
+  void clear() noexcept { size_ = 0; }
+
+  void push_back(bool val) {
+    if (size_ % bits_per_block == 0) {
+      if (num_blocks() == capacity_) {
+        reallocate(capacity_ == 0 ? 1 : 2 * capacity_);
+      }
+      data_[num_blocks()] = 0;
+    }
+    size_++;
+    if (val) {
+      set_unchecked(size_ - 1);
+    }
+  }
+
+  void pop_back() {
+    if (empty())
+      throw std::out_of_range{"Attempted to pop_back an empty dynamic_bitset"};
+    reset_unchecked(--size_);
+  }
+
+  // bitset operations
+  dynamic_bitset& operator&=(const dynamic_bitset& rhs) {
+    check_same_size(rhs);
+    detail::block_and(data_, rhs.data_, num_blocks());
+    return *this;
+  }
+
+  dynamic_bitset& operator|=(const dynamic_bitset& rhs) {
+    check_same_size(rhs);
+    detail::block_or(data_, rhs.data_, num_blocks());
+    return *this;
+  }
+
+  dynamic_bitset& operator^=(const dynamic_bitset& rhs) {
+    check_same_size(rhs);
+    detail::block_xor(data_, rhs.data_, num_blocks());
+    return *this;
+  }
+
+  dynamic_bitset& operator<<=(size_type pos) noexcept {
+    detail::shift_left(data_, num_blocks(), pos);
+    return sanitize();
+  }
+
+  dynamic_bitset& operator>>=(size_type pos) noexcept {
+    detail::shift_right(data_, num_blocks(), pos);
+    return *this;
+  }
+
+  dynamic_bitset& set() noexcept {
+    std::fill_n(data_, num_blocks(), std::numeric_limits<Block>::max());
+    return sanitize();
+  }
+
+  dynamic_bitset& set(size_type pos, bool val = true) {
+    if (pos >= size_)
+      throw std::out_of_range{"Attempted to set bit out of range"};
+    return val ? set_unchecked(pos) : reset_unchecked(pos);
+  }
+
+  dynamic_bitset& reset() noexcept {
+    std::fill_n(data_, num_blocks(), Block{0});
+    return *this;
+  }
+
+  dynamic_bitset& reset(size_type pos) {
+    if (pos >= size_)
+      throw std::out_of_range{"Attempted to reset bit out of range"};
+    return reset_unchecked(pos);
+  }
+
+  dynamic_bitset operator~() const {
+    return dynamic_bitset(*this).flip();
+  }
+
+  dynamic_bitset& flip() noexcept {
+    detail::block_flip(data_, num_blocks());
+    return sanitize();
+  }
+
+  dynamic_bitset& flip(size_type pos) {
+    if (pos >= size_)
+      throw std::out_of_range{"Attempted to flip bit out of range"};
+    data_[pos / bits_per_block] ^=
+        static_cast<Block>(static_cast<Block>(1) << (pos % bits_per_block));
+    return *this;
+  }
+
+  // element access
+  bool operator[](size_type pos) const noexcept {
+    return (data_[pos / bits_per_block] >> (pos % bits_per_block)) & 1;
+  }
+
+  reference operator[](size_type pos) noexcept {
+    return reference{data_[pos / bits_per_block], pos % bits_per_block};
+  }
+
+  bool test(size_type pos) const {
+    if (pos >= size_)
+      throw std::out_of_range{"Attempted to test bit out of range"};
+    return (*this)[pos];
+  }
+
+  size_type count() const noexcept {
+    return detail::block_count(data_, num_blocks());
+  }
+
+  bool all() const noexcept {
+    if (empty())
+      return true;
+    size_type full = size_ / bits_per_block;
+    if (!detail::block_all(data_, full))
+      return false;
+    size_type rest = size_ % bits_per_block;
+    return rest == 0 ||
+           data_[full] == static_cast<Block>(
+                              (static_cast<Block>(1) << rest) - 1);
+  }
+
+  bool any() const noexcept { return detail::block_any(data_, num_blocks()); }
+
+  bool none() const noexcept { return !any(); }
+
+  bool operator==(const dynamic_bitset& rhs) const noexcept {
+    return size_ == rhs.size_ &&
+           detail::block_equal(data_, rhs.data_, num_blocks());
+  }
+
+  // set-bit search; each returns npos when there is no such bit
+  size_type find_first() const noexcept {
+    return detail::find_from(data_, num_blocks(), 0);
+  }
+
+  // first set bit strictly after pos
+  size_type find_next(size_type pos) const noexcept {
+    return size_ == 0 || pos >= size_ - 1
+               ? npos
+               : detail::find_from(data_, num_blocks(), pos + 1);
+  }
+
+  size_type find_last() const noexcept {
+    return detail::find_last(data_, num_blocks());
+  }
+
+  // indices of the set bits in increasing order
+  detail::set_bit_view<Block> set_bits() const noexcept {
+    return {data_, num_blocks()};
+  }
+
+  dynamic_bitset operator<<(size_type pos) const {
+    auto ret = *this;
+    ret <<= pos;
+    return ret;
+  }
+
+  dynamic_bitset operator>>(size_type pos) const {
+    auto ret = *this;
+    ret >>= pos;
+    return ret;
+  }
+
+  unsigned long to_ulong() const {
+    constexpr size_type ulong_bits = std::numeric_limits<unsigned long>::digits;
+    unsigned long ret = 0;
+    for (size_type i = 0; i < num_blocks(); i++) {
+      if (i * bits_per_block >= ulong_bits) {
+        if (data_[i])
+          throw std::overflow_error{"Incurred overflow upon attempting to "
+                                    "convert dynamic_bitset to unsigned long"};
+      } else {
+        ret |= static_cast<unsigned long>(data_[i]) << (i * bits_per_block);
+      }
+    }
+    return ret;
+  }
+
+  template <class charT = char, class traits = std::char_traits<charT>,
+            class StrAllocator = std::allocator<charT>>
+  std::basic_string<charT, traits, StrAllocator>
+  to_string(charT zero = charT('0'), charT one = charT('1')) const {
+    std::basic_string<charT, traits, StrAllocator> ret(size_, zero);
+    detail::format_bits<traits>(data_, size_, zero, one, ret.data());
+    return ret;
+  }
+
+  // raw block access, for structures layered on top of dynamic_bitset
+  std::span<const Block> blocks() const noexcept {
+    return {data_, num_blocks()};
+  }
+
+  // the bits in the binary layout described at detail::bytes_for, in place
+  std::span<const std::byte> as_bytes() const noexcept
+    requires(std::endian::native == std::endian::little)
+  {
+    return {reinterpret_cast<const std::byte*>(data_),
+            detail::bytes_for(size_)};
+  }
+
+  // Reads num_bits bits written by as_bytes(). Throws invalid_argument
+  // unless there are exactly (num_bits + 7) / 8 bytes with no bit set past
+  // num_bits.
+  static dynamic_bitset from_bytes(std::span<const std::byte> bytes,
+                                   size_type num_bits,
+                                   const Allocator& alloc = Allocator()) {
+    dynamic_bitset ret(num_bits, 0, alloc);
+    detail::load_bytes(bytes, num_bits, ret.data_);
+    return ret;
+  }
+
+  friend struct detail::block_access;
+
+private:
+  Block* data_ = nullptr;
+  size_type size_ = 0;
+  // in blocks
+  size_type capacity_ = 0;
+  [[no_unique_address]] Allocator alloc_;
+
+  constexpr static size_type blocks_for(size_type num_bits) noexcept {
+    return (num_bits + bits_per_block - 1) / bits_per_block;
+  }
+
+  dynamic_bitset& sanitize() noexcept {
+    if (size_ % bits_per_block != 0) {
+      data_[size_ / bits_per_block] &= static_cast<Block>(
+          (static_cast<Block>(1) << (size_ % bits_per_block)) - 1);
+    }
+    return *this;
+  }
+
+  dynamic_bitset& set_unchecked(size_type pos) noexcept {
+    data_[pos / bits_per_block] |=
+        static_cast<Block>(static_cast<Block>(1) << (pos % bits_per_block));
+    return *this;
+  }
+
+  dynamic_bitset& reset_unchecked(size_type pos) noexcept {
+    data_[pos / bits_per_block] &= static_cast<Block>(
+        ~(static_cast<Block>(1) << (pos % bits_per_block)));
+    return *this;
+  }
+
+  void check_same_size(const dynamic_bitset& rhs) const {
+    if (size_ != rhs.size_)
+      throw std::invalid_argument{"dynamic_bitset operands differ in size"};
+  }
+
+  // moves the live blocks into a fresh allocation of new_capacity blocks
+  void reallocate(size_type new_capacity) {
+    Block* fresh = alloc_traits::allocate(alloc_, new_capacity);
+    std::copy_n(data_, num_blocks(), fresh);
+    deallocate();
+    data_ = fresh;
+    capacity_ = new_capacity;
+  }
+
+  void deallocate() noexcept {
+    if (data_) {
+      alloc_traits::deallocate(alloc_, data_, capacity_);
+      data_ = nullptr;
+      capacity_ = 0;
+    }
+  }
+
+  void assign_blocks(const dynamic_bitset& other) {
+    if (other.num_blocks() > capacity_) {
+      deallocate();
+      data_ = alloc_traits::allocate(alloc_, other.num_blocks());
+      capacity_ = other.num_blocks();
+    }
+    std::copy_n(other.data_, other.num_blocks(), data_);
+    size_ = other.size_;
+  }
+};
+
+template <class Block, class Allocator>
+dynamic_bitset<Block, Allocator>
+operator&(const dynamic_bitset<Block, Allocator>& lhs,
+          const dynamic_bitset<Block, Allocator>& rhs) {
+  dynamic_bitset<Block, Allocator> res(lhs);
+  res &= rhs;
+  return res;
+}
+
+template <class Block, class Allocator>
+dynamic_bitset<Block, Allocator>
+operator|(const dynamic_bitset<Block, Allocator>& lhs,
+          const dynamic_bitset<Block, Allocator>& rhs) {
+  dynamic_bitset<Block, Allocator> res(lhs);
+  res |= rhs;
+  return res;
+}
+
+template <class Block, class Allocator>
+dynamic_bitset<Block, Allocator>
+operator^(const dynamic_bitset<Block, Allocator>& lhs,
+          const dynamic_bitset<Block, Allocator>& rhs) {
+  dynamic_bitset<Block, Allocator> res(lhs);
+  res ^= rhs;
+  return res;
+}
+
+template <class Block, class Allocator>
+void swap(dynamic_bitset<Block, Allocator>& lhs,
+          dynamic_bitset<Block, Allocator>& rhs) noexcept {
+  lhs.swap(rhs);
+}
+
+template <class charT, class traits, class Block, class Allocator>
+std::basic_ostream<charT, traits>&
+operator<<(std::basic_ostream<charT, traits>& os,
+           const dynamic_bitset<Block, Allocator>& x) {
+  return detail::write_bits(os, x.blocks().data(), x.size());
+}
+
+// equal to the hash of a bitset<N> holding the same bits, see
+// detail::hash_bits
+template <class Block, class Allocator>
+struct hash<dynamic_bitset<Block, Allocator>> {
+  std::size_t
+  operator()(const dynamic_bitset<Block, Allocator>& x) const noexcept {
+    return detail::hash_bits(x.blocks().data(), x.size());
+  }
+};
+
+} // namespace nstd
+
+template <class Block, class Allocator>
+struct std::hash<nstd::dynamic_bitset<Block, Allocator>>
+    : nstd::hash<nstd::dynamic_bitset<Block, Allocator>> {};
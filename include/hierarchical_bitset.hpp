@@ -0,0 +1,210 @@
+#pragma once
+
+#include "bitset.hpp"
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace nstd {
+
+// Fixed-size bitset with summary levels over its 64-bit words, for large
+// sparse masks searched far more often than they are scanned. Level 0 is an
+// ordinary bitset<N, std::uint64_t>. Bit j of level k + 1 is set exactly
+// when word j of level k is non-zero, and levels are added until one word
+// covers the level below. N = 2^18 needs three levels, 2^24 four.
+//
+// find_first() and find_next() climb from the starting word to the first
+// level with a later set bit and then descend with one countr_zero per
+// level, so they read O(log64 N) words however long the empty run is.
+// set() and reset() update a summary only when a word changes between zero
+// and non-zero, which costs one extra word per level at most.
+//
+// For allocators, keep free slots as set bits: find_first() is then the
+// lowest free slot, and reset() claims it.
+template <std::size_t N> class hierarchical_bitset {
+  static_assert(N > 0, "hierarchical_bitset needs at least one bit");
+
+  using word = std::uint64_t;
+  constexpr static std::size_t word_bits = 64;
+
+  // words in each level, level 0 first
+  constexpr static auto level_words = [] {
+    std::array<std::size_t, 12> sizes{};
+    std::size_t n = (N + word_bits - 1) / word_bits, k = 0;
+    sizes[k++] = n;
+    while (n > 1) {
+      n = (n + word_bits - 1) / word_bits;
+      sizes[k++] = n;
+    }
+    return sizes;
+  }();
+
+  constexpr static std::size_t levels = [] {
+    std::size_t k = 1;
+    while (level_words[k - 1] > 1)
+      k++;
+    return k;
+  }();
+
+  // where each summary level starts in summary_; level 0 is bits_
+  constexpr static auto level_offset = [] {
+    std::array<std::size_t, 12> offsets{};
+    for (std::size_t k = 2; k < levels; k++)
+      offsets[k] = offsets[k - 1] + level_words[k - 1];
+    return offsets;
+  }();
+
+  // one spare word when there are no summaries keeps the array non-empty
+  constexpr static std::size_t summary_words =
+      levels > 1 ? level_offset[levels - 1] + 1 : 1;
+
+public:
+  constexpr static std::size_t npos = detail::npos;
+
+  hierarchical_bitset() noexcept = default;
+
+  explicit hierarchical_bitset(const bitset<N, word>& bits) noexcept
+      : bits_(bits) {
+    rebuild();
+  }
+
+  constexpr std::size_t size() const noexcept { return N; }
+
+  // the bits themselves, for anything bitset already provides
+  const bitset<N, word>& bits() const noexcept { return bits_; }
+
+  bool operator[](std::size_t pos) const noexcept { return bits_[pos]; }
+
+  bool test(std::size_t pos) const { return bits_.test(pos); }
+
+  hierarchical_bitset& set(std::size_t pos) {
+    // checks pos before anything else reads its word
+    bits_.set(pos);
+    // the word was empty unless it holds another bit; marking it again when
+    // pos was already set is harmless
+    if (word_at(pos / word_bits) == word{1} << (pos % word_bits))
+      mark(pos / word_bits);
+    return *this;
+  }
+
+  hierarchical_bitset& set(std::size_t pos, bool val) {
+    return val ? set(pos) : reset(pos);
+  }
+
+  hierarchical_bitset& reset(std::size_t pos) {
+    bits_.reset(pos);
+    if (word_at(pos / word_bits) == 0)
+      unmark(pos / word_bits);
+    return *this;
+  }
+
+  hierarchical_bitset& set() noexcept {
+    bits_.set();
+    rebuild();
+    return *this;
+  }
+
+  hierarchical_bitset& reset() noexcept {
+    bits_.reset();
+    summary_ = {};
+    return *this;
+  }
+
+  std::size_t count() const noexcept { return bits_.count(); }
+
+  bool any() const noexcept {
+    return levels > 1 ? summary(levels - 1)[0] != 0 : word_at(0) != 0;
+  }
+
+  bool none() const noexcept { return !any(); }
+
+  bool all() const noexcept { return bits_.all(); }
+
+  // set-bit search; each returns npos when there is no such bit
+  std::size_t find_first() const noexcept { return find_from(0); }
+
+  // first set bit strictly after pos
+  std::size_t find_next(std::size_t pos) const noexcept {
+    return pos >= N - 1 ? npos : find_from(pos + 1);
+  }
+
+private:
+  bitset<N, word> bits_;
+  std::array<word, summary_words> summary_{};
+
+  word word_at(std::size_t i) const noexcept { return bits_.blocks()[i]; }
+
+  const word* summary(std::size_t level) const noexcept {
+    return summary_.data() + level_offset[level];
+  }
+
+  word* summary(std::size_t level) noexcept {
+    return summary_.data() + level_offset[level];
+  }
+
+  // word idx of level 0 became non-empty
+  void mark(std::size_t idx) noexcept {
+    for (std::size_t k = 1; k < levels; k++, idx /= word_bits) {
+      word& w = summary(k)[idx / word_bits];
+      bool was_empty = w == 0;
+      w |= word{1} << (idx % word_bits);
+      if (!was_empty)
+        return;
+    }
+  }
+
+  // word idx of level 0 became empty
+  void unmark(std::size_t idx) noexcept {
+    for (std::size_t k = 1; k < levels; k++, idx /= word_bits) {
+      word& w = summary(k)[idx / word_bits];
+      w &= ~(word{1} << (idx % word_bits));
+      if (w != 0)
+        return;
+    }
+  }
+
+  void rebuild() noexcept {
+    summary_ = {};
+    for (std::size_t k = 1; k < levels; k++) {
+      for (std::size_t j = 0; j < level_words[k - 1]; j++) {
+        word below = k == 1 ? word_at(j) : summary(k - 1)[j];
+        if (below)
+          summary(k)[j / word_bits] |= word{1} << (j % word_bits);
+      }
+    }
+  }
+
+  std::size_t find_from(std::size_t pos) const noexcept {
+    std::size_t idx = pos / word_bits;
+    if (word w = word_at(idx) & (~word{0} << (pos % word_bits)))
+      return idx * word_bits + static_cast<std::size_t>(std::countr_zero(w));
+
+    // climb until some level has a set bit after the one covering idx; idx
+    // is always a word index of the level below k
+    std::size_t k = 1;
+    for (idx++; k < levels; k++) {
+      std::size_t j = idx / word_bits;
+      if (j >= level_words[k])
+        return npos;
+      if (word w = summary(k)[j] & (~word{0} << (idx % word_bits))) {
+        idx = j * word_bits + static_cast<std::size_t>(std::countr_zero(w));
+        break;
+      }
+      idx = j + 1;
+    }
+    if (k == levels)
+      return npos;
+
+    // descend: the lowest set bit of each summary word names a non-empty
+    // word one level down
+    while (--k > 0) {
+      idx = idx * word_bits +
+            static_cast<std::size_t>(std::countr_zero(summary(k)[idx]));
+    }
+    return idx * word_bits +
+           static_cast<std::size_t>(std::countr_zero(word_at(idx)));
+  }
+};
+
+} // namespace nstd
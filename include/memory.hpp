@@ -1,168 +1,249 @@
 #pragma once
 
+#include "move.hpp"
 #include "type_traits.hpp"
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <new>
 #include <ostream>
-#include <tuple>
+#include <stdexcept>
 
 namespace nstd {
 
-template <class T> class default_delete {
-  using pointer = T*;
+template <class T> struct default_delete {
+  constexpr default_delete() noexcept = default;
 
-  constexpr default_delete() {}
+  template <class U>
+    requires is_convertible_v<U*, T*>
+  constexpr default_delete(const default_delete<U>&) noexcept {}
 
-  void operator()(T* p) {
-    if (is_array_v<T>) {
-      delete[] p;
-    } else {
-      delete p;
-    }
+  constexpr void operator()(T* p) const {
+    static_assert(sizeof(T) > 0, "cannot delete an incomplete type");
+    delete p;
+  }
+};
+
+template <class T> struct default_delete<T[]> {
+  constexpr default_delete() noexcept = default;
+
+  constexpr void operator()(T* p) const {
+    static_assert(sizeof(T) > 0, "cannot delete an incomplete type");
+    delete[] p;
   }
 };
 
 namespace detail {
 
-template <class AlwaysVoid, template <class...> class T, class... Args>
-struct detector : public false_type {};
+// Two members where an empty second one takes no storage of its own. A
+// unique_ptr keeps its pointer and deleter in one, so a stateless deleter
+// leaves the handle the size of a bare pointer.
+template <class T1, class T2> struct compressed_pair {
+  T1 first;
+  [[no_unique_address]] T2 second;
+};
 
-template <template <class...> class T, class... Args>
-struct detector<void_t<typename T<Args...>::pointer>, T, Args...>
-    : public true_type {};
+// Deleter::pointer when the deleter names one, T* otherwise
+template <class T, class Deleter, class = void> struct unique_pointer {
+  using type = T*;
+};
 
-template <template <class...> class T, class... Args>
-struct has_pointer_type : public detector<void, T, Args...> {};
+template <class T, class Deleter>
+struct unique_pointer<T, Deleter,
+                      void_t<typename remove_reference_t<Deleter>::pointer>> {
+  using type = typename remove_reference_t<Deleter>::pointer;
+};
 
-template <template <class...> class T, class... Args>
-constexpr bool has_pointer_type_v = has_pointer_type<T, Args...>::value;
+// a null unique_ptr needs a deleter made from nothing, and a null function
+// pointer would be no deleter at all
+template <class Deleter>
+concept default_deleter =
+    is_default_constructible_v<Deleter> && !is_pointer_v<Deleter>;
 
 } // namespace detail
 
 template <class T, class Deleter = default_delete<T>> class unique_ptr {
 public:
-  using pointer =
-      conditional_t<detail::has_pointer_type_v<remove_reference_t, Deleter>,
-                    typename remove_reference_t<Deleter>::pointer, T*>;
+  using pointer = typename detail::unique_pointer<T, Deleter>::type;
   using element_type = T;
   using deleter_type = Deleter;
 
-  constexpr unique_ptr(pointer p) noexcept;
-  constexpr unique_ptr() noexcept;
-  unique_ptr(unique_ptr&) = delete;
+  constexpr unique_ptr() noexcept
+    requires detail::default_deleter<Deleter>;
+  constexpr unique_ptr(std::nullptr_t) noexcept
+    requires detail::default_deleter<Deleter>;
+  constexpr explicit unique_ptr(pointer p) noexcept
+    requires detail::default_deleter<Deleter>;
+
+  template <class E>
+    requires is_constructible_v<Deleter, E&&>
+  constexpr unique_ptr(pointer p, E&& d) noexcept;
 
-  constexpr unique_ptr(unique_ptr&&) noexcept
-    requires is_move_constructible_v<T>;
+  unique_ptr(const unique_ptr&) = delete;
+  constexpr unique_ptr(unique_ptr&& o) noexcept;
+
+  template <class U, class E>
+    requires(is_convertible_v<
+                 typename detail::unique_pointer<U, E>::type,
+                 typename detail::unique_pointer<T, Deleter>::type> &&
+             !is_array_v<U> && is_constructible_v<Deleter, E&&>)
+  constexpr unique_ptr(unique_ptr<U, E>&& o) noexcept;
 
   constexpr ~unique_ptr() noexcept;
 
-  constexpr unique_ptr& operator=(unique_ptr&) = delete;
-  constexpr unique_ptr& operator=(unique_ptr&&) noexcept
-    requires is_move_assignable_v<T>;
+  unique_ptr& operator=(const unique_ptr&) = delete;
+  constexpr unique_ptr& operator=(unique_ptr&& o) noexcept;
+  constexpr unique_ptr& operator=(std::nullptr_t) noexcept;
 
-  constexpr void release() noexcept;
-  constexpr void reset(pointer p) noexcept;
-  constexpr void swap(const unique_ptr&) noexcept;
+  // gives up ownership without deleting
+  [[nodiscard]] constexpr pointer release() noexcept;
+  constexpr void reset(pointer p = pointer()) noexcept;
+  constexpr void swap(unique_ptr& o) noexcept;
 
   [[gnu::always_inline]] [[nodiscard]] constexpr pointer get() const noexcept;
 
   [[gnu::always_inline]] [[nodiscard]] constexpr Deleter&
   get_deleter() noexcept;
-  [[gnu::always_inline]] [[nodiscard]] constexpr Deleter&
+  [[gnu::always_inline]] [[nodiscard]] constexpr const Deleter&
   get_deleter() const noexcept;
 
-  [[gnu::always_inline]] [[nodiscard]] explicit operator bool() const noexcept;
+  [[gnu::always_inline]] [[nodiscard]] constexpr explicit
+  operator bool() const noexcept;
 
-  [[gnu::always_inline]] [[nodiscard]] add_lvalue_reference_t<T>
-  operator*() const noexcept(noexcept(*declval<pointer>()));
-  [[gnu::always_inline]] [[nodiscard]] pointer operator->() const noexcept;
+  [[gnu::always_inline]] [[nodiscard]] constexpr add_lvalue_reference_t<T>
+  operator*() const noexcept(noexcept(*std::declval<pointer>()));
+  [[gnu::always_inline]] [[nodiscard]] constexpr pointer
+  operator->() const noexcept;
 
 private:
-  std::tuple<T, Deleter> obj_;
+  detail::compressed_pair<pointer, Deleter> obj_;
 };
 
 template <class T, class D>
-constexpr unique_ptr<T, D>::unique_ptr(pointer p) noexcept : obj_{p, D{}} {}
+constexpr unique_ptr<T, D>::unique_ptr() noexcept
+  requires detail::default_deleter<D>
+    : obj_{pointer(), D()} {}
 
 template <class T, class D>
-constexpr unique_ptr<T, D>::unique_ptr() noexcept : obj_{nullptr, D{}} {}
+constexpr unique_ptr<T, D>::unique_ptr(std::nullptr_t) noexcept
+  requires detail::default_deleter<D>
+    : obj_{pointer(), D()} {}
+
+template <class T, class D>
+constexpr unique_ptr<T, D>::unique_ptr(pointer p) noexcept
+  requires detail::default_deleter<D>
+    : obj_{p, D()} {}
+
+template <class T, class D>
+template <class E>
+  requires is_constructible_v<D, E&&>
+constexpr unique_ptr<T, D>::unique_ptr(pointer p, E&& d) noexcept
+    : obj_{p, nstd::forward<E>(d)} {}
 
 template <class T, class D>
 constexpr unique_ptr<T, D>::unique_ptr(unique_ptr&& o) noexcept
-  requires is_move_constructible_v<T>
-{}
+    : obj_{o.release(), nstd::forward<D>(o.get_deleter())} {}
+
+template <class T, class D>
+template <class U, class E>
+  requires(is_convertible_v<typename detail::unique_pointer<U, E>::type,
+                            typename detail::unique_pointer<T, D>::type> &&
+           !is_array_v<U> && is_constructible_v<D, E&&>)
+constexpr unique_ptr<T, D>::unique_ptr(unique_ptr<U, E>&& o) noexcept
+    : obj_{o.release(), nstd::forward<E>(o.get_deleter())} {}
 
 template <class T, class D> constexpr unique_ptr<T, D>::~unique_ptr() noexcept {
-  release();
+  if (get()) {
+    get_deleter()(get());
+  }
 }
 
 template <class T, class D>
 constexpr unique_ptr<T, D>&
-unique_ptr<T, D>::operator=(unique_ptr<T, D>&& o) noexcept
-  requires is_move_assignable_v<T>
-{
+unique_ptr<T, D>::operator=(unique_ptr<T, D>&& o) noexcept {
   if (this != &o) {
-    release();
-    obj_ = move(o.obj_);
-    o.get() = nullptr;
+    reset(o.release());
+    get_deleter() = nstd::forward<D>(o.get_deleter());
   }
   return *this;
 }
 
 template <class T, class D>
-constexpr void unique_ptr<T, D>::release() noexcept {
-  if (get()) {
-    get_deleter()(get());
-  }
+constexpr unique_ptr<T, D>&
+unique_ptr<T, D>::operator=(std::nullptr_t) noexcept {
+  reset();
+  return *this;
+}
+
+template <class T, class D>
+constexpr auto unique_ptr<T, D>::release() noexcept -> pointer {
+  return nstd::exchange(obj_.first, pointer());
 }
 
 template <class T, class D>
 constexpr void unique_ptr<T, D>::reset(pointer p) noexcept {
-  release();
-  get() = p;
+  // the new pointer is in place before the deleter runs, as it may reach
+  // back into *this
+  pointer old = nstd::exchange(obj_.first, p);
+  if (old) {
+    get_deleter()(old);
+  }
 }
 
 template <class T, class D>
-constexpr void unique_ptr<T, D>::swap(const unique_ptr<T, D>& o) noexcept {
-  swap(obj_, o.obj_);
+constexpr void unique_ptr<T, D>::swap(unique_ptr<T, D>& o) noexcept {
+  nstd::swap(obj_.first, o.obj_.first);
+  nstd::swap(obj_.second, o.obj_.second);
 }
 
 template <class T, class D>
 [[gnu::always_inline]] [[nodiscard]] constexpr auto
 unique_ptr<T, D>::get() const noexcept -> pointer {
-  return std::get<0>(obj_);
+  return obj_.first;
 }
 
 template <class T, class D>
 [[gnu::always_inline]] [[nodiscard]] constexpr D&
 unique_ptr<T, D>::get_deleter() noexcept {
-  return std::get<1>(obj_);
+  return obj_.second;
 }
 
 template <class T, class D>
-[[gnu::always_inline]] [[nodiscard]] constexpr D&
+[[gnu::always_inline]] [[nodiscard]] constexpr const D&
 unique_ptr<T, D>::get_deleter() const noexcept {
-  return std::get<1>(obj_);
+  return obj_.second;
 }
 
 template <class T, class D>
-[[nodiscard]] unique_ptr<T, D>::operator bool() const noexcept {
-  return get() != nullptr;
+[[nodiscard]] constexpr unique_ptr<T, D>::operator bool() const noexcept {
+  return get() != pointer();
 }
 
 template <class T, class D>
-add_lvalue_reference_t<T> unique_ptr<T, D>::operator*() const
-    noexcept(noexcept(*declval<pointer>())) {
+constexpr add_lvalue_reference_t<T> unique_ptr<T, D>::operator*() const
+    noexcept(noexcept(*std::declval<pointer>())) {
   return *get();
 }
 
 template <class T, class D>
-auto unique_ptr<T, D>::operator->() const noexcept -> pointer {
-  return *get();
+constexpr auto unique_ptr<T, D>::operator->() const noexcept -> pointer {
+  return get();
 }
 
-template <class T, class D, class... Args>
-unique_ptr<T, D> make_unique(Args&&... args) {
-  return unique_ptr<T, D>(new T(forward<Args>(args)...));
+template <class T, class... Args>
+  requires(!is_array_v<T>)
+unique_ptr<T> make_unique(Args&&... args) {
+  return unique_ptr<T>(new T(nstd::forward<Args>(args)...));
+}
+
+// n value-initialized elements
+template <class T>
+  requires is_unbounded_array_v<T>
+unique_ptr<T> make_unique(std::size_t n) {
+  return unique_ptr<T>(new remove_extent_t<T>[n]());
 }
 
 template <class T1, class D1, class T2, class D2>
@@ -177,6 +258,11 @@ bool operator==(const unique_ptr<T1, D1>& x, const unique_ptr<T2, D2>& y) {
   return x.get() == y.get();
 }
 
+template <class T, class D>
+bool operator==(const unique_ptr<T, D>& x, std::nullptr_t) noexcept {
+  return !x;
+}
+
 template <class T1, class D1, class T2, class D2>
 bool operator<=(const unique_ptr<T1, D1>& x, const unique_ptr<T2, D2>& y) {
   return !(y < x);
@@ -199,258 +285,1089 @@ std::ostream& operator<<(std::ostream& out, const unique_ptr<T, D>& x) {
 }
 
 template <class T, class D>
-void swap(unique_ptr<T, D>& lhs, unique_ptr<T, D>& rhs) {
+constexpr void swap(unique_ptr<T, D>& lhs, unique_ptr<T, D>& rhs) noexcept {
   lhs.swap(rhs);
 }
 
 template <class T, class Deleter> class unique_ptr<T[], Deleter> {
 public:
-  using pointer =
-      conditional_t<detail::has_pointer_type_v<remove_reference_t, Deleter>,
-                    typename remove_reference_t<Deleter>::pointer, T*>;
+  using pointer = typename detail::unique_pointer<T, Deleter>::type;
   using element_type = T;
   using deleter_type = Deleter;
 
-  constexpr unique_ptr(pointer p) noexcept;
-  constexpr unique_ptr() noexcept;
-  unique_ptr(unique_ptr&) = delete;
+  constexpr unique_ptr() noexcept
+    requires detail::default_deleter<Deleter>;
+  constexpr unique_ptr(std::nullptr_t) noexcept
+    requires detail::default_deleter<Deleter>;
+  constexpr explicit unique_ptr(pointer p) noexcept
+    requires detail::default_deleter<Deleter>;
+
+  template <class E>
+    requires is_constructible_v<Deleter, E&&>
+  constexpr unique_ptr(pointer p, E&& d) noexcept;
 
-  constexpr unique_ptr(unique_ptr&&) noexcept
-    requires is_move_constructible_v<T>;
+  unique_ptr(const unique_ptr&) = delete;
+  constexpr unique_ptr(unique_ptr&& o) noexcept;
 
   constexpr ~unique_ptr() noexcept;
 
-  constexpr unique_ptr& operator=(unique_ptr&) = delete;
-  constexpr unique_ptr& operator=(unique_ptr&&) noexcept
-    requires is_move_assignable_v<T>;
+  unique_ptr& operator=(const unique_ptr&) = delete;
+  constexpr unique_ptr& operator=(unique_ptr&& o) noexcept;
+  constexpr unique_ptr& operator=(std::nullptr_t) noexcept;
 
-  constexpr void release() noexcept;
-  constexpr void reset(pointer p) noexcept;
-  constexpr void swap(const unique_ptr&) noexcept;
+  [[nodiscard]] constexpr pointer release() noexcept;
+  constexpr void reset(pointer p = pointer()) noexcept;
+  constexpr void swap(unique_ptr& o) noexcept;
 
   [[gnu::always_inline]] [[nodiscard]] constexpr pointer get() const noexcept;
 
   [[gnu::always_inline]] [[nodiscard]] constexpr Deleter&
   get_deleter() noexcept;
-  [[gnu::always_inline]] [[nodiscard]] constexpr Deleter&
+  [[gnu::always_inline]] [[nodiscard]] constexpr const Deleter&
   get_deleter() const noexcept;
 
-  [[gnu::always_inline]] [[nodiscard]] explicit operator bool() const noexcept;
-  [[gnu::always_inline]] [[nodiscard]] T& operator[](std::size_t idx) const;
-
-  [[gnu::always_inline]] [[nodiscard]] add_lvalue_reference_t<T>
-  operator*() const noexcept(noexcept(*declval<pointer>()));
-  [[gnu::always_inline]] [[nodiscard]] pointer operator->() const noexcept;
+  [[gnu::always_inline]] [[nodiscard]] constexpr explicit
+  operator bool() const noexcept;
+  [[gnu::always_inline]] [[nodiscard]] constexpr T&
+  operator[](std::size_t idx) const;
 
 private:
-  std::tuple<T, Deleter> obj_;
+  detail::compressed_pair<pointer, Deleter> obj_;
 };
 
 template <class T, class D>
-constexpr unique_ptr<T[], D>::unique_ptr(pointer p) noexcept : obj_{p, D{}} {}
+constexpr unique_ptr<T[], D>::unique_ptr() noexcept
+  requires detail::default_deleter<D>
+    : obj_{pointer(), D()} {}
 
 template <class T, class D>
-constexpr unique_ptr<T[], D>::unique_ptr() noexcept : obj_{nullptr, D{}} {}
+constexpr unique_ptr<T[], D>::unique_ptr(std::nullptr_t) noexcept
+  requires detail::default_deleter<D>
+    : obj_{pointer(), D()} {}
+
+template <class T, class D>
+constexpr unique_ptr<T[], D>::unique_ptr(pointer p) noexcept
+  requires detail::default_deleter<D>
+    : obj_{p, D()} {}
+
+template <class T, class D>
+template <class E>
+  requires is_constructible_v<D, E&&>
+constexpr unique_ptr<T[], D>::unique_ptr(pointer p, E&& d) noexcept
+    : obj_{p, nstd::forward<E>(d)} {}
 
 template <class T, class D>
 constexpr unique_ptr<T[], D>::unique_ptr(unique_ptr&& o) noexcept
-  requires is_move_constructible_v<T>
-{}
+    : obj_{o.release(), nstd::forward<D>(o.get_deleter())} {}
 
 template <class T, class D>
 constexpr unique_ptr<T[], D>::~unique_ptr() noexcept {
-  release();
+  if (get()) {
+    get_deleter()(get());
+  }
 }
 
 template <class T, class D>
 constexpr unique_ptr<T[], D>&
-unique_ptr<T[], D>::operator=(unique_ptr<T[], D>&& o) noexcept
-  requires is_move_assignable_v<T>
-{
+unique_ptr<T[], D>::operator=(unique_ptr<T[], D>&& o) noexcept {
   if (this != &o) {
-    release();
-    obj_ = move(o.obj_);
-    o.get() = nullptr;
+    reset(o.release());
+    get_deleter() = nstd::forward<D>(o.get_deleter());
   }
   return *this;
 }
 
 template <class T, class D>
-constexpr void unique_ptr<T[], D>::release() noexcept {
-  if (get()) {
-    get_deleter()(get());
-  }
+constexpr unique_ptr<T[], D>&
+unique_ptr<T[], D>::operator=(std::nullptr_t) noexcept {
+  reset();
+  return *this;
+}
+
+template <class T, class D>
+constexpr auto unique_ptr<T[], D>::release() noexcept -> pointer {
+  return nstd::exchange(obj_.first, pointer());
 }
 
 template <class T, class D>
 constexpr void unique_ptr<T[], D>::reset(pointer p) noexcept {
-  release();
-  get() = p;
+  pointer old = nstd::exchange(obj_.first, p);
+  if (old) {
+    get_deleter()(old);
+  }
 }
 
 template <class T, class D>
-constexpr void unique_ptr<T[], D>::swap(const unique_ptr<T[], D>& o) noexcept {
-  swap(obj_, o.obj_);
+constexpr void unique_ptr<T[], D>::swap(unique_ptr<T[], D>& o) noexcept {
+  nstd::swap(obj_.first, o.obj_.first);
+  nstd::swap(obj_.second, o.obj_.second);
 }
 
 template <class T, class D>
 [[gnu::always_inline]] [[nodiscard]] constexpr auto
 unique_ptr<T[], D>::get() const noexcept -> pointer {
-  return std::get<0>(obj_);
+  return obj_.first;
 }
 
 template <class T, class D>
 [[gnu::always_inline]] [[nodiscard]] constexpr D&
 unique_ptr<T[], D>::get_deleter() noexcept {
-  return std::get<1>(obj_);
+  return obj_.second;
 }
 
 template <class T, class D>
-[[gnu::always_inline]] [[nodiscard]] constexpr D&
+[[gnu::always_inline]] [[nodiscard]] constexpr const D&
 unique_ptr<T[], D>::get_deleter() const noexcept {
-  return std::get<1>(obj_);
+  return obj_.second;
 }
 
 template <class T, class D>
-[[nodiscard]] unique_ptr<T[], D>::operator bool() const noexcept {
-  return get() != nullptr;
+[[nodiscard]] constexpr unique_ptr<T[], D>::operator bool() const noexcept {
+  return get() != pointer();
 }
 
 template <class T, class D>
-add_lvalue_reference_t<T> unique_ptr<T[], D>::operator*() const
-    noexcept(noexcept(*declval<pointer>())) {
-  return *get();
+constexpr T& unique_ptr<T[], D>::operator[](std::size_t idx) const {
+  return get()[idx];
 }
 
-template <class T, class D>
-auto unique_ptr<T[], D>::operator->() const noexcept -> pointer {
-  return *get();
+// a stateless deleter adds nothing to the pointer
+static_assert(sizeof(unique_ptr<int>) == sizeof(int*));
+static_assert(sizeof(unique_ptr<int[]>) == sizeof(int*));
+
+namespace detail {
+
+// The reference counts every shared_ptr to one object points at. weak_cnt
+// is the number of weak owners plus one held by the strong owners as a
+// group, so the last strong release destroys the object and then drops
+// that one, and whichever release takes weak_cnt to zero frees the block.
+//
+// Derived blocks keep the object or its pointer right after strong_cnt, so
+// in a block from malloc's 16-byte aligned memory the count and the start
+// of an object aligned to 8 bytes or less always share a cache line. An
+// over-aligned object starts at the next multiple of its alignment, which
+// may be on the following line: for alignas(16) when the block starts 32
+// bytes into a line, and always from alignas(64) up.
+class control_block {
+public:
+  control_block() noexcept = default;
+  control_block(const control_block&) = delete;
+  control_block& operator=(const control_block&) = delete;
+
+  void add_strong() noexcept {
+    strong_cnt.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Takes a strong reference unless the object is already gone. A plain
+  // increment could revive a count of zero after dispose() has started, so
+  // this retries a compare-exchange from the last value seen instead.
+  bool try_add_strong() noexcept {
+    std::size_t n = strong_cnt.load(std::memory_order_relaxed);
+    while (n != 0) {
+      if (strong_cnt.compare_exchange_weak(n, n + 1,
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void add_weak() noexcept {
+    weak_cnt.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void release_strong() noexcept {
+    if (strong_cnt.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      dispose();
+      release_weak();
+    }
+  }
+
+  void release_weak() noexcept {
+    if (weak_cnt.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      destroy();
+    }
+  }
+
+  // The same updates for blocks that only one thread can reach, those of
+  // local_shared_ptr: a relaxed load and store each, plain moves with no
+  // locked read-modify-write.
+  void add_strong_local() noexcept { bump(strong_cnt, 1); }
+
+  void release_strong_local() noexcept {
+    if (bump(strong_cnt, -1) == 0) {
+      dispose();
+      if (bump(weak_cnt, -1) == 0) {
+        destroy();
+      }
+    }
+  }
+
+  long use_count() const noexcept {
+    return static_cast<long>(strong_cnt.load(std::memory_order_relaxed));
+  }
+
+protected:
+  ~control_block() = default;
+
+private:
+  // destroys the object
+  virtual void dispose() noexcept = 0;
+  // frees the block
+  virtual void destroy() noexcept = 0;
+
+  std::atomic<std::size_t> weak_cnt{1};
+  std::atomic<std::size_t> strong_cnt{1};
+
+  static std::size_t bump(std::atomic<std::size_t>& cnt, int by) noexcept {
+    std::size_t n =
+        cnt.load(std::memory_order_relaxed) + static_cast<std::size_t>(by);
+    cnt.store(n, std::memory_order_relaxed);
+    return n;
+  }
+};
+
+// Control blocks come from the owner's allocator rebound to the block type
+// and go back to a copy of it that the block carries; std::allocator stands
+// in when there is none. A stateless allocator takes no room in the block.
+template <class Alloc, class Block>
+using block_alloc_traits =
+    typename std::allocator_traits<Alloc>::template rebind_traits<Block>;
+
+template <class Block, class Alloc, class... Args>
+Block* allocate_block(const Alloc& alloc, Args&&... args) {
+  using traits = block_alloc_traits<Alloc, Block>;
+  typename traits::allocator_type a(alloc);
+  auto p = traits::allocate(a, 1);
+  try {
+    ::new (static_cast<void*>(std::to_address(p)))
+        Block(alloc, nstd::forward<Args>(args)...);
+  } catch (...) {
+    traits::deallocate(a, p, 1);
+    throw;
+  }
+  return std::to_address(p);
 }
 
-template <class T, class D, class... Args>
-unique_ptr<T[], D> make_unique(Args&&... args) {
-  return unique_ptr<T, D>(new T(forward<Args>(args)...));
+// destroys block and frees it through alloc, which may live inside it
+template <class Block, class Alloc>
+void free_block(Block* block, const Alloc& alloc) noexcept {
+  using traits = block_alloc_traits<Alloc, Block>;
+  typename traits::allocator_type a(alloc);
+  auto p = std::pointer_traits<typename traits::pointer>::pointer_to(*block);
+  block->~Block();
+  traits::deallocate(a, p, 1);
 }
 
-template <class T1, class D1, class T2, class D2>
-bool operator<(const unique_ptr<T1[], D1>& x, const unique_ptr<T2[], D2>& y) {
-  return std::less<common_type_t<typename unique_ptr<T1[], D1>::pointer,
-                                 typename unique_ptr<T2[], D2>::pointer>>()(
-      x.get(), y.get());
+// a separately allocated object and its deleter
+template <class Y, class Deleter, class Alloc = std::allocator<void>>
+class pointer_block final : public control_block {
+public:
+  pointer_block(const Alloc& alloc, Y* p, Deleter d) noexcept
+      : obj_{p, nstd::move(d)}, alloc_(alloc) {}
+
+private:
+  compressed_pair<Y*, Deleter> obj_;
+  [[no_unique_address]] Alloc alloc_;
+
+  void dispose() noexcept override { obj_.second(obj_.first); }
+  void destroy() noexcept override { free_block(this, alloc_); }
+};
+
+// the object itself, built in place by allocate_shared through alloc
+// rebound to T
+template <class T, class Alloc = std::allocator<T>>
+class inplace_block final : public control_block {
+  using obj_traits =
+      typename std::allocator_traits<Alloc>::template rebind_traits<T>;
+
+public:
+  template <class... Args>
+  explicit inplace_block(const Alloc& alloc, Args&&... args) : alloc_(alloc) {
+    typename obj_traits::allocator_type a(alloc_);
+    obj_traits::construct(a, &obj_, nstd::forward<Args>(args)...);
+  }
+
+  // obj_ is destroyed by dispose(), possibly long before the block
+  ~inplace_block() {}
+
+  T* get() noexcept { return &obj_; }
+
+private:
+  union {
+    T obj_;
+  };
+  [[no_unique_address]] Alloc alloc_;
+
+  void dispose() noexcept override {
+    typename obj_traits::allocator_type a(alloc_);
+    obj_traits::destroy(a, &obj_);
+  }
+
+  void destroy() noexcept override { free_block(this, alloc_); }
+};
+
+template <class Y, class T>
+concept shared_compatible = is_convertible_v<Y*, T*>;
+
+// what shared_ptr<T>(Y*) deletes with
+template <class T, class Y>
+using shared_default_delete =
+    conditional_t<is_array_v<T>, default_delete<T>, default_delete<Y>>;
+
+} // namespace detail
+
+template <class T> class shared_ptr;
+template <class T> class weak_ptr;
+template <class T> class local_shared_ptr;
+
+// thrown by shared_ptr(const weak_ptr&) when the object is gone
+class bad_weak_ptr : public std::exception {
+public:
+  const char* what() const noexcept override { return "bad_weak_ptr"; }
+};
+
+template <class T, class Alloc, class... Args>
+  requires(!is_array_v<T>)
+shared_ptr<T> allocate_shared(const Alloc& alloc, Args&&... args);
+
+// Reference-counted ownership as a pair of pointers: the object, and the
+// control block with the counts. A shared_ptr from make_shared has both in
+// one allocation; one adopting a pointer allocates the block beside it.
+template <class T> class shared_ptr {
+public:
+  using element_type = remove_extent_t<T>;
+  using weak_type = weak_ptr<T>;
+
+  constexpr shared_ptr() noexcept = default;
+
+  constexpr shared_ptr(std::nullptr_t) noexcept {}
+
+  // deletes p if the control block cannot be allocated
+  template <class Y>
+    requires detail::shared_compatible<Y, element_type>
+  explicit shared_ptr(Y* p)
+      : shared_ptr(p, detail::shared_default_delete<T, Y>()) {}
+
+  // calls d(p) if the control block cannot be allocated
+  template <class Y, class Deleter>
+    requires detail::shared_compatible<Y, element_type>
+  shared_ptr(Y* p, Deleter d)
+      : shared_ptr(p, nstd::move(d), std::allocator<void>()) {}
+
+  // the control block comes from alloc, rebound
+  template <class Y, class Deleter, class Alloc>
+    requires detail::shared_compatible<Y, element_type>
+  shared_ptr(Y* p, Deleter d, Alloc alloc) : ptr_(p) {
+    try {
+      block_ = detail::allocate_block<detail::pointer_block<Y, Deleter, Alloc>>(
+          alloc, p, d);
+    } catch (...) {
+      d(p);
+      throw;
+    }
+  }
+
+  // owns a null pointer, which d is still called on
+  template <class Deleter>
+  shared_ptr(std::nullptr_t, Deleter d)
+      : shared_ptr(nullptr, nstd::move(d), std::allocator<void>()) {}
+
+  template <class Deleter, class Alloc>
+  shared_ptr(std::nullptr_t, Deleter d, Alloc alloc)
+      : shared_ptr(static_cast<element_type*>(nullptr), nstd::move(d),
+                   nstd::move(alloc)) {}
+
+  // shares r's ownership but points at p, such as a member of *r
+  template <class Y>
+  shared_ptr(const shared_ptr<Y>& r, element_type* p) noexcept
+      : ptr_(p), block_(r.block_) {
+    if (block_) {
+      block_->add_strong();
+    }
+  }
+
+  template <class Y>
+  shared_ptr(shared_ptr<Y>&& r, element_type* p) noexcept
+      : ptr_(p), block_(nstd::exchange(r.block_, nullptr)) {
+    r.ptr_ = nullptr;
+  }
+
+  shared_ptr(const shared_ptr& r) noexcept : shared_ptr(r, r.ptr_) {}
+
+  template <class Y>
+    requires detail::shared_compatible<Y, element_type>
+  shared_ptr(const shared_ptr<Y>& r) noexcept : shared_ptr(r, r.ptr_) {}
+
+  shared_ptr(shared_ptr&& r) noexcept : shared_ptr(nstd::move(r), r.ptr_) {}
+
+  template <class Y>
+    requires detail::shared_compatible<Y, element_type>
+  shared_ptr(shared_ptr<Y>&& r) noexcept
+      : shared_ptr(nstd::move(r), r.ptr_) {}
+
+  // Takes over r's object, of which r must be the only owner: any other
+  // local_shared_ptr would go on updating the counts without atomics.
+  // Throws invalid_argument otherwise and leaves r as it was.
+  template <class Y>
+    requires detail::shared_compatible<Y, element_type>
+  explicit shared_ptr(local_shared_ptr<Y>&& r)
+      : ptr_(r.ptr_), block_(r.block_) {
+    if (block_ && block_->use_count() != 1) {
+      throw std::invalid_argument{"local_shared_ptr is not the only owner"};
+    }
+    r.ptr_ = nullptr;
+    r.block_ = nullptr;
+  }
+
+  // throws bad_weak_ptr if r has expired
+  template <class Y>
+    requires detail::shared_compatible<Y, element_type>
+  explicit shared_ptr(const weak_ptr<Y>& r) : ptr_(r.ptr_), block_(r.block_) {
+    if (!block_ || !block_->try_add_strong()) {
+      throw bad_weak_ptr();
+    }
+  }
+
+  template <class Y, class Deleter>
+    requires detail::shared_compatible<Y, element_type>
+  shared_ptr(unique_ptr<Y, Deleter>&& r) : ptr_(r.get()) {
+    if (ptr_) {
+      block_ = detail::allocate_block<detail::pointer_block<Y, Deleter>>(
+          std::allocator<void>(), r.get(),
+          nstd::forward<Deleter>(r.get_deleter()));
+      (void)r.release();
+    }
+  }
+
+  ~shared_ptr() {
+    if (block_) {
+      block_->release_strong();
+    }
+  }
+
+  shared_ptr& operator=(const shared_ptr& r) noexcept {
+    shared_ptr(r).swap(*this);
+    return *this;
+  }
+
+  template <class Y> shared_ptr& operator=(const shared_ptr<Y>& r) noexcept {
+    shared_ptr(r).swap(*this);
+    return *this;
+  }
+
+  shared_ptr& operator=(shared_ptr&& r) noexcept {
+    shared_ptr(nstd::move(r)).swap(*this);
+    return *this;
+  }
+
+  template <class Y> shared_ptr& operator=(shared_ptr<Y>&& r) noexcept {
+    shared_ptr(nstd::move(r)).swap(*this);
+    return *this;
+  }
+
+  template <class Y, class Deleter>
+  shared_ptr& operator=(unique_ptr<Y, Deleter>&& r) {
+    shared_ptr(nstd::move(r)).swap(*this);
+    return *this;
+  }
+
+  void reset() noexcept { shared_ptr().swap(*this); }
+
+  template <class Y> void reset(Y* p) { shared_ptr(p).swap(*this); }
+
+  template <class Y, class Deleter> void reset(Y* p, Deleter d) {
+    shared_ptr(p, nstd::move(d)).swap(*this);
+  }
+
+  template <class Y, class Deleter, class Alloc>
+  void reset(Y* p, Deleter d, Alloc alloc) {
+    shared_ptr(p, nstd::move(d), nstd::move(alloc)).swap(*this);
+  }
+
+  void swap(shared_ptr& r) noexcept {
+    nstd::swap(ptr_, r.ptr_);
+    nstd::swap(block_, r.block_);
+  }
+
+  element_type* get() const noexcept { return ptr_; }
+
+  add_lvalue_reference_t<element_type> operator*() const noexcept
+    requires(!is_array_v<T>)
+  {
+    return *ptr_;
+  }
+
+  element_type* operator->() const noexcept
+    requires(!is_array_v<T>)
+  {
+    return ptr_;
+  }
+
+  element_type& operator[](std::size_t idx) const noexcept
+    requires is_array_v<T>
+  {
+    return ptr_[idx];
+  }
+
+  long use_count() const noexcept { return block_ ? block_->use_count() : 0; }
+
+  explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+  // ordering by control block, so aliases of one object compare equivalent
+  template <class Y> bool owner_before(const shared_ptr<Y>& r) const noexcept {
+    return std::less<detail::control_block*>()(block_, r.block_);
+  }
+
+  template <class Y> bool owner_before(const weak_ptr<Y>& r) const noexcept {
+    return std::less<detail::control_block*>()(block_, r.block_);
+  }
+
+private:
+  element_type* ptr_ = nullptr;
+  detail::control_block* block_ = nullptr;
+
+  template <class> friend class shared_ptr;
+  template <class> friend class weak_ptr;
+  template <class> friend class local_shared_ptr;
+
+  template <class U, class Alloc, class... Args>
+    requires(!is_array_v<U>)
+  friend shared_ptr<U> allocate_shared(const Alloc& alloc, Args&&... args);
+};
+
+// One allocation from alloc, rebound, holding the counts and the object,
+// which directly follows them unless it is over-aligned; see
+// detail::control_block. The object is built and destroyed through alloc
+// rebound to T.
+template <class T, class Alloc, class... Args>
+  requires(!is_array_v<T>)
+shared_ptr<T> allocate_shared(const Alloc& alloc, Args&&... args) {
+  auto* block = detail::allocate_block<detail::inplace_block<T, Alloc>>(
+      alloc, nstd::forward<Args>(args)...);
+  shared_ptr<T> ret;
+  ret.ptr_ = block->get();
+  ret.block_ = block;
+  return ret;
 }
 
-template <class T1, class D1, class T2, class D2>
-bool operator==(const unique_ptr<T1[], D1>& x, const unique_ptr<T2[], D2>& y) {
-  return x.get() == y.get();
+template <class T, class... Args>
+  requires(!is_array_v<T>)
+shared_ptr<T> make_shared(Args&&... args) {
+  return nstd::allocate_shared<T>(std::allocator<T>(),
+                                  nstd::forward<Args>(args)...);
 }
 
-template <class T1, class D1, class T2, class D2>
-bool operator<=(const unique_ptr<T1[], D1>& x, const unique_ptr<T2[], D2>& y) {
-  return !(y < x);
+template <class T, class U>
+bool operator==(const shared_ptr<T>& x, const shared_ptr<U>& y) noexcept {
+  return x.get() == y.get();
 }
 
-template <class T1, class D1, class T2, class D2>
-bool operator>(const unique_ptr<T1[], D1>& x, const unique_ptr<T2[], D2>& y) {
-  return y < x;
+template <class T>
+bool operator==(const shared_ptr<T>& x, std::nullptr_t) noexcept {
+  return !x;
 }
 
-template <class T1, class D1, class T2, class D2>
-bool operator>=(const unique_ptr<T1[], D1>& x, const unique_ptr<T2[], D2>& y) {
-  return !(x < y);
+template <class T, class U>
+bool operator<(const shared_ptr<T>& x, const shared_ptr<U>& y) noexcept {
+  return std::less<common_type_t<typename shared_ptr<T>::element_type*,
+                                 typename shared_ptr<U>::element_type*>>()(
+      x.get(), y.get());
 }
 
-template <class T, class D>
-  requires requires(std::ostream& out, unique_ptr<T[], D>& p) {
-    out << p.get();
-  }
-std::ostream& operator<<(std::ostream& out, const unique_ptr<T, D>& x) {
+template <class T>
+std::ostream& operator<<(std::ostream& out, const shared_ptr<T>& x) {
   return out << x.get();
 }
 
-template <class T, class D>
-void swap(unique_ptr<T[], D>& lhs, unique_ptr<T[], D>& rhs) {
+template <class T> void swap(shared_ptr<T>& lhs, shared_ptr<T>& rhs) noexcept {
   lhs.swap(rhs);
 }
 
-template <class T> class shared_ptr {
+// A non-owning reference to an object managed by shared_ptr. It keeps the
+// control block alive, not the object: the object goes when the last
+// shared_ptr does, the block when the last weak_ptr does as well.
+template <class T> class weak_ptr {
+public:
+  using element_type = remove_extent_t<T>;
+
+  constexpr weak_ptr() noexcept = default;
+
+  weak_ptr(const weak_ptr& r) noexcept : ptr_(r.ptr_), block_(r.block_) {
+    if (block_) {
+      block_->add_weak();
+    }
+  }
+
+  // through lock(), since reaching a virtual base of Y needs a live object
+  template <class Y>
+    requires detail::shared_compatible<Y, element_type>
+  weak_ptr(const weak_ptr<Y>& r) noexcept
+      : ptr_(r.lock().get()), block_(r.block_) {
+    if (block_) {
+      block_->add_weak();
+    }
+  }
+
+  template <class Y>
+    requires detail::shared_compatible<Y, element_type>
+  weak_ptr(const shared_ptr<Y>& r) noexcept
+      : ptr_(r.ptr_), block_(r.block_) {
+    if (block_) {
+      block_->add_weak();
+    }
+  }
+
+  weak_ptr(weak_ptr&& r) noexcept
+      : ptr_(nstd::exchange(r.ptr_, nullptr)),
+        block_(nstd::exchange(r.block_, nullptr)) {}
+
+  template <class Y>
+    requires detail::shared_compatible<Y, element_type>
+  weak_ptr(weak_ptr<Y>&& r) noexcept : weak_ptr(r) {
+    r.reset();
+  }
+
+  ~weak_ptr() {
+    if (block_) {
+      block_->release_weak();
+    }
+  }
+
+  weak_ptr& operator=(const weak_ptr& r) noexcept {
+    weak_ptr(r).swap(*this);
+    return *this;
+  }
+
+  template <class Y> weak_ptr& operator=(const weak_ptr<Y>& r) noexcept {
+    weak_ptr(r).swap(*this);
+    return *this;
+  }
+
+  template <class Y> weak_ptr& operator=(const shared_ptr<Y>& r) noexcept {
+    weak_ptr(r).swap(*this);
+    return *this;
+  }
+
+  weak_ptr& operator=(weak_ptr&& r) noexcept {
+    weak_ptr(nstd::move(r)).swap(*this);
+    return *this;
+  }
+
+  template <class Y> weak_ptr& operator=(weak_ptr<Y>&& r) noexcept {
+    weak_ptr(nstd::move(r)).swap(*this);
+    return *this;
+  }
+
+  void reset() noexcept { weak_ptr().swap(*this); }
+
+  void swap(weak_ptr& r) noexcept {
+    nstd::swap(ptr_, r.ptr_);
+    nstd::swap(block_, r.block_);
+  }
+
+  long use_count() const noexcept { return block_ ? block_->use_count() : 0; }
+
+  bool expired() const noexcept { return use_count() == 0; }
+
+  // a shared_ptr to the object, or an empty one if it is gone; never
+  // brings back an object whose last owner has let go
+  shared_ptr<T> lock() const noexcept {
+    shared_ptr<T> ret;
+    if (block_ && block_->try_add_strong()) {
+      ret.ptr_ = ptr_;
+      ret.block_ = block_;
+    }
+    return ret;
+  }
+
+  template <class Y> bool owner_before(const weak_ptr<Y>& r) const noexcept {
+    return std::less<detail::control_block*>()(block_, r.block_);
+  }
+
+  template <class Y> bool owner_before(const shared_ptr<Y>& r) const noexcept {
+    return std::less<detail::control_block*>()(block_, r.block_);
+  }
+
 private:
-  struct control_block {
-    T* obj;
-    void* deleter;
-    void* allocator;
-    std::atomic<std::size_t> strong_cnt;
-    std::atomic<std::size_t> weak_cnt;
-  };
+  element_type* ptr_ = nullptr;
+  detail::control_block* block_ = nullptr;
+
+  template <class> friend class shared_ptr;
+  template <class> friend class weak_ptr;
+};
+
+template <class T> weak_ptr(shared_ptr<T>) -> weak_ptr<T>;
+
+template <class T> void swap(weak_ptr<T>& lhs, weak_ptr<T>& rhs) noexcept {
+  lhs.swap(rhs);
+}
 
+// shared_ptr for objects that never leave one thread, such as an actor's
+// private state. The counts live in the same control blocks but are
+// updated with plain loads and stores, so a copy or a release costs a few
+// ordinary instructions instead of a locked read-modify-write.
+//
+// Nothing else may touch the counts while local_shared_ptrs own the block:
+// there is no weak_ptr to a local object, no conversion from shared_ptr, and
+// the one way out is the explicit shared_ptr(local_shared_ptr&&), which
+// checks that it takes the last local owner.
+template <class T> class local_shared_ptr {
 public:
   using element_type = remove_extent_t<T>;
-  // using weak_type = weak_ptr<T>
 
-  constexpr shared_ptr() noexcept;
+  constexpr local_shared_ptr() noexcept = default;
 
-  constexpr shared_ptr(std::nullptr_t) noexcept;
+  constexpr local_shared_ptr(std::nullptr_t) noexcept {}
 
-  template <class U> shared_ptr(U* p) noexcept;
-
-  template <class Y, class Deleter> shared_ptr(Y* ptr, Deleter d);
+  // the blocks are built as shared_ptr builds them, before any other owner
+  // exists
+  template <class Y>
+    requires detail::shared_compatible<Y, element_type>
+  explicit local_shared_ptr(Y* p) : local_shared_ptr(shared_ptr<T>(p)) {}
 
-  template <class Deleter> shared_ptr(std::nullptr_t ptr, Deleter d);
+  template <class Y, class Deleter>
+    requires detail::shared_compatible<Y, element_type>
+  local_shared_ptr(Y* p, Deleter d)
+      : local_shared_ptr(shared_ptr<T>(p, nstd::move(d))) {}
 
   template <class Y, class Deleter, class Alloc>
-  shared_ptr(Y* ptr, Deleter d, Alloc alloc);
+    requires detail::shared_compatible<Y, element_type>
+  local_shared_ptr(Y* p, Deleter d, Alloc alloc)
+      : local_shared_ptr(shared_ptr<T>(p, nstd::move(d), nstd::move(alloc))) {}
 
-  template <class Deleter, class Alloc>
-  shared_ptr(std::nullptr_t ptr, Deleter d, Alloc alloc);
+  template <class Y>
+  local_shared_ptr(const local_shared_ptr<Y>& r, element_type* p) noexcept
+      : ptr_(p), block_(r.block_) {
+    if (block_) {
+      block_->add_strong_local();
+    }
+  }
 
   template <class Y>
-  shared_ptr(const shared_ptr<Y>& r, element_type* ptr) noexcept;
+  local_shared_ptr(local_shared_ptr<Y>&& r, element_type* p) noexcept
+      : ptr_(p), block_(nstd::exchange(r.block_, nullptr)) {
+    r.ptr_ = nullptr;
+  }
 
-  template <class Y> shared_ptr(shared_ptr<Y>&& r, element_type* ptr) noexcept;
+  local_shared_ptr(const local_shared_ptr& r) noexcept
+      : local_shared_ptr(r, r.ptr_) {}
 
-  shared_ptr(const shared_ptr& r) noexcept;
+  template <class Y>
+    requires detail::shared_compatible<Y, element_type>
+  local_shared_ptr(const local_shared_ptr<Y>& r) noexcept
+      : local_shared_ptr(r, r.ptr_) {}
 
-  template <class Y> shared_ptr(const shared_ptr<Y>& r) noexcept;
+  local_shared_ptr(local_shared_ptr&& r) noexcept
+      : local_shared_ptr(nstd::move(r), r.ptr_) {}
+
+  template <class Y>
+    requires detail::shared_compatible<Y, element_type>
+  local_shared_ptr(local_shared_ptr<Y>&& r) noexcept
+      : local_shared_ptr(nstd::move(r), r.ptr_) {}
 
-  shared_ptr(shared_ptr&& r) noexcept;
+  template <class Y, class Deleter>
+    requires detail::shared_compatible<Y, element_type>
+  local_shared_ptr(unique_ptr<Y, Deleter>&& r)
+      : local_shared_ptr(shared_ptr<T>(nstd::move(r))) {}
 
-  template <class Y> shared_ptr(shared_ptr<Y>&& r) noexcept;
+  ~local_shared_ptr() {
+    if (block_) {
+      block_->release_strong_local();
+    }
+  }
 
-  // template< class Y >
-  // explicit shared_ptr( const std::weak_ptr<Y>& r );
+  local_shared_ptr& operator=(const local_shared_ptr& r) noexcept {
+    local_shared_ptr(r).swap(*this);
+    return *this;
+  }
 
-  template <class Y, class Deleter> shared_ptr(unique_ptr<Y, Deleter>&& r);
+  template <class Y>
+  local_shared_ptr& operator=(const local_shared_ptr<Y>& r) noexcept {
+    local_shared_ptr(r).swap(*this);
+    return *this;
+  }
 
-  shared_ptr& operator=(const shared_ptr& r) noexcept;
+  local_shared_ptr& operator=(local_shared_ptr&& r) noexcept {
+    local_shared_ptr(nstd::move(r)).swap(*this);
+    return *this;
+  }
 
-  template <class Y> shared_ptr& operator=(const shared_ptr<Y>& r) noexcept;
+  template <class Y>
+  local_shared_ptr& operator=(local_shared_ptr<Y>&& r) noexcept {
+    local_shared_ptr(nstd::move(r)).swap(*this);
+    return *this;
+  }
 
-  shared_ptr& operator=(shared_ptr&& r) noexcept;
+  void reset() noexcept { local_shared_ptr().swap(*this); }
 
-  template <class Y> shared_ptr& operator=(shared_ptr<Y>&& r) noexcept;
+  template <class Y> void reset(Y* p) { local_shared_ptr(p).swap(*this); }
 
-  template <class Y, class Deleter>
-  shared_ptr& operator=(unique_ptr<Y, Deleter>&& r);
+  template <class Y, class Deleter> void reset(Y* p, Deleter d) {
+    local_shared_ptr(p, nstd::move(d)).swap(*this);
+  }
 
-  void reset() noexcept;
+  void swap(local_shared_ptr& r) noexcept {
+    nstd::swap(ptr_, r.ptr_);
+    nstd::swap(block_, r.block_);
+  }
 
-  template <class Y> void reset(Y* ptr);
+  element_type* get() const noexcept { return ptr_; }
 
-  template <class Y, class Deleter> void reset(Y* ptr, Deleter d);
+  add_lvalue_reference_t<element_type> operator*() const noexcept
+    requires(!is_array_v<T>)
+  {
+    return *ptr_;
+  }
 
-  template <class Y, class Deleter, class Alloc>
-  void reset(Y* ptr, Deleter d, Alloc alloc);
+  element_type* operator->() const noexcept
+    requires(!is_array_v<T>)
+  {
+    return ptr_;
+  }
+
+  element_type& operator[](std::size_t idx) const noexcept
+    requires is_array_v<T>
+  {
+    return ptr_[idx];
+  }
+
+  long use_count() const noexcept { return block_ ? block_->use_count() : 0; }
+
+  explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+private:
+  element_type* ptr_ = nullptr;
+  detail::control_block* block_ = nullptr;
+
+  // adopts the block of a shared_ptr nothing else has seen yet
+  explicit local_shared_ptr(shared_ptr<T>&& r) noexcept
+      : ptr_(nstd::exchange(r.ptr_, nullptr)),
+        block_(nstd::exchange(r.block_, nullptr)) {}
+
+  template <class> friend class shared_ptr;
+  template <class> friend class local_shared_ptr;
+
+  template <class U, class Alloc, class... Args>
+    requires(!is_array_v<U>)
+  friend local_shared_ptr<U> allocate_local_shared(const Alloc& alloc,
+                                                   Args&&... args);
+};
+
+// allocate_shared and make_shared for local_shared_ptr
+template <class T, class Alloc, class... Args>
+  requires(!is_array_v<T>)
+local_shared_ptr<T> allocate_local_shared(const Alloc& alloc, Args&&... args) {
+  return local_shared_ptr<T>(
+      nstd::allocate_shared<T>(alloc, nstd::forward<Args>(args)...));
+}
+
+template <class T, class... Args>
+  requires(!is_array_v<T>)
+local_shared_ptr<T> make_local_shared(Args&&... args) {
+  return nstd::allocate_local_shared<T>(std::allocator<T>(),
+                                        nstd::forward<Args>(args)...);
+}
+
+template <class T, class U>
+bool operator==(const local_shared_ptr<T>& x,
+                const local_shared_ptr<U>& y) noexcept {
+  return x.get() == y.get();
+}
+
+template <class T>
+bool operator==(const local_shared_ptr<T>& x, std::nullptr_t) noexcept {
+  return !x;
+}
+
+template <class T>
+void swap(local_shared_ptr<T>& lhs, local_shared_ptr<T>& rhs) noexcept {
+  lhs.swap(rhs);
+}
+
+// A shared_ptr that threads may load, store, exchange and compare-exchange
+// at once, without a lock, by split reference counting.
+//
+// Each stored value sits in a heap node. The atomic word holds the node's
+// address in its low 48 bits and, in the high 16, the number of loads that
+// have claimed it. load() claims the node with one fetch_add on the word,
+// copies the shared_ptr out and returns the claim: by a compare-exchange
+// taking one off the word while the node is still installed, or else off
+// the node's own inner count. The writer that swaps a node out adds the
+// claims left on the word to that inner count, so the node is freed by
+// whichever side brings the two back to zero.
+//
+// Loads never allocate or wait for one another, though each still writes
+// the word and the object's strong count, so cores loading one pointer
+// share those two lines. Stores allocate a node and may throw bad_alloc.
+// User-space addresses must fit in 48 bits, as they do by default on
+// x86-64 and AArch64 Linux. The memory_order arguments are accepted for
+// std::atomic compatibility; every operation is at least acquire-release.
+template <class T> class atomic_shared_ptr {
+  struct node {
+    shared_ptr<T> value;
+    std::atomic<std::int64_t> inner{0};
+  };
+
+  constexpr static int count_shift = 48;
+  constexpr static std::uint64_t one_claim = std::uint64_t{1} << count_shift;
+
+public:
+  using value_type = shared_ptr<T>;
+
+  constexpr static bool is_always_lock_free =
+      std::atomic<std::uint64_t>::is_always_lock_free;
+
+  constexpr atomic_shared_ptr() noexcept = default;
+
+  atomic_shared_ptr(shared_ptr<T> desired)
+      : word_(make_node(nstd::move(desired))) {}
+
+  atomic_shared_ptr(const atomic_shared_ptr&) = delete;
+  atomic_shared_ptr& operator=(const atomic_shared_ptr&) = delete;
+
+  ~atomic_shared_ptr() {
+    delete to_node(word_.load(std::memory_order_relaxed));
+  }
+
+  bool is_lock_free() const noexcept { return word_.is_lock_free(); }
+
+  shared_ptr<T>
+  load(std::memory_order = std::memory_order_seq_cst) const noexcept {
+    node* n = to_node(word_.fetch_add(one_claim, std::memory_order_acquire));
+    // claims on an empty word guard nothing and are simply dropped
+    if (!n) {
+      return nullptr;
+    }
+    shared_ptr<T> ret = n->value;
+    unclaim(n);
+    return ret;
+  }
+
+  operator shared_ptr<T>() const noexcept { return load(); }
+
+  void store(shared_ptr<T> desired,
+             std::memory_order = std::memory_order_seq_cst) {
+    (void)exchange(nstd::move(desired));
+  }
 
-  void swap(shared_ptr& r) noexcept;
+  atomic_shared_ptr& operator=(shared_ptr<T> desired) {
+    store(nstd::move(desired));
+    return *this;
+  }
 
-  element_type* get() const noexcept;
+  shared_ptr<T> exchange(shared_ptr<T> desired,
+                         std::memory_order = std::memory_order_seq_cst) {
+    std::uint64_t old = word_.exchange(make_node(nstd::move(desired)),
+                                       std::memory_order_acq_rel);
+    node* n = to_node(old);
+    if (!n) {
+      return nullptr;
+    }
+    // a copy, as claimed loads may still be reading the node
+    shared_ptr<T> ret = n->value;
+    settle(n, claims(old));
+    return ret;
+  }
 
-  element_type& operator*() const noexcept;
-  element_type* operator->() const noexcept;
+  // Replaces the value with desired if it is equivalent to expected: the
+  // same pointer sharing the same ownership. Otherwise copies the value
+  // into expected and returns false.
+  bool compare_exchange_strong(shared_ptr<T>& expected, shared_ptr<T> desired,
+                               std::memory_order = std::memory_order_seq_cst,
+                               std::memory_order = std::memory_order_seq_cst) {
+    std::uint64_t fresh = 0;
+    bool made = false;
+    for (;;) {
+      std::uint64_t w =
+          word_.fetch_add(one_claim, std::memory_order_acquire) + one_claim;
+      node* n = to_node(w);
+      if (!equivalent(n ? n->value : shared_ptr<T>(), expected)) {
+        if (made) {
+          delete to_node(fresh);
+        }
+        expected = n ? n->value : shared_ptr<T>();
+        if (n) {
+          unclaim(n);
+        }
+        return false;
+      }
+      if (!made) {
+        fresh = make_node(nstd::move(desired));
+        made = true;
+      }
+      while (to_node(w) == n) {
+        if (word_.compare_exchange_weak(w, fresh, std::memory_order_acq_rel,
+                                        std::memory_order_relaxed)) {
+          // w's claims include this one, which goes back at the same time
+          if (n) {
+            settle(n, claims(w) - 1);
+          }
+          return true;
+        }
+      }
+      // another writer got there first; return the claim and look again
+      if (n) {
+        settle(n, -1);
+      }
+    }
+  }
 
-  element_type& operator[](std::size_t idx) const noexcept;
+  bool compare_exchange_weak(shared_ptr<T>& expected, shared_ptr<T> desired,
+                             std::memory_order = std::memory_order_seq_cst,
+                             std::memory_order = std::memory_order_seq_cst) {
+    return compare_exchange_strong(expected, nstd::move(desired));
+  }
 
 private:
-  control_block* block;
+  mutable std::atomic<std::uint64_t> word_{0};
+
+  static node* to_node(std::uint64_t w) noexcept {
+    return reinterpret_cast<node*>(w & (one_claim - 1));
+  }
+
+  static std::int64_t claims(std::uint64_t w) noexcept {
+    return static_cast<std::int64_t>(w >> count_shift);
+  }
+
+  // an empty value with no control block needs no node
+  static std::uint64_t make_node(shared_ptr<T> v) {
+    if (!v && v.use_count() == 0) {
+      return 0;
+    }
+    auto addr = reinterpret_cast<std::uintptr_t>(new node{nstd::move(v)});
+    return static_cast<std::uint64_t>(addr);
+  }
+
+  static bool equivalent(const shared_ptr<T>& a,
+                         const shared_ptr<T>& b) noexcept {
+    return a.get() == b.get() && !a.owner_before(b) && !b.owner_before(a);
+  }
+
+  // adds claims moved off the word, or returned by loads that found the
+  // node swapped out, and frees the node once they balance
+  static void settle(node* n, std::int64_t by) noexcept {
+    if (n->inner.fetch_add(by, std::memory_order_acq_rel) + by == 0) {
+      delete n;
+    }
+  }
+
+  // returns one claim on n, to the word if n is still installed
+  void unclaim(node* n) const noexcept {
+    std::uint64_t w = word_.load(std::memory_order_relaxed);
+    while (to_node(w) == n) {
+      if (word_.compare_exchange_weak(w, w - one_claim,
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed)) {
+        return;
+      }
+    }
+    settle(n, -1);
+  }
 };
 
+// a shared_ptr is two pointers whatever it owns
+static_assert(sizeof(shared_ptr<int>) == 2 * sizeof(int*));
+
 } // namespace nstd
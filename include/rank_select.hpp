@@ -0,0 +1,184 @@
+#pragma once
+
+#include "bitset.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace nstd {
+
+// Succinct rank/select directory over an immutable bitset<N> or
+// dynamic_bitset with 64-bit blocks. The bitset is only referenced, so it
+// must outlive the index and must not change while the index is in use.
+//
+// The directory follows the "poppy" layout: one 64-bit absolute count per
+// 2^32 bits, and one 64-bit entry per 2048-bit basic block holding the count
+// since the start of its 2^32-bit region (low 32 bits) plus the popcounts of
+// the basic block's first three 512-bit sub-blocks (10 bits each). That is
+// 64 bits per 2048, about 3.1% on top of the bitset itself. A sample of the
+// basic block holding every 8192nd one narrows the search done by select.
+//
+// rank1 touches one entry and at most 8 words; select1 binary searches the
+// basic blocks between two samples and then scans at most 3 sub-block
+// counts and 8 words.
+template <class Bitset> class rank_select {
+  using block_t = typename decltype(std::declval<const Bitset&>()
+                                        .blocks())::value_type;
+  static_assert(std::numeric_limits<block_t>::digits == 64,
+                "rank_select needs 64-bit blocks");
+
+  constexpr static std::size_t words_per_basic = 32;
+  constexpr static std::size_t words_per_sub = 8;
+  constexpr static std::size_t bits_per_basic = 2048;
+  constexpr static std::size_t bits_per_sub = 512;
+  constexpr static std::size_t ones_per_sample = 8192;
+
+public:
+  constexpr static std::size_t npos = detail::npos;
+
+  explicit rank_select(const Bitset& bits) : bits_(&bits) { build(); }
+
+  std::size_t size() const noexcept { return bits_->size(); }
+
+  // total number of set bits
+  std::size_t count() const noexcept { return ones_; }
+
+  // number of set bits in [0, pos); pos may equal size()
+  std::size_t rank1(std::size_t pos) const {
+    if (pos > size())
+      throw std::out_of_range{"rank position out of range"};
+    const block_t* words = bits_->blocks().data();
+    std::size_t basic = pos / bits_per_basic;
+    std::uint64_t entry = basic_[basic];
+    std::size_t rank = upper_[pos >> 32] + (entry & 0xffffffff);
+
+    std::size_t sub = (pos % bits_per_basic) / bits_per_sub;
+    for (std::size_t s = 0; s < sub; s++) {
+      rank += (entry >> (32 + 10 * s)) & 0x3ff;
+    }
+
+    std::size_t word = pos / 64;
+    for (std::size_t w = basic * words_per_basic + sub * words_per_sub;
+         w < word; w++) {
+      rank += std::popcount(words[w]);
+    }
+    if (pos % 64) {
+      rank += std::popcount(words[word] &
+                            ((static_cast<block_t>(1) << (pos % 64)) - 1));
+    }
+    return rank;
+  }
+
+  // number of clear bits in [0, pos)
+  std::size_t rank0(std::size_t pos) const { return pos - rank1(pos); }
+
+  // position of the k-th set bit (counting from 0), or npos if k >= count()
+  std::size_t select1(std::size_t k) const noexcept {
+    if (k >= ones_)
+      return npos;
+    const block_t* words = bits_->blocks().data();
+
+    // last basic block whose leading rank is <= k
+    std::size_t lo = samples_[k / ones_per_sample];
+    std::size_t hi = samples_[k / ones_per_sample + 1];
+    while (lo < hi) {
+      std::size_t mid = lo + (hi - lo + 1) / 2;
+      if (basic_rank(mid) <= k) {
+        lo = mid;
+      } else {
+        hi = mid - 1;
+      }
+    }
+
+    std::size_t rest = k - basic_rank(lo);
+    std::uint64_t entry = basic_[lo];
+    std::size_t word = lo * words_per_basic;
+    for (std::size_t s = 0; s < 3; s++) {
+      std::size_t sub_count = (entry >> (32 + 10 * s)) & 0x3ff;
+      if (rest < sub_count)
+        break;
+      rest -= sub_count;
+      word += words_per_sub;
+    }
+    for (;; word++) {
+      std::size_t ones = std::popcount(words[word]);
+      if (rest < ones)
+        break;
+      rest -= ones;
+    }
+    return word * 64 + select_in_word(words[word], rest);
+  }
+
+  // bytes used by the directory, excluding the bitset itself
+  std::size_t directory_bytes() const noexcept {
+    return (upper_.size() + basic_.size()) * sizeof(std::uint64_t) +
+           samples_.size() * sizeof(std::size_t);
+  }
+
+private:
+  const Bitset* bits_;
+  std::size_t ones_ = 0;
+  // absolute rank at the start of each 2^32-bit region
+  std::vector<std::uint64_t> upper_;
+  // per basic block: rank within its region | three 10-bit sub-block counts
+  std::vector<std::uint64_t> basic_;
+  // basic block holding the (j * ones_per_sample)-th one, plus a sentinel
+  std::vector<std::size_t> samples_;
+
+  std::size_t basic_rank(std::size_t basic) const noexcept {
+    return upper_[(basic * bits_per_basic) >> 32] + (basic_[basic] & 0xffffffff);
+  }
+
+  // position of the r-th set bit of w, counting from 0
+  static std::size_t select_in_word(std::uint64_t w, std::size_t r) noexcept {
+    for (std::size_t i = 0; i < r; i++) {
+      w &= w - 1;
+    }
+    return std::countr_zero(w);
+  }
+
+  void build() {
+    auto words = bits_->blocks();
+    std::size_t num_basic = words.size() / words_per_basic + 1;
+    // one extra entry so rank1(size()) never reads past the end
+    basic_.assign(num_basic, 0);
+    upper_.assign((num_basic * bits_per_basic >> 32) + 1, 0);
+    samples_.clear();
+
+    std::uint64_t total = 0;
+    for (std::size_t b = 0; b < num_basic; b++) {
+      std::size_t region = (b * bits_per_basic) >> 32;
+      if ((b * bits_per_basic) % (std::uint64_t{1} << 32) == 0) {
+        upper_[region] = total;
+      }
+      std::uint64_t entry = total - upper_[region];
+      std::uint64_t basic_count = 0;
+      for (std::size_t s = 0; s < 4; s++) {
+        std::uint64_t sub_count = 0;
+        for (std::size_t w = 0; w < words_per_sub; w++) {
+          std::size_t idx = b * words_per_basic + s * words_per_sub + w;
+          if (idx < words.size())
+            sub_count += std::popcount(words[idx]);
+        }
+        if (s < 3)
+          entry |= sub_count << (32 + 10 * s);
+        basic_count += sub_count;
+      }
+      basic_[b] = entry;
+
+      // samples whose one falls inside this basic block
+      while (samples_.size() * ones_per_sample < total + basic_count) {
+        samples_.push_back(b);
+      }
+      total += basic_count;
+    }
+    ones_ = total;
+    samples_.push_back(num_basic - 1);
+  }
+};
+
+} // namespace nstd
@@ -0,0 +1,521 @@
+#pragma once
+
+#include "bitset.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace nstd {
+
+// Compressed set of 32-bit values in the style of Roaring bitmaps. Values are
+// grouped by their high 16 bits into chunks of 2^16, and each chunk is stored
+// as whichever container is smallest for its contents:
+//
+//   array   sorted uint16_t values, 2 bytes per value (at most 4096 of them)
+//   bitmap  1024 64-bit words, 8 KiB, driven by the bitset word kernels
+//   run     sorted [start, last] pairs, 4 bytes per run
+//
+// Binary operations pick the best container for every result chunk.
+// add() and remove() only move between array and bitmap (at 4096 values);
+// a run chunk they touch is decoded first, and optimize() re-encodes runs.
+class roaring_bitmap {
+public:
+  using value_type = std::uint32_t;
+
+  roaring_bitmap() = default;
+
+  roaring_bitmap(std::initializer_list<value_type> values) {
+    for (auto v : values)
+      add(v);
+  }
+
+  void add(value_type x) {
+    auto [it, found] = find_key(high(x));
+    std::size_t idx = static_cast<std::size_t>(it - keys_.begin());
+    if (!found) {
+      keys_.insert(it, high(x));
+      containers_.insert(containers_.begin() + static_cast<std::ptrdiff_t>(idx),
+                         array_container{});
+    }
+    container& c = containers_[idx];
+    if (std::holds_alternative<run_container>(c))
+      c = decode_runs(std::get<run_container>(c));
+
+    if (auto* arr = std::get_if<array_container>(&c)) {
+      auto pos = std::lower_bound(arr->values.begin(), arr->values.end(), low(x));
+      if (pos != arr->values.end() && *pos == low(x))
+        return;
+      arr->values.insert(pos, low(x));
+      if (arr->values.size() > array_max)
+        c = to_bitmap(c);
+    } else {
+      auto& bm = std::get<bitmap_container>(c);
+      std::uint64_t bit = std::uint64_t{1} << (low(x) % 64);
+      if (!(bm.words[low(x) / 64] & bit)) {
+        bm.words[low(x) / 64] |= bit;
+        bm.card++;
+      }
+    }
+  }
+
+  void remove(value_type x) {
+    auto [it, found] = find_key(high(x));
+    if (!found)
+      return;
+    std::size_t idx = static_cast<std::size_t>(it - keys_.begin());
+    container& c = containers_[idx];
+    if (std::holds_alternative<run_container>(c))
+      c = decode_runs(std::get<run_container>(c));
+
+    if (auto* arr = std::get_if<array_container>(&c)) {
+      auto pos = std::lower_bound(arr->values.begin(), arr->values.end(), low(x));
+      if (pos != arr->values.end() && *pos == low(x))
+        arr->values.erase(pos);
+    } else {
+      auto& bm = std::get<bitmap_container>(c);
+      std::uint64_t bit = std::uint64_t{1} << (low(x) % 64);
+      if (bm.words[low(x) / 64] & bit) {
+        bm.words[low(x) / 64] &= ~bit;
+        bm.card--;
+      }
+      if (bm.card <= array_max)
+        c = to_array(bm.words.data(), bm.card);
+    }
+    if (cardinality(c) == 0)
+      erase_at(idx);
+  }
+
+  bool contains(value_type x) const noexcept {
+    auto [it, found] = find_key(high(x));
+    return found && contains(containers_[static_cast<std::size_t>(
+                                 it - keys_.begin())],
+                             low(x));
+  }
+
+  std::size_t cardinality() const noexcept {
+    std::size_t sum = 0;
+    for (const auto& c : containers_)
+      sum += cardinality(c);
+    return sum;
+  }
+
+  bool empty() const noexcept { return keys_.empty(); }
+
+  void clear() noexcept {
+    keys_.clear();
+    containers_.clear();
+  }
+
+  // re-picks the smallest container for every chunk, including runs
+  void optimize() {
+    for (auto& c : containers_)
+      c = best_of(to_bitmap(c));
+  }
+
+  // calls f(value) for every value in increasing order
+  template <class F> void for_each(F&& f) const {
+    for (std::size_t i = 0; i < keys_.size(); i++) {
+      value_type base = static_cast<value_type>(keys_[i]) << 16;
+      const container& c = containers_[i];
+      if (auto* arr = std::get_if<array_container>(&c)) {
+        for (auto v : arr->values)
+          f(base | v);
+      } else if (auto* bm = std::get_if<bitmap_container>(&c)) {
+        for (std::size_t v : detail::set_bit_view(bm->words.data(), words))
+          f(base | static_cast<value_type>(v));
+      } else {
+        for (auto r : std::get<run_container>(c).runs)
+          for (value_type v = r.start; v <= r.last; v++)
+            f(base | v);
+      }
+    }
+  }
+
+  std::vector<value_type> to_vector() const {
+    std::vector<value_type> ret;
+    ret.reserve(cardinality());
+    for_each([&](value_type v) { ret.push_back(v); });
+    return ret;
+  }
+
+  // heap bytes held by the containers and the key index
+  std::size_t memory_bytes() const noexcept {
+    std::size_t sum = keys_.capacity() * sizeof(std::uint16_t) +
+                      containers_.capacity() * sizeof(container);
+    for (const auto& c : containers_) {
+      if (auto* arr = std::get_if<array_container>(&c)) {
+        sum += arr->values.capacity() * sizeof(std::uint16_t);
+      } else if (auto* bm = std::get_if<bitmap_container>(&c)) {
+        sum += bm->words.capacity() * sizeof(std::uint64_t);
+      } else {
+        sum += std::get<run_container>(c).runs.capacity() * sizeof(run);
+      }
+    }
+    return sum;
+  }
+
+  roaring_bitmap& operator&=(const roaring_bitmap& rhs) {
+    return *this = combine(*this, rhs, op::and_);
+  }
+
+  roaring_bitmap& operator|=(const roaring_bitmap& rhs) {
+    return *this = combine(*this, rhs, op::or_);
+  }
+
+  roaring_bitmap& operator^=(const roaring_bitmap& rhs) {
+    return *this = combine(*this, rhs, op::xor_);
+  }
+
+  // removes every value that is also in rhs
+  roaring_bitmap& and_not(const roaring_bitmap& rhs) {
+    return *this = combine(*this, rhs, op::and_not);
+  }
+
+  friend roaring_bitmap operator&(const roaring_bitmap& lhs,
+                                  const roaring_bitmap& rhs) {
+    return combine(lhs, rhs, op::and_);
+  }
+
+  friend roaring_bitmap operator|(const roaring_bitmap& lhs,
+                                  const roaring_bitmap& rhs) {
+    return combine(lhs, rhs, op::or_);
+  }
+
+  friend roaring_bitmap operator^(const roaring_bitmap& lhs,
+                                  const roaring_bitmap& rhs) {
+    return combine(lhs, rhs, op::xor_);
+  }
+
+  friend roaring_bitmap and_not(const roaring_bitmap& lhs,
+                                const roaring_bitmap& rhs) {
+    return combine(lhs, rhs, op::and_not);
+  }
+
+  bool operator==(const roaring_bitmap& rhs) const {
+    if (keys_ != rhs.keys_)
+      return false;
+    for (std::size_t i = 0; i < keys_.size(); i++) {
+      const container &a = containers_[i], &b = rhs.containers_[i];
+      auto* x = std::get_if<array_container>(&a);
+      auto* y = std::get_if<array_container>(&b);
+      if (x && y) {
+        if (x->values != y->values)
+          return false;
+      } else if (!detail::block_equal(to_bitmap(a).words.data(),
+                                      to_bitmap(b).words.data(), words)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  constexpr static std::size_t words = 1024;
+  constexpr static std::size_t array_max = 4096;
+
+  struct run {
+    std::uint16_t start;
+    std::uint16_t last;
+  };
+
+  struct array_container {
+    std::vector<std::uint16_t> values;
+  };
+
+  struct bitmap_container {
+    std::vector<std::uint64_t> words = std::vector<std::uint64_t>(1024);
+    std::uint32_t card = 0;
+  };
+
+  struct run_container {
+    std::vector<run> runs;
+  };
+
+  using container =
+      std::variant<array_container, bitmap_container, run_container>;
+
+  enum class op { and_, or_, xor_, and_not };
+
+  std::vector<std::uint16_t> keys_;
+  std::vector<container> containers_;
+
+  static std::uint16_t high(value_type x) noexcept {
+    return static_cast<std::uint16_t>(x >> 16);
+  }
+
+  static std::uint16_t low(value_type x) noexcept {
+    return static_cast<std::uint16_t>(x);
+  }
+
+  std::pair<std::vector<std::uint16_t>::const_iterator, bool>
+  find_key(std::uint16_t key) const noexcept {
+    auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+    return {it, it != keys_.end() && *it == key};
+  }
+
+  std::pair<std::vector<std::uint16_t>::iterator, bool>
+  find_key(std::uint16_t key) noexcept {
+    auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+    return {it, it != keys_.end() && *it == key};
+  }
+
+  void erase_at(std::size_t idx) {
+    keys_.erase(keys_.begin() + static_cast<std::ptrdiff_t>(idx));
+    containers_.erase(containers_.begin() + static_cast<std::ptrdiff_t>(idx));
+  }
+
+  static std::size_t cardinality(const container& c) noexcept {
+    if (auto* arr = std::get_if<array_container>(&c))
+      return arr->values.size();
+    if (auto* bm = std::get_if<bitmap_container>(&c))
+      return bm->card;
+    std::size_t sum = 0;
+    for (auto r : std::get<run_container>(c).runs)
+      sum += static_cast<std::size_t>(r.last - r.start) + 1;
+    return sum;
+  }
+
+  static bool contains(const container& c, std::uint16_t v) noexcept {
+    if (auto* arr = std::get_if<array_container>(&c))
+      return std::binary_search(arr->values.begin(), arr->values.end(), v);
+    if (auto* bm = std::get_if<bitmap_container>(&c))
+      return (bm->words[v / 64] >> (v % 64)) & 1;
+    const auto& runs = std::get<run_container>(c).runs;
+    auto it = std::upper_bound(runs.begin(), runs.end(), v,
+                               [](std::uint16_t x, run r) { return x < r.start; });
+    return it != runs.begin() && v <= std::prev(it)->last;
+  }
+
+  // writes the bits of c into a zeroed 1024-word buffer
+  static void load(const container& c, std::uint64_t* w) noexcept {
+    if (auto* bm = std::get_if<bitmap_container>(&c)) {
+      std::copy_n(bm->words.data(), words, w);
+      return;
+    }
+    std::fill_n(w, words, std::uint64_t{0});
+    if (auto* arr = std::get_if<array_container>(&c)) {
+      for (auto v : arr->values)
+        w[v / 64] |= std::uint64_t{1} << (v % 64);
+    } else {
+      for (auto r : std::get<run_container>(c).runs)
+        detail::set_range(w, r.start, std::size_t{r.last} + 1);
+    }
+  }
+
+  static bitmap_container to_bitmap(const container& c) {
+    if (auto* bm = std::get_if<bitmap_container>(&c))
+      return *bm;
+    bitmap_container ret;
+    load(c, ret.words.data());
+    ret.card = static_cast<std::uint32_t>(cardinality(c));
+    return ret;
+  }
+
+  static array_container to_array(const std::uint64_t* w, std::size_t card) {
+    array_container ret;
+    ret.values.resize(card);
+    std::uint16_t* out = ret.values.data();
+    for (std::size_t i = 0; i < words; i++) {
+      for (std::uint64_t bits = w[i]; bits; bits &= bits - 1) {
+        *out++ = static_cast<std::uint16_t>(i * 64 + std::countr_zero(bits));
+      }
+    }
+    return ret;
+  }
+
+  static container decode_runs(const run_container& rc) {
+    container c = rc;
+    if (cardinality(c) > array_max)
+      return to_bitmap(c);
+    array_container ret;
+    for (auto r : rc.runs)
+      for (std::uint32_t v = r.start; v <= r.last; v++)
+        ret.values.push_back(static_cast<std::uint16_t>(v));
+    return ret;
+  }
+
+  static std::size_t count_runs(const std::uint64_t* w) noexcept {
+    // a run starts at every set bit whose lower neighbour is clear; the
+    // starts are gathered first so the popcount goes through block_count
+    std::uint64_t starts[words];
+    starts[0] = w[0] & ~(w[0] << 1);
+    for (std::size_t i = 1; i < words; i++)
+      starts[i] = w[i] & ~((w[i] << 1) | (w[i - 1] >> 63));
+    return detail::block_count(starts, words);
+  }
+
+  static run_container to_runs(const std::uint64_t* w) {
+    run_container ret;
+    std::size_t pos = detail::find_from(w, words, 0);
+    while (pos != detail::npos) {
+      // the run ends at the next clear bit
+      std::size_t end = pos;
+      while (end < 65536 && ((w[end / 64] >> (end % 64)) & 1)) {
+        std::uint64_t rest = ~w[end / 64] >> (end % 64);
+        end += rest ? static_cast<std::size_t>(std::countr_zero(rest))
+                    : 64 - end % 64;
+      }
+      ret.runs.push_back({static_cast<std::uint16_t>(pos),
+                          static_cast<std::uint16_t>(end - 1)});
+      pos = end < 65536 ? detail::find_from(w, words, end) : detail::npos;
+    }
+    return ret;
+  }
+
+  enum class kind { array, bitmap, run };
+
+  // the smallest of array (2 bytes/value), run (4 bytes/run) and bitmap
+  static kind smallest(const std::uint64_t* w, std::size_t card) noexcept {
+    std::size_t other_bytes = std::min<std::size_t>(2 * card, 8192);
+    if (4 * count_runs(w) < other_bytes)
+      return kind::run;
+    return card <= array_max ? kind::array : kind::bitmap;
+  }
+
+  static container best_of(bitmap_container&& bm) {
+    switch (smallest(bm.words.data(), bm.card)) {
+    case kind::run:
+      return to_runs(bm.words.data());
+    case kind::array:
+      return to_array(bm.words.data(), bm.card);
+    case kind::bitmap:
+      break;
+    }
+    return std::move(bm);
+  }
+
+  // for results that only exist in a scratch buffer, so that the allocation
+  // is made for the chosen container alone
+  static container best_of(const std::uint64_t* w) {
+    std::size_t card = detail::block_count(w, words);
+    switch (smallest(w, card)) {
+    case kind::run:
+      return to_runs(w);
+    case kind::array:
+      return to_array(w, card);
+    case kind::bitmap:
+      break;
+    }
+    bitmap_container ret{std::vector<std::uint64_t>(w, w + words),
+                         static_cast<std::uint32_t>(card)};
+    return ret;
+  }
+
+  static container best_of(array_container&& arr) {
+    std::size_t runs = arr.values.empty() ? 0 : 1;
+    for (std::size_t i = 1; i < arr.values.size(); i++)
+      runs += arr.values[i] != arr.values[i - 1] + 1;
+    if (4 * runs < 2 * arr.values.size() || arr.values.size() > array_max)
+      return best_of(to_bitmap(std::move(arr)));
+    return std::move(arr);
+  }
+
+  static container apply(const container& a, const container& b, op o) {
+    auto* x = std::get_if<array_container>(&a);
+    auto* y = std::get_if<array_container>(&b);
+    if (x && y) {
+      array_container ret;
+      auto out = std::back_inserter(ret.values);
+      const auto &l = x->values, &r = y->values;
+      switch (o) {
+      case op::and_:
+        std::set_intersection(l.begin(), l.end(), r.begin(), r.end(), out);
+        break;
+      case op::or_:
+        std::set_union(l.begin(), l.end(), r.begin(), r.end(), out);
+        break;
+      case op::xor_:
+        std::set_symmetric_difference(l.begin(), l.end(), r.begin(), r.end(),
+                                      out);
+        break;
+      case op::and_not:
+        std::set_difference(l.begin(), l.end(), r.begin(), r.end(), out);
+        break;
+      }
+      return best_of(std::move(ret));
+    }
+
+    // an array filtered through the other container stays an array
+    if ((o == op::and_ && (x || y)) || (o == op::and_not && x)) {
+      const auto& arr = x ? *x : *y;
+      const container& other = x ? b : a;
+      bool keep = o == op::and_;
+      array_container ret;
+      for (auto v : arr.values)
+        if (contains(other, v) == keep)
+          ret.values.push_back(v);
+      return best_of(std::move(ret));
+    }
+
+    // everything else runs the word kernels over two dense buffers
+    std::uint64_t lhs[words], scratch[words];
+    load(a, lhs);
+    const std::uint64_t* rhs;
+    if (auto* bm = std::get_if<bitmap_container>(&b)) {
+      rhs = bm->words.data();
+    } else {
+      load(b, scratch);
+      rhs = scratch;
+    }
+    switch (o) {
+    case op::and_:
+      detail::block_and(lhs, rhs, words);
+      break;
+    case op::or_:
+      detail::block_or(lhs, rhs, words);
+      break;
+    case op::xor_:
+      detail::block_xor(lhs, rhs, words);
+      break;
+    case op::and_not:
+      if (rhs != scratch) {
+        std::copy_n(rhs, words, scratch);
+      }
+      detail::block_flip(scratch, words);
+      detail::block_and(lhs, scratch, words);
+      break;
+    }
+    return best_of(lhs);
+  }
+
+  static roaring_bitmap combine(const roaring_bitmap& a, const roaring_bitmap& b,
+                                op o) {
+    roaring_bitmap ret;
+    std::size_t i = 0, j = 0;
+    auto emit = [&](std::uint16_t key, container&& c) {
+      if (cardinality(c) != 0) {
+        ret.keys_.push_back(key);
+        ret.containers_.push_back(std::move(c));
+      }
+    };
+    // chunks present on only one side survive unchanged, except under and_
+    // (both sides needed) and and_not (only the left side counts)
+    bool keep_left = o != op::and_;
+    bool keep_right = o == op::or_ || o == op::xor_;
+    while (i < a.keys_.size() || j < b.keys_.size()) {
+      if (j == b.keys_.size() ||
+          (i < a.keys_.size() && a.keys_[i] < b.keys_[j])) {
+        if (keep_left)
+          emit(a.keys_[i], container(a.containers_[i]));
+        i++;
+      } else if (i == a.keys_.size() || b.keys_[j] < a.keys_[i]) {
+        if (keep_right)
+          emit(b.keys_[j], container(b.containers_[j]));
+        j++;
+      } else {
+        emit(a.keys_[i], apply(a.containers_[i], b.containers_[j], o));
+        i++;
+        j++;
+      }
+    }
+    return ret;
+  }
+};
+
+} // namespace nstd
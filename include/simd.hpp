@@ -0,0 +1,1151 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define NSTD_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define NSTD_SIMD_X86 0
+#endif
+
+// Bulk kernels over arrays of 64-bit words, with one implementation per
+// instruction set. The best set the CPU supports is picked once, on first
+// use, and every later call goes through the same table of function
+// pointers. Each x86 kernel is compiled with a target attribute, so none of
+// this needs -mavx2 or similar on the command line.
+
+namespace nstd::detail::simd {
+
+using word = std::uint64_t;
+
+enum class isa { scalar, sse2, avx2, avx512 };
+
+// how the pair-count kernels combine two words before counting
+enum class pair_op { bit_and, bit_or, bit_xor };
+
+// below this many words the call through the table costs more than it saves
+inline constexpr std::size_t min_words = 16;
+
+struct kernels {
+  isa level;
+  void (*bit_and)(word* dst, const word* src, std::size_t n) noexcept;
+  void (*bit_or)(word* dst, const word* src, std::size_t n) noexcept;
+  void (*bit_xor)(word* dst, const word* src, std::size_t n) noexcept;
+  void (*bit_not)(word* dst, std::size_t n) noexcept;
+  std::size_t (*count)(const word* src, std::size_t n) noexcept;
+  bool (*any)(const word* src, std::size_t n) noexcept;
+  // true if every word is all ones
+  bool (*all)(const word* src, std::size_t n) noexcept;
+  bool (*equal)(const word* lhs, const word* rhs, std::size_t n) noexcept;
+  // Text kernels. parse packs text[i] == one into bit i of out, writing all
+  // (n + 63) / 64 words, and returns the index of the first character that
+  // is neither zero nor one, or n. format writes bits [0, n) of src as
+  // characters, bit n - 1 first, the way to_string orders them.
+  std::size_t (*parse)(const char* text, std::size_t n, char zero, char one,
+                       word* out) noexcept;
+  void (*format)(const word* src, std::size_t n, char zero, char one,
+                 char* out) noexcept;
+  // Bit gather and scatter. pext packs the bits of src selected by mask
+  // into the low bits of the result; pdep is the inverse.
+  word (*pext)(word src, word mask) noexcept;
+  word (*pdep)(word src, word mask) noexcept;
+  // One-to-many pair counts for similarity search. base holds n
+  // fingerprints of `words` words each, back to back, and out[j] receives
+  // popcount(q & base[j]), popcount(q | base[j]) or popcount(q ^ base[j]).
+  void (*count_and_many)(const word* q, const word* base, std::size_t words,
+                         std::size_t n, std::size_t* out) noexcept;
+  void (*count_or_many)(const word* q, const word* base, std::size_t words,
+                        std::size_t n, std::size_t* out) noexcept;
+  void (*count_xor_many)(const word* q, const word* base, std::size_t words,
+                         std::size_t n, std::size_t* out) noexcept;
+  // Split-block Bloom filter probes, see sbbf_block() and sbbf_mask() in
+  // the scalar namespace. blocks holds num_blocks blocks of four words;
+  // out[j] is whether every bit for hashes[j] is set.
+  void (*sbbf_insert)(word* blocks, std::size_t num_blocks, const word* hashes,
+                      std::size_t n) noexcept;
+  void (*sbbf_contains)(const word* blocks, std::size_t num_blocks,
+                        const word* hashes, std::size_t n, bool* out) noexcept;
+  // Hash accumulation, see hash_secret. Folds `stripes` stripes of
+  // hash_lanes words from src into acc[0, hash_lanes), scrambling acc after
+  // every hash_scramble stripes counted from src.
+  void (*hash_stripes)(word* acc, const word* src,
+                       std::size_t stripes) noexcept;
+};
+
+// Bitset hashing, in the style of XXH3: eight 64-bit accumulator lanes, one
+// per word of each 64-byte stripe. Word w of lane l adds
+// lo32(k) * hi32(k), with k = w ^ hash_secret[l], to lane l and w itself to
+// the neighbouring lane l ^ 1, so a product that happens to be zero still
+// leaves w in the sum. Every hash_scramble stripes each lane is mixed with
+// a shift, hash_scramble_key and a 32-bit multiply. All of it maps onto
+// 32x32->64-bit vector multiplies.
+inline constexpr std::size_t hash_lanes = 8;
+inline constexpr std::size_t hash_scramble = 16;
+inline constexpr word hash_secret[hash_lanes] = {
+    0x6175412377aeb3ebULL, 0x63b476cb15d8226aULL, 0x52098a39fc31a4f4ULL,
+    0xa86e8f4e8bf90afdULL, 0x11ea0498f374a585ULL, 0xa1cdb5b25a5601acULL,
+    0xbd45750d8f748a8bULL, 0x58138602eead46dfULL};
+inline constexpr word hash_scramble_key[hash_lanes] = {
+    0xbe43a9bb4ee75167ULL, 0x563336d7d4b62d6aULL, 0x18f07eafe6a0dca7ULL,
+    0x66658845f8fd2f46ULL, 0x6bf566760f2dfc11ULL, 0x9a813f0952a5e175ULL,
+    0x4913bf683adaa9e3ULL, 0xfd813b25c733a6b0ULL};
+inline constexpr word hash_prime = 0x9e3779b1U;
+
+// Split-block Bloom filter layout: each key touches one 256-bit block,
+// chosen by the high half of its 64-bit hash, and sets one bit in each of
+// the block's eight 32-bit lanes, chosen by multiplying the low half by a
+// per-lane odd constant and keeping the top five bits. Lane i is bits
+// [32 * i, 32 * i + 32) of the block.
+inline constexpr std::uint32_t sbbf_salt[8] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+inline constexpr std::size_t sbbf_block_words = 4;
+// software prefetch distance of the batched probes, in keys
+inline constexpr std::size_t sbbf_prefetch = 8;
+
+namespace scalar {
+
+inline void bit_and(word* dst, const word* src, std::size_t n) noexcept {
+  for (std::size_t i = 0; i < n; i++) {
+    dst[i] &= src[i];
+  }
+}
+
+inline void bit_or(word* dst, const word* src, std::size_t n) noexcept {
+  for (std::size_t i = 0; i < n; i++) {
+    dst[i] |= src[i];
+  }
+}
+
+inline void bit_xor(word* dst, const word* src, std::size_t n) noexcept {
+  for (std::size_t i = 0; i < n; i++) {
+    dst[i] ^= src[i];
+  }
+}
+
+inline void bit_not(word* dst, std::size_t n) noexcept {
+  for (std::size_t i = 0; i < n; i++) {
+    dst[i] = ~dst[i];
+  }
+}
+
+inline std::size_t count(const word* src, std::size_t n) noexcept {
+  std::size_t sum = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    sum += std::popcount(src[i]);
+  }
+  return sum;
+}
+
+inline bool any(const word* src, std::size_t n) noexcept {
+  for (std::size_t i = 0; i < n; i++) {
+    if (src[i])
+      return true;
+  }
+  return false;
+}
+
+inline bool all(const word* src, std::size_t n) noexcept {
+  for (std::size_t i = 0; i < n; i++) {
+    if (~src[i])
+      return false;
+  }
+  return true;
+}
+
+inline bool equal(const word* lhs, const word* rhs, std::size_t n) noexcept {
+  for (std::size_t i = 0; i < n; i++) {
+    if (lhs[i] != rhs[i])
+      return false;
+  }
+  return true;
+}
+
+inline std::size_t parse(const char* text, std::size_t n, char zero, char one,
+                         word* out) noexcept {
+  std::size_t bad = n;
+  for (std::size_t w = 0; w * 64 < n; w++) {
+    std::size_t len = n - w * 64 < 64 ? n - w * 64 : 64;
+    word bits = 0;
+    for (std::size_t i = 0; i < len; i++) {
+      char c = text[w * 64 + i];
+      if (c == one) {
+        bits |= word{1} << i;
+      } else if (c != zero && bad == n) {
+        bad = w * 64 + i;
+      }
+    }
+    out[w] = bits;
+  }
+  return bad;
+}
+
+// writes bits [first, last) of src, bit last - 1 first
+inline void format_range(const word* src, std::size_t first, std::size_t last,
+                         char zero, char one, char* out) noexcept {
+  for (std::size_t i = last; i-- > first;) {
+    *out++ = (src[i / 64] >> (i % 64)) & 1 ? one : zero;
+  }
+}
+
+inline void format(const word* src, std::size_t n, char zero, char one,
+                   char* out) noexcept {
+  format_range(src, 0, n, zero, one, out);
+}
+
+template <pair_op Op> constexpr word combine(word a, word b) noexcept {
+  if constexpr (Op == pair_op::bit_and) {
+    return a & b;
+  } else if constexpr (Op == pair_op::bit_or) {
+    return a | b;
+  } else {
+    return a ^ b;
+  }
+}
+
+template <pair_op Op>
+void count_many(const word* q, const word* base, std::size_t words,
+                std::size_t n, std::size_t* out) noexcept {
+  for (std::size_t j = 0; j < n; j++, base += words) {
+    std::size_t sum = 0;
+    for (std::size_t i = 0; i < words; i++) {
+      sum += std::popcount(combine<Op>(q[i], base[i]));
+    }
+    out[j] = sum;
+  }
+}
+
+// index of the block for hash h; num_blocks must be below 2^32
+inline std::size_t sbbf_block(word h, std::size_t num_blocks) noexcept {
+  return static_cast<std::size_t>(((h >> 32) * num_blocks) >> 32);
+}
+
+// the bits of lanes 2 * w and 2 * w + 1 for hash h, as word w of the block
+inline word sbbf_mask(word h, std::size_t w) noexcept {
+  auto key = static_cast<std::uint32_t>(h);
+  auto lo = static_cast<std::uint32_t>(key * sbbf_salt[2 * w]) >> 27;
+  auto hi = static_cast<std::uint32_t>(key * sbbf_salt[2 * w + 1]) >> 27;
+  return (word{1} << lo) | (word{1} << (32 + hi));
+}
+
+inline void sbbf_insert(word* blocks, std::size_t num_blocks,
+                        const word* hashes, std::size_t n) noexcept {
+  for (std::size_t j = 0; j < n; j++) {
+    if (j + sbbf_prefetch < n)
+      __builtin_prefetch(blocks + sbbf_block_words *
+                                      sbbf_block(hashes[j + sbbf_prefetch],
+                                                 num_blocks));
+    word* b = blocks + sbbf_block_words * sbbf_block(hashes[j], num_blocks);
+    for (std::size_t w = 0; w < sbbf_block_words; w++) {
+      b[w] |= sbbf_mask(hashes[j], w);
+    }
+  }
+}
+
+inline void sbbf_contains(const word* blocks, std::size_t num_blocks,
+                          const word* hashes, std::size_t n,
+                          bool* out) noexcept {
+  for (std::size_t j = 0; j < n; j++) {
+    if (j + sbbf_prefetch < n)
+      __builtin_prefetch(blocks + sbbf_block_words *
+                                      sbbf_block(hashes[j + sbbf_prefetch],
+                                                 num_blocks));
+    const word* b =
+        blocks + sbbf_block_words * sbbf_block(hashes[j], num_blocks);
+    bool found = true;
+    for (std::size_t w = 0; w < sbbf_block_words; w++) {
+      word m = sbbf_mask(hashes[j], w);
+      found &= (b[w] & m) == m;
+    }
+    out[j] = found;
+  }
+}
+
+// one word into lane l, and the scramble, for hash_stripes and the tails
+constexpr void hash_word(word* acc, std::size_t l, word w) noexcept {
+  word k = w ^ hash_secret[l];
+  acc[l] += (k & 0xffffffffU) * (k >> 32);
+  acc[l ^ 1] += w;
+}
+
+constexpr void hash_mix(word* acc) noexcept {
+  for (std::size_t l = 0; l < hash_lanes; l++) {
+    word a = acc[l] ^ (acc[l] >> 47) ^ hash_scramble_key[l];
+    acc[l] = a * hash_prime;
+  }
+}
+
+constexpr void hash_stripes(word* acc, const word* src,
+                            std::size_t stripes) noexcept {
+  // a local copy, or every update goes through memory in case acc and src
+  // alias
+  word a[hash_lanes];
+  std::copy_n(acc, hash_lanes, a);
+  for (std::size_t s = 0; s < stripes; s++) {
+    for (std::size_t l = 0; l < hash_lanes; l++)
+      hash_word(a, l, src[s * hash_lanes + l]);
+    if ((s + 1) % hash_scramble == 0)
+      hash_mix(a);
+  }
+  std::copy_n(a, hash_lanes, acc);
+}
+
+constexpr word pext(word src, word mask) noexcept {
+  word ret = 0;
+  for (word out = 1; mask; mask &= mask - 1, out <<= 1) {
+    if (src & mask & -mask)
+      ret |= out;
+  }
+  return ret;
+}
+
+constexpr word pdep(word src, word mask) noexcept {
+  word ret = 0;
+  for (; mask; mask &= mask - 1, src >>= 1) {
+    if (src & 1)
+      ret |= mask & -mask;
+  }
+  return ret;
+}
+
+} // namespace scalar
+
+#if NSTD_SIMD_X86
+
+#define NSTD_TARGET(isa) __attribute__((target(isa)))
+
+namespace popcnt {
+
+NSTD_TARGET("popcnt")
+inline std::size_t count(const word* src, std::size_t n) noexcept {
+  std::size_t sum = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    sum += static_cast<std::size_t>(__builtin_popcountll(src[i]));
+  }
+  return sum;
+}
+
+template <pair_op Op>
+NSTD_TARGET("popcnt")
+void count_many(const word* q, const word* base, std::size_t words,
+                std::size_t n, std::size_t* out) noexcept {
+  for (std::size_t j = 0; j < n; j++, base += words) {
+    std::size_t sum = 0;
+    for (std::size_t i = 0; i < words; i++) {
+      sum += static_cast<std::size_t>(
+          __builtin_popcountll(scalar::combine<Op>(q[i], base[i])));
+    }
+    out[j] = sum;
+  }
+}
+
+} // namespace popcnt
+
+namespace sse2 {
+
+// two words per __m128i
+NSTD_TARGET("sse2") inline __m128i load(const word* p) noexcept {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+NSTD_TARGET("sse2") inline void store(word* p, __m128i v) noexcept {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+NSTD_TARGET("sse2")
+inline void bit_and(word* dst, const word* src, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    store(dst + i, _mm_and_si128(load(dst + i), load(src + i)));
+  }
+  scalar::bit_and(dst + i, src + i, n - i);
+}
+
+NSTD_TARGET("sse2")
+inline void bit_or(word* dst, const word* src, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    store(dst + i, _mm_or_si128(load(dst + i), load(src + i)));
+  }
+  scalar::bit_or(dst + i, src + i, n - i);
+}
+
+NSTD_TARGET("sse2")
+inline void bit_xor(word* dst, const word* src, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    store(dst + i, _mm_xor_si128(load(dst + i), load(src + i)));
+  }
+  scalar::bit_xor(dst + i, src + i, n - i);
+}
+
+NSTD_TARGET("sse2") inline void bit_not(word* dst, std::size_t n) noexcept {
+  const __m128i ones = _mm_set1_epi32(-1);
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    store(dst + i, _mm_xor_si128(load(dst + i), ones));
+  }
+  scalar::bit_not(dst + i, n - i);
+}
+
+NSTD_TARGET("sse2")
+inline bool any(const word* src, std::size_t n) noexcept {
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i acc = _mm_or_si128(_mm_or_si128(load(src + i), load(src + i + 2)),
+                               _mm_or_si128(load(src + i + 4),
+                                            load(src + i + 6)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, zero)) != 0xffff)
+      return true;
+  }
+  return scalar::any(src + i, n - i);
+}
+
+NSTD_TARGET("sse2")
+inline bool all(const word* src, std::size_t n) noexcept {
+  const __m128i ones = _mm_set1_epi32(-1);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i acc =
+        _mm_and_si128(_mm_and_si128(load(src + i), load(src + i + 2)),
+                      _mm_and_si128(load(src + i + 4), load(src + i + 6)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, ones)) != 0xffff)
+      return false;
+  }
+  return scalar::all(src + i, n - i);
+}
+
+NSTD_TARGET("sse2")
+inline bool equal(const word* lhs, const word* rhs, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(load(lhs + i), load(rhs + i))) !=
+        0xffff)
+      return false;
+  }
+  return scalar::equal(lhs + i, rhs + i, n - i);
+}
+
+// compare + movemask: 16 characters become 16 bits per step
+NSTD_TARGET("sse2")
+inline std::size_t parse(const char* text, std::size_t n, char zero, char one,
+                         word* out) noexcept {
+  const __m128i zeros = _mm_set1_epi8(zero), ones = _mm_set1_epi8(one);
+  std::size_t bad = n, i = 0;
+  for (; i + 64 <= n; i += 64) {
+    word bits = 0, valid = 0;
+    for (std::size_t k = 0; k < 64; k += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + k));
+      auto is_one = static_cast<word>(
+          static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, ones))));
+      auto is_zero = static_cast<word>(
+          static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zeros))));
+      bits |= is_one << k;
+      valid |= (is_one | is_zero) << k;
+    }
+    out[i / 64] = bits;
+    if (~valid && bad == n)
+      bad = i + static_cast<std::size_t>(std::countr_zero(~valid));
+  }
+  std::size_t tail = scalar::parse(text + i, n - i, zero, one, out + i / 64);
+  return bad != n ? bad : i + tail;
+}
+
+} // namespace sse2
+
+namespace bmi2 {
+
+NSTD_TARGET("bmi2")
+inline word pext(word src, word mask) noexcept {
+  return _pext_u64(src, mask);
+}
+
+NSTD_TARGET("bmi2")
+inline word pdep(word src, word mask) noexcept {
+  return _pdep_u64(src, mask);
+}
+
+} // namespace bmi2
+
+namespace ssse3 {
+
+// Shuffle expansion: each output byte picks the input byte holding its bit
+// and tests that bit, so 16 bits become 16 characters per step. The top
+// n % 16 bits, which come first in the text, are written by the scalar loop.
+NSTD_TARGET("ssse3")
+inline void format(const word* src, std::size_t n, char zero, char one,
+                   char* out) noexcept {
+  const __m128i zeros = _mm_set1_epi8(zero), ones = _mm_set1_epi8(one);
+  // output byte j shows bit 15 - j of the unit: byte 1 first, then byte 0
+  const __m128i pick =
+      _mm_setr_epi8(1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+  // and within a byte, bit 7 - j % 8
+  const __m128i bits = _mm_set1_epi64x(0x0102040810204080);
+  std::size_t lead = n % 16;
+  scalar::format_range(src, n - lead, n, zero, one, out);
+  out += lead;
+  for (std::size_t k = (n - lead) / 16; k-- > 0; out += 16) {
+    auto unit = static_cast<short>(src[k / 4] >> (16 * (k % 4)));
+    __m128i v = _mm_shuffle_epi8(_mm_set1_epi16(unit), pick);
+    __m128i set = _mm_cmpeq_epi8(_mm_and_si128(v, bits), bits);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                     _mm_or_si128(_mm_and_si128(set, ones),
+                                  _mm_andnot_si128(set, zeros)));
+  }
+}
+
+} // namespace ssse3
+
+namespace avx2 {
+
+// four words per __m256i
+NSTD_TARGET("avx2") inline __m256i load(const word* p) noexcept {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+NSTD_TARGET("avx2") inline void store(word* p, __m256i v) noexcept {
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+
+NSTD_TARGET("avx2")
+inline void bit_and(word* dst, const word* src, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    store(dst + i, _mm256_and_si256(load(dst + i), load(src + i)));
+  }
+  scalar::bit_and(dst + i, src + i, n - i);
+}
+
+NSTD_TARGET("avx2")
+inline void bit_or(word* dst, const word* src, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    store(dst + i, _mm256_or_si256(load(dst + i), load(src + i)));
+  }
+  scalar::bit_or(dst + i, src + i, n - i);
+}
+
+NSTD_TARGET("avx2")
+inline void bit_xor(word* dst, const word* src, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    store(dst + i, _mm256_xor_si256(load(dst + i), load(src + i)));
+  }
+  scalar::bit_xor(dst + i, src + i, n - i);
+}
+
+NSTD_TARGET("avx2") inline void bit_not(word* dst, std::size_t n) noexcept {
+  const __m256i ones = _mm256_set1_epi32(-1);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    store(dst + i, _mm256_xor_si256(load(dst + i), ones));
+  }
+  scalar::bit_not(dst + i, n - i);
+}
+
+// popcount of each byte via a nibble lookup, summed into four 64-bit lanes
+NSTD_TARGET("avx2") inline __m256i popcount_lanes(__m256i v) noexcept {
+  const __m256i lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1,
+                       2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  __m256i lo = _mm256_and_si256(v, low_mask);
+  __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+  __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                  _mm256_shuffle_epi8(lookup, hi));
+  return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+}
+
+// carry-save adder: (high, low) = a + b + c, bitwise
+NSTD_TARGET("avx2")
+inline void csa(__m256i& high, __m256i& low, __m256i a, __m256i b,
+                __m256i c) noexcept {
+  __m256i u = _mm256_xor_si256(a, b);
+  high = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+  low = _mm256_xor_si256(u, c);
+}
+
+// Harley-Seal: sixteen vectors are folded through a tree of carry-save
+// adders, so only one full popcount is needed per sixteen loads.
+NSTD_TARGET("avx2")
+inline std::size_t count(const word* src, std::size_t n) noexcept {
+  __m256i total = _mm256_setzero_si256();
+  __m256i ones = _mm256_setzero_si256();
+  __m256i twos = _mm256_setzero_si256();
+  __m256i fours = _mm256_setzero_si256();
+  __m256i eights = _mm256_setzero_si256();
+  __m256i sixteens, twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+  std::size_t i = 0;
+  for (; i + 64 <= n; i += 64) {
+    const word* p = src + i;
+    csa(twos_a, ones, ones, load(p), load(p + 4));
+    csa(twos_b, ones, ones, load(p + 8), load(p + 12));
+    csa(fours_a, twos, twos, twos_a, twos_b);
+    csa(twos_a, ones, ones, load(p + 16), load(p + 20));
+    csa(twos_b, ones, ones, load(p + 24), load(p + 28));
+    csa(fours_b, twos, twos, twos_a, twos_b);
+    csa(eights_a, fours, fours, fours_a, fours_b);
+    csa(twos_a, ones, ones, load(p + 32), load(p + 36));
+    csa(twos_b, ones, ones, load(p + 40), load(p + 44));
+    csa(fours_a, twos, twos, twos_a, twos_b);
+    csa(twos_a, ones, ones, load(p + 48), load(p + 52));
+    csa(twos_b, ones, ones, load(p + 56), load(p + 60));
+    csa(fours_b, twos, twos, twos_a, twos_b);
+    csa(eights_b, fours, fours, fours_a, fours_b);
+    csa(sixteens, eights, eights, eights_a, eights_b);
+    total = _mm256_add_epi64(total, popcount_lanes(sixteens));
+  }
+
+  total = _mm256_slli_epi64(total, 4);
+  total = _mm256_add_epi64(total,
+                           _mm256_slli_epi64(popcount_lanes(eights), 3));
+  total =
+      _mm256_add_epi64(total, _mm256_slli_epi64(popcount_lanes(fours), 2));
+  total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_lanes(twos), 1));
+  total = _mm256_add_epi64(total, popcount_lanes(ones));
+  for (; i + 4 <= n; i += 4) {
+    total = _mm256_add_epi64(total, popcount_lanes(load(src + i)));
+  }
+
+  std::size_t sum = static_cast<std::size_t>(_mm256_extract_epi64(total, 0)) +
+                    static_cast<std::size_t>(_mm256_extract_epi64(total, 1)) +
+                    static_cast<std::size_t>(_mm256_extract_epi64(total, 2)) +
+                    static_cast<std::size_t>(_mm256_extract_epi64(total, 3));
+  return sum + scalar::count(src + i, n - i);
+}
+
+NSTD_TARGET("avx2")
+inline bool any(const word* src, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i acc =
+        _mm256_or_si256(_mm256_or_si256(load(src + i), load(src + i + 4)),
+                        _mm256_or_si256(load(src + i + 8), load(src + i + 12)));
+    if (!_mm256_testz_si256(acc, acc))
+      return true;
+  }
+  return scalar::any(src + i, n - i);
+}
+
+NSTD_TARGET("avx2")
+inline bool all(const word* src, std::size_t n) noexcept {
+  const __m256i ones = _mm256_set1_epi32(-1);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i acc = _mm256_and_si256(
+        _mm256_and_si256(load(src + i), load(src + i + 4)),
+        _mm256_and_si256(load(src + i + 8), load(src + i + 12)));
+    if (!_mm256_testc_si256(acc, ones))
+      return false;
+  }
+  return scalar::all(src + i, n - i);
+}
+
+NSTD_TARGET("avx2")
+inline bool equal(const word* lhs, const word* rhs, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i diff =
+        _mm256_or_si256(_mm256_xor_si256(load(lhs + i), load(rhs + i)),
+                        _mm256_xor_si256(load(lhs + i + 4), load(rhs + i + 4)));
+    if (!_mm256_testz_si256(diff, diff))
+      return false;
+  }
+  return scalar::equal(lhs + i, rhs + i, n - i);
+}
+
+NSTD_TARGET("avx2")
+inline std::size_t parse(const char* text, std::size_t n, char zero, char one,
+                         word* out) noexcept {
+  const __m256i zeros = _mm256_set1_epi8(zero), ones = _mm256_set1_epi8(one);
+  std::size_t bad = n, i = 0;
+  for (; i + 64 <= n; i += 64) {
+    word bits = 0, valid = 0;
+    for (std::size_t k = 0; k < 64; k += 32) {
+      __m256i v = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(text + i + k));
+      auto is_one = static_cast<word>(static_cast<std::uint32_t>(
+          _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, ones))));
+      auto is_zero = static_cast<word>(static_cast<std::uint32_t>(
+          _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zeros))));
+      bits |= is_one << k;
+      valid |= (is_one | is_zero) << k;
+    }
+    out[i / 64] = bits;
+    if (~valid && bad == n)
+      bad = i + static_cast<std::size_t>(std::countr_zero(~valid));
+  }
+  std::size_t tail = scalar::parse(text + i, n - i, zero, one, out + i / 64);
+  return bad != n ? bad : i + tail;
+}
+
+// as ssse3::format, 32 bits per step; vpshufb stays within 128-bit lanes,
+// so the unit is broadcast to both
+NSTD_TARGET("avx2")
+inline void format(const word* src, std::size_t n, char zero, char one,
+                   char* out) noexcept {
+  const __m256i zeros = _mm256_set1_epi8(zero), ones = _mm256_set1_epi8(one);
+  const __m256i pick =
+      _mm256_setr_epi8(3, 3, 3, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+                       1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i bits = _mm256_set1_epi64x(0x0102040810204080);
+  std::size_t lead = n % 32;
+  scalar::format_range(src, n - lead, n, zero, one, out);
+  out += lead;
+  for (std::size_t k = (n - lead) / 32; k-- > 0; out += 32) {
+    auto unit = static_cast<int>(src[k / 2] >> (32 * (k % 2)));
+    __m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32(unit), pick);
+    __m256i set = _mm256_cmpeq_epi8(_mm256_and_si256(v, bits), bits);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                        _mm256_blendv_epi8(zeros, ones, set));
+  }
+}
+
+template <pair_op Op>
+NSTD_TARGET("avx2") __m256i combine(__m256i a, __m256i b) noexcept {
+  if constexpr (Op == pair_op::bit_and) {
+    return _mm256_and_si256(a, b);
+  } else if constexpr (Op == pair_op::bit_or) {
+    return _mm256_or_si256(a, b);
+  } else {
+    return _mm256_xor_si256(a, b);
+  }
+}
+
+// Fingerprints are a few hundred to a few thousand bits, too short for
+// Harley-Seal to pay off, so each vector goes straight through the nibble
+// lookup and the lanes are summed once per fingerprint.
+template <pair_op Op>
+NSTD_TARGET("avx2,popcnt")
+void count_many(const word* q, const word* base, std::size_t words,
+                std::size_t n, std::size_t* out) noexcept {
+  for (std::size_t j = 0; j < n; j++, base += words) {
+    __m256i acc = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+      acc = _mm256_add_epi64(
+          acc, popcount_lanes(combine<Op>(load(q + i), load(base + i))));
+    }
+    __m128i half = _mm_add_epi64(_mm256_castsi256_si128(acc),
+                                 _mm256_extracti128_si256(acc, 1));
+    auto sum = static_cast<std::size_t>(_mm_cvtsi128_si64(half) +
+                                        _mm_extract_epi64(half, 1));
+    for (; i < words; i++) {
+      sum += static_cast<std::size_t>(
+          __builtin_popcountll(scalar::combine<Op>(q[i], base[i])));
+    }
+    out[j] = sum;
+  }
+}
+
+// all eight lane bits of a split-block probe at once: vpmulld, a shift
+// right by 27 and a variable shift of 1
+NSTD_TARGET("avx2") inline __m256i sbbf_mask(word h) noexcept {
+  const __m256i salt = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(sbbf_salt));
+  __m256i key = _mm256_set1_epi32(static_cast<int>(h));
+  __m256i shift = _mm256_srli_epi32(_mm256_mullo_epi32(key, salt), 27);
+  return _mm256_sllv_epi32(_mm256_set1_epi32(1), shift);
+}
+
+NSTD_TARGET("avx2")
+inline void sbbf_insert(word* blocks, std::size_t num_blocks,
+                        const word* hashes, std::size_t n) noexcept {
+  for (std::size_t j = 0; j < n; j++) {
+    if (j + sbbf_prefetch < n)
+      _mm_prefetch(reinterpret_cast<const char*>(
+                       blocks + sbbf_block_words *
+                                    scalar::sbbf_block(
+                                        hashes[j + sbbf_prefetch], num_blocks)),
+                   _MM_HINT_T0);
+    word* b =
+        blocks + sbbf_block_words * scalar::sbbf_block(hashes[j], num_blocks);
+    store(b, _mm256_or_si256(load(b), sbbf_mask(hashes[j])));
+  }
+}
+
+NSTD_TARGET("avx2")
+inline void sbbf_contains(const word* blocks, std::size_t num_blocks,
+                          const word* hashes, std::size_t n,
+                          bool* out) noexcept {
+  for (std::size_t j = 0; j < n; j++) {
+    if (j + sbbf_prefetch < n)
+      _mm_prefetch(reinterpret_cast<const char*>(
+                       blocks + sbbf_block_words *
+                                    scalar::sbbf_block(
+                                        hashes[j + sbbf_prefetch], num_blocks)),
+                   _MM_HINT_T0);
+    const word* b =
+        blocks + sbbf_block_words * scalar::sbbf_block(hashes[j], num_blocks);
+    // testc is 1 when every bit of the mask is set in the block
+    out[j] = _mm256_testc_si256(load(b), sbbf_mask(hashes[j]));
+  }
+}
+
+// a * hash_prime per 64-bit lane, from two 32x32->64 multiplies
+NSTD_TARGET("avx2") inline __m256i mul_prime(__m256i a) noexcept {
+  const __m256i prime = _mm256_set1_epi64x(hash_prime);
+  __m256i lo = _mm256_mul_epu32(a, prime);
+  __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+  return _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+}
+
+NSTD_TARGET("avx2")
+inline void hash_stripes(word* acc, const word* src,
+                         std::size_t stripes) noexcept {
+  __m256i acc_v[2] = {load(acc), load(acc + 4)};
+  for (std::size_t s = 0; s < stripes; s++) {
+    for (std::size_t h = 0; h < 2; h++) {
+      __m256i w = load(src + s * hash_lanes + 4 * h);
+      __m256i k = _mm256_xor_si256(w, load(hash_secret + 4 * h));
+      __m256i prod = _mm256_mul_epu32(k, _mm256_srli_epi64(k, 32));
+      // w goes to the other lane of its pair
+      __m256i swapped = _mm256_shuffle_epi32(w, _MM_SHUFFLE(1, 0, 3, 2));
+      acc_v[h] = _mm256_add_epi64(acc_v[h], _mm256_add_epi64(prod, swapped));
+    }
+    if ((s + 1) % hash_scramble == 0) {
+      for (std::size_t h = 0; h < 2; h++) {
+        __m256i a = _mm256_xor_si256(acc_v[h], _mm256_srli_epi64(acc_v[h], 47));
+        a = _mm256_xor_si256(a, load(hash_scramble_key + 4 * h));
+        acc_v[h] = mul_prime(a);
+      }
+    }
+  }
+  store(acc, acc_v[0]);
+  store(acc + 4, acc_v[1]);
+}
+
+} // namespace avx2
+
+namespace avx512 {
+
+// eight words per __m512i; tails use masked loads and stores
+NSTD_TARGET("avx512f") inline __mmask8 tail_mask(std::size_t n) noexcept {
+  return static_cast<__mmask8>((1u << n) - 1);
+}
+
+NSTD_TARGET("avx512f")
+inline void bit_and(word* dst, const word* src, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_si512(dst + i, _mm512_and_si512(_mm512_loadu_si512(dst + i),
+                                                  _mm512_loadu_si512(src + i)));
+  }
+  if (i < n) {
+    __mmask8 m = tail_mask(n - i);
+    _mm512_mask_storeu_epi64(
+        dst + i, m,
+        _mm512_and_si512(_mm512_maskz_loadu_epi64(m, dst + i),
+                         _mm512_maskz_loadu_epi64(m, src + i)));
+  }
+}
+
+NSTD_TARGET("avx512f")
+inline void bit_or(word* dst, const word* src, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_si512(dst + i, _mm512_or_si512(_mm512_loadu_si512(dst + i),
+                                                 _mm512_loadu_si512(src + i)));
+  }
+  if (i < n) {
+    __mmask8 m = tail_mask(n - i);
+    _mm512_mask_storeu_epi64(
+        dst + i, m,
+        _mm512_or_si512(_mm512_maskz_loadu_epi64(m, dst + i),
+                        _mm512_maskz_loadu_epi64(m, src + i)));
+  }
+}
+
+NSTD_TARGET("avx512f")
+inline void bit_xor(word* dst, const word* src, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_si512(dst + i, _mm512_xor_si512(_mm512_loadu_si512(dst + i),
+                                                  _mm512_loadu_si512(src + i)));
+  }
+  if (i < n) {
+    __mmask8 m = tail_mask(n - i);
+    _mm512_mask_storeu_epi64(
+        dst + i, m,
+        _mm512_xor_si512(_mm512_maskz_loadu_epi64(m, dst + i),
+                         _mm512_maskz_loadu_epi64(m, src + i)));
+  }
+}
+
+NSTD_TARGET("avx512f")
+inline void bit_not(word* dst, std::size_t n) noexcept {
+  const __m512i ones = _mm512_set1_epi64(-1);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_si512(dst + i,
+                        _mm512_xor_si512(_mm512_loadu_si512(dst + i), ones));
+  }
+  if (i < n) {
+    __mmask8 m = tail_mask(n - i);
+    _mm512_mask_storeu_epi64(
+        dst + i, m, _mm512_xor_si512(_mm512_maskz_loadu_epi64(m, dst + i), ones));
+  }
+}
+
+// needs AVX512_VPOPCNTDQ; CPUs with only AVX512F count with avx2::count
+// sum of the eight lanes
+NSTD_TARGET("avx512f") inline std::size_t lane_sum(__m512i v) noexcept {
+  alignas(64) word lanes[8];
+  _mm512_store_si512(lanes, v);
+  std::size_t sum = 0;
+  for (word lane : lanes) {
+    sum += static_cast<std::size_t>(lane);
+  }
+  return sum;
+}
+
+NSTD_TARGET("avx512f,avx512vpopcntdq")
+inline std::size_t count(const word* src, std::size_t n) noexcept {
+  __m512i total = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    total = _mm512_add_epi64(total,
+                             _mm512_popcnt_epi64(_mm512_loadu_si512(src + i)));
+  }
+  if (i < n) {
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(
+                                        tail_mask(n - i), src + i)));
+  }
+  return lane_sum(total);
+}
+
+NSTD_TARGET("avx512f")
+inline bool any(const word* src, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i acc = _mm512_or_si512(_mm512_loadu_si512(src + i),
+                                  _mm512_loadu_si512(src + i + 8));
+    if (_mm512_test_epi64_mask(acc, acc))
+      return true;
+  }
+  if (i + 8 <= n) {
+    __m512i v = _mm512_loadu_si512(src + i);
+    if (_mm512_test_epi64_mask(v, v))
+      return true;
+    i += 8;
+  }
+  if (i < n) {
+    __m512i v = _mm512_maskz_loadu_epi64(tail_mask(n - i), src + i);
+    return _mm512_test_epi64_mask(v, v) != 0;
+  }
+  return false;
+}
+
+NSTD_TARGET("avx512f")
+inline bool all(const word* src, std::size_t n) noexcept {
+  const __m512i ones = _mm512_set1_epi64(-1);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i acc = _mm512_and_si512(_mm512_loadu_si512(src + i),
+                                   _mm512_loadu_si512(src + i + 8));
+    if (_mm512_cmpneq_epi64_mask(acc, ones))
+      return false;
+  }
+  if (i + 8 <= n) {
+    if (_mm512_cmpneq_epi64_mask(_mm512_loadu_si512(src + i), ones))
+      return false;
+    i += 8;
+  }
+  if (i < n) {
+    // lanes past the end are filled with ones so they always compare equal
+    __m512i v = _mm512_mask_loadu_epi64(ones, tail_mask(n - i), src + i);
+    return _mm512_cmpneq_epi64_mask(v, ones) == 0;
+  }
+  return true;
+}
+
+NSTD_TARGET("avx512f")
+inline bool equal(const word* lhs, const word* rhs, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    if (_mm512_cmpneq_epi64_mask(_mm512_loadu_si512(lhs + i),
+                                 _mm512_loadu_si512(rhs + i)))
+      return false;
+  }
+  if (i < n) {
+    __mmask8 m = tail_mask(n - i);
+    return _mm512_mask_cmpneq_epi64_mask(m, _mm512_maskz_loadu_epi64(m, lhs + i),
+                                         _mm512_maskz_loadu_epi64(m, rhs + i)) ==
+           0;
+  }
+  return true;
+}
+
+// needs AVX512BW; byte compares yield the 64-bit mask directly
+NSTD_TARGET("avx512f,avx512bw")
+inline std::size_t parse(const char* text, std::size_t n, char zero, char one,
+                         word* out) noexcept {
+  const __m512i zeros = _mm512_set1_epi8(zero), ones = _mm512_set1_epi8(one);
+  std::size_t bad = n, i = 0;
+  for (; i + 64 <= n; i += 64) {
+    __m512i v = _mm512_loadu_si512(text + i);
+    word is_one = _mm512_cmpeq_epi8_mask(v, ones);
+    word valid = is_one | _mm512_cmpeq_epi8_mask(v, zeros);
+    out[i / 64] = is_one;
+    if (~valid && bad == n)
+      bad = i + static_cast<std::size_t>(std::countr_zero(~valid));
+  }
+  std::size_t tail = scalar::parse(text + i, n - i, zero, one, out + i / 64);
+  return bad != n ? bad : i + tail;
+}
+
+template <pair_op Op>
+NSTD_TARGET("avx512f") __m512i combine(__m512i a, __m512i b) noexcept {
+  if constexpr (Op == pair_op::bit_and) {
+    return _mm512_and_si512(a, b);
+  } else if constexpr (Op == pair_op::bit_or) {
+    return _mm512_or_si512(a, b);
+  } else {
+    return _mm512_xor_si512(a, b);
+  }
+}
+
+// needs VPOPCNTDQ; the tail of each fingerprint is a masked load, so a
+// 256-bit fingerprint is a single half-width step
+template <pair_op Op>
+NSTD_TARGET("avx512f,avx512vpopcntdq")
+void count_many(const word* q, const word* base, std::size_t words,
+                std::size_t n, std::size_t* out) noexcept {
+  const std::size_t whole = words - words % 8;
+  const __mmask8 tail = tail_mask(words % 8);
+  for (std::size_t j = 0; j < n; j++, base += words) {
+    __m512i acc = _mm512_setzero_si512();
+    for (std::size_t i = 0; i < whole; i += 8) {
+      acc = _mm512_add_epi64(
+          acc, _mm512_popcnt_epi64(combine<Op>(_mm512_loadu_si512(q + i),
+                                               _mm512_loadu_si512(base + i))));
+    }
+    if (tail) {
+      acc = _mm512_add_epi64(
+          acc, _mm512_popcnt_epi64(
+                   combine<Op>(_mm512_maskz_loadu_epi64(tail, q + whole),
+                               _mm512_maskz_loadu_epi64(tail, base + whole))));
+    }
+    out[j] = lane_sum(acc);
+  }
+}
+
+} // namespace avx512
+
+#undef NSTD_TARGET
+
+#endif // NSTD_SIMD_X86
+
+// highest level the running CPU and this build both support
+inline isa detected_isa() noexcept {
+#if NSTD_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return isa::avx512;
+  if (__builtin_cpu_supports("avx2"))
+    return isa::avx2;
+  if (__builtin_cpu_supports("sse2"))
+    return isa::sse2;
+#endif
+  return isa::scalar;
+}
+
+// table for a given level; the caller must make sure the CPU supports it
+inline kernels kernels_for(isa level) noexcept {
+  kernels k{isa::scalar,   scalar::bit_and, scalar::bit_or,
+            scalar::bit_xor, scalar::bit_not, scalar::count,
+            scalar::any,     scalar::all,     scalar::equal,
+            scalar::parse,   scalar::format,  scalar::pext,
+            scalar::pdep,
+            scalar::count_many<pair_op::bit_and>,
+            scalar::count_many<pair_op::bit_or>,
+            scalar::count_many<pair_op::bit_xor>,
+            scalar::sbbf_insert,
+            scalar::sbbf_contains,
+            scalar::hash_stripes};
+#if NSTD_SIMD_X86
+  __builtin_cpu_init();
+  bool has_popcnt = __builtin_cpu_supports("popcnt");
+  bool has_ssse3 = __builtin_cpu_supports("ssse3");
+  switch (level) {
+  case isa::avx512:
+    k = {isa::avx512,    avx512::bit_and, avx512::bit_or,
+         avx512::bit_xor, avx512::bit_not, avx2::count,
+         avx512::any,     avx512::all,     avx512::equal,
+         avx2::parse,     avx2::format,    scalar::pext,
+         scalar::pdep,
+         avx2::count_many<pair_op::bit_and>,
+         avx2::count_many<pair_op::bit_or>,
+         avx2::count_many<pair_op::bit_xor>,
+         avx2::sbbf_insert,
+         avx2::sbbf_contains,
+         avx2::hash_stripes};
+    if (__builtin_cpu_supports("avx512vpopcntdq")) {
+      k.count = avx512::count;
+      k.count_and_many = avx512::count_many<pair_op::bit_and>;
+      k.count_or_many = avx512::count_many<pair_op::bit_or>;
+      k.count_xor_many = avx512::count_many<pair_op::bit_xor>;
+    }
+    if (__builtin_cpu_supports("avx512bw"))
+      k.parse = avx512::parse;
+    break;
+  case isa::avx2:
+    k = {isa::avx2,     avx2::bit_and, avx2::bit_or,
+         avx2::bit_xor, avx2::bit_not, avx2::count,
+         avx2::any,     avx2::all,     avx2::equal,
+         avx2::parse,   avx2::format,  scalar::pext,
+         scalar::pdep,
+         avx2::count_many<pair_op::bit_and>,
+         avx2::count_many<pair_op::bit_or>,
+         avx2::count_many<pair_op::bit_xor>,
+         avx2::sbbf_insert,
+         avx2::sbbf_contains,
+         avx2::hash_stripes};
+    break;
+  case isa::sse2:
+    k = {isa::sse2,     sse2::bit_and, sse2::bit_or,
+         sse2::bit_xor, sse2::bit_not, scalar::count,
+         sse2::any,     sse2::all,     sse2::equal,
+         sse2::parse,   has_ssse3 ? ssse3::format : scalar::format,
+         scalar::pext,  scalar::pdep,
+         scalar::count_many<pair_op::bit_and>,
+         scalar::count_many<pair_op::bit_or>,
+         scalar::count_many<pair_op::bit_xor>,
+         scalar::sbbf_insert,
+         scalar::sbbf_contains,
+         scalar::hash_stripes};
+    break;
+  case isa::scalar:
+    break;
+  }
+  // below AVX2 the hardware popcount beats the SSE alternatives
+  if (has_popcnt && level < isa::avx2) {
+    k.count = popcnt::count;
+    k.count_and_many = popcnt::count_many<pair_op::bit_and>;
+    k.count_or_many = popcnt::count_many<pair_op::bit_or>;
+    k.count_xor_many = popcnt::count_many<pair_op::bit_xor>;
+  }
+  // BMI2 is a separate feature bit, not implied by any of the levels
+  if (__builtin_cpu_supports("bmi2")) {
+    k.pext = bmi2::pext;
+    k.pdep = bmi2::pdep;
+  }
+#else
+  (void)level;
+#endif
+  return k;
+}
+
+// the table every bulk bitset operation dispatches through
+inline const kernels& active() noexcept {
+  static const kernels k = kernels_for(detected_isa());
+  return k;
+}
+
+} // namespace nstd::detail::simd
@@ -875,9 +875,17 @@ struct is_trivially_copy_assignable
 template <class T>
 struct is_trivially_move_assignable
     : public bool_constant<is_trivially_assignable_v<T&, T&&>> {};
+// gcc has no __is_trivially_destructible; libstdc++ composes it the same way
+#if __has_builtin(__is_trivially_destructible)
 template <class T>
 struct is_trivially_destructible
     : public bool_constant<__is_trivially_destructible(T)> {};
+#else
+template <class T>
+struct is_trivially_destructible
+    : public bool_constant<is_destructible_v<T> &&
+                           __has_trivial_destructor(T)> {};
+#endif
 
 // nothrow
 //
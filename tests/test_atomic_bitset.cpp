@@ -0,0 +1,102 @@
+#include "../include/atomic_bitset.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST(AtomicBitsetTest, SingleBitOps) {
+  nstd::atomic_bitset<100> b;
+  EXPECT_TRUE(b.none());
+  EXPECT_FALSE(b.test_and_set(70));
+  EXPECT_TRUE(b.test_and_set(70));
+  EXPECT_TRUE(b.test(70));
+  EXPECT_TRUE(b.fetch_reset(70));
+  EXPECT_FALSE(b.fetch_reset(70));
+  EXPECT_FALSE(b.fetch_flip(3));
+  EXPECT_TRUE(b.test(3));
+  EXPECT_EQ(b.count(), 1u);
+  EXPECT_EQ(b.find_first(), 3u);
+  EXPECT_THROW(b.test_and_set(100), std::out_of_range);
+  EXPECT_THROW(b.test(100), std::out_of_range);
+}
+
+TEST(AtomicBitsetTest, SnapshotRoundTrip) {
+  nstd::bitset<130> init;
+  init.set(0).set(64).set(129);
+  nstd::atomic_bitset<130> b(init);
+  EXPECT_TRUE(b.snapshot() == init);
+  b.reset();
+  EXPECT_TRUE(b.none());
+  EXPECT_EQ(b.find_first(), b.npos);
+}
+
+TEST(AtomicBitsetTest, ClaimStaysInRange) {
+  nstd::atomic_bitset<70> b;
+  for (std::size_t i = 0; i < 70; i++)
+    EXPECT_EQ(b.claim_first_zero(0), i);
+  EXPECT_TRUE(b.all());
+  EXPECT_EQ(b.claim_first_zero(), b.npos);
+  b.fetch_reset(5);
+  EXPECT_EQ(b.claim_first_zero(69), 5u);
+}
+
+TEST(AtomicBitsetTest, UnhintedClaimsStartOnTheirOwnLines) {
+  // 64 lines of 512 bits, so consecutive threads get distinct lines
+  constexpr std::size_t line_bits = 512;
+  nstd::atomic_bitset<64 * line_bits> b;
+  std::vector<std::size_t> got(4);
+  std::vector<std::thread> pool;
+  for (std::size_t t = 0; t < got.size(); t++)
+    pool.emplace_back([&, t] { got[t] = b.claim_first_zero(); });
+  for (auto& th : pool)
+    th.join();
+
+  std::set<std::size_t> lines;
+  for (std::size_t slot : got) {
+    EXPECT_EQ(slot % line_bits, 0u);
+    lines.insert(slot / line_bits);
+  }
+  EXPECT_EQ(lines.size(), got.size());
+
+  // a small map has one line, where the lowest clear bit comes first
+  nstd::atomic_bitset<70> small;
+  EXPECT_EQ(small.claim_first_zero(), 0u);
+  EXPECT_EQ(small.claim_first_zero(), 1u);
+}
+
+TEST(AtomicBitsetTest, ConcurrentClaimsAreUnique) {
+  constexpr std::size_t slots = 1 << 14;
+  constexpr std::size_t threads = 8;
+  nstd::atomic_bitset<slots> b;
+  std::vector<std::vector<std::size_t>> got(threads);
+  std::vector<std::thread> pool;
+  for (std::size_t t = 0; t < threads; t++) {
+    pool.emplace_back([&, t] {
+      // release every other claim so blocks are fought over repeatedly
+      for (std::size_t k = 0;; k++) {
+        std::size_t slot = b.claim_first_zero(t * slots / threads);
+        if (slot == b.npos)
+          break;
+        if (k % 2 && b.fetch_reset(slot))
+          continue;
+        got[t].push_back(slot);
+      }
+    });
+  }
+  for (auto& th : pool)
+    th.join();
+
+  std::vector<std::size_t> all;
+  for (auto& v : got)
+    all.insert(all.end(), v.begin(), v.end());
+  std::sort(all.begin(), all.end());
+  ASSERT_EQ(all.size(), slots);
+  for (std::size_t i = 0; i < slots; i++)
+    ASSERT_EQ(all[i], i);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+#include "../include/bit_matrix.hpp"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <memory>
+#include <random>
+
+template <std::size_t R, std::size_t C>
+static std::unique_ptr<nstd::bit_matrix<R, C>> random_matrix(unsigned seed,
+                                                             int density) {
+  auto m = std::make_unique<nstd::bit_matrix<R, C>>();
+  std::mt19937_64 gen(seed);
+  for (std::size_t i = 0; i < R; i++) {
+    for (std::size_t j = 0; j < C; j++)
+      m->set(i, j, static_cast<int>(gen() % 100) < density);
+  }
+  return m;
+}
+
+TEST(BitMatrixTest, Transpose64) {
+  std::uint64_t m[64], orig[64];
+  std::mt19937_64 gen(1);
+  for (auto& w : orig)
+    w = gen();
+  std::copy(orig, orig + 64, m);
+  nstd::detail::transpose64(m);
+  for (std::size_t r = 0; r < 64; r++) {
+    for (std::size_t c = 0; c < 64; c++)
+      ASSERT_EQ((m[c] >> r) & 1, (orig[r] >> c) & 1) << r << ' ' << c;
+  }
+}
+
+template <std::size_t R, std::size_t C> static void check_transpose() {
+  auto m = random_matrix<R, C>(R * C, 30);
+  auto t = std::make_unique<nstd::bit_matrix<C, R>>(m->transpose());
+  for (std::size_t i = 0; i < R; i++) {
+    for (std::size_t j = 0; j < C; j++)
+      ASSERT_EQ((*t)(j, i), (*m)(i, j)) << i << ' ' << j;
+  }
+  EXPECT_EQ(t->count(), m->count());
+  EXPECT_TRUE(t->transpose() == *m);
+  // columns of m are rows of its transpose
+  for (std::size_t j = 0; j < C; j += 7)
+    EXPECT_EQ(m->column(j), (*t)[j]);
+}
+
+TEST(BitMatrixTest, Transpose) {
+  check_transpose<64, 64>();
+  check_transpose<1, 1>();
+  check_transpose<3, 200>();
+  check_transpose<130, 70>();
+  check_transpose<256, 192>();
+}
+
+TEST(BitMatrixTest, ElementwiseOps) {
+  auto a = random_matrix<100, 150>(1, 50);
+  auto b = random_matrix<100, 150>(2, 50);
+  auto both = *a & *b, either = *a | *b, diff = *a ^ *b;
+  for (std::size_t i = 0; i < 100; i++) {
+    EXPECT_EQ(both[i], (*a)[i] & (*b)[i]);
+    EXPECT_EQ(either[i], (*a)[i] | (*b)[i]);
+    EXPECT_EQ(diff[i], (*a)[i] ^ (*b)[i]);
+  }
+  EXPECT_EQ(both.count() + either.count(), a->count() + b->count());
+  diff ^= diff;
+  EXPECT_TRUE(diff.none());
+  a->reset();
+  EXPECT_FALSE(a->any());
+}
+
+template <std::size_t M, std::size_t K, std::size_t N>
+static void check_product(int density) {
+  auto a = random_matrix<M, K>(M + K, density);
+  auto b = random_matrix<K, N>(K + N, density);
+  auto c = std::make_unique<nstd::bit_matrix<M, N>>(*a * *b);
+  auto bt = std::make_unique<nstd::bit_matrix<N, K>>(b->transpose());
+  for (std::size_t i = 0; i < M; i++) {
+    for (std::size_t j = 0; j < N; j++)
+      ASSERT_EQ((*c)(i, j), intersects((*a)[i], (*bt)[j])) << i << ' ' << j;
+  }
+}
+
+TEST(BitMatrixTest, Multiply) {
+  // row ORs
+  check_product<10, 70, 30>(5);
+  check_product<256, 128, 64>(1);
+  // Four Russians, with a partial last group of rows of b
+  check_product<300, 77, 90>(90);
+  check_product<300, 300, 70>(50);
+}
+
+TEST(BitMatrixTest, OutOfRange) {
+  nstd::bit_matrix<4, 5> m;
+  EXPECT_THROW(m.set(4, 0), std::out_of_range);
+  EXPECT_THROW(m.test(0, 5), std::out_of_range);
+  EXPECT_THROW(m.column(5), std::out_of_range);
+  m.set(3, 4);
+  EXPECT_TRUE(m.test(3, 4));
+  m.reset(3, 4);
+  EXPECT_TRUE(m.none());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
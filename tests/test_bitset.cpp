@@ -1,7 +1,14 @@
 #include "../include/bitset.hpp"
+#include <algorithm>
 #include <bitset>
+#include <cstdint>
 #include <gtest/gtest.h>
+#include <iomanip>
+#include <random>
+#include <sstream>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 TEST(BitsetTest, DefaultConstructor) {
   nstd::bitset<8> b;
@@ -141,6 +148,544 @@ TEST(BitsetTest, ShiftRight) {
   EXPECT_EQ(b.to_ulong(), 0b00010110UL);
 }
 
+TEST(BitsetTest, ShiftOutOfRange) {
+  nstd::bitset<8> b(0b10110000ULL);
+  b <<= 8;
+  EXPECT_TRUE(b.none());
+  b = nstd::bitset<8>(0b10110000ULL);
+  b >>= 100;
+  EXPECT_TRUE(b.none());
+}
+
+TEST(BitsetTest, ShiftAcrossBlocks) {
+  nstd::bitset<130> b(1);
+  b <<= 64;
+  EXPECT_TRUE(b[64]);
+  EXPECT_EQ(b.count(), 1u);
+  b <<= 65;
+  EXPECT_TRUE(b[129]);
+  EXPECT_EQ(b.count(), 1u);
+  b <<= 1;
+  EXPECT_TRUE(b.none());
+}
+
+TEST(BitsetTest, ShiftMatchesStd) {
+  constexpr std::size_t N = 200;
+  std::string s;
+  for (std::size_t i = 0; i < N; i++) {
+    s += (i * 7 + i / 3) % 5 < 2 ? '1' : '0';
+  }
+  for (std::size_t pos : {0, 1, 5, 63, 64, 65, 127, 128, 199, 200, 250}) {
+    nstd::bitset<N> b(s);
+    std::bitset<N> expected;
+    for (std::size_t i = 0; i < N; i++) {
+      expected[i] = b[i];
+    }
+
+    auto l = b << pos;
+    auto r = b >> pos;
+    for (std::size_t i = 0; i < N; i++) {
+      ASSERT_EQ(l[i], (expected << pos)[i]) << "pos=" << pos << " i=" << i;
+      ASSERT_EQ(r[i], (expected >> pos)[i]) << "pos=" << pos << " i=" << i;
+    }
+    EXPECT_EQ(l.count(), (expected << pos).count());
+    EXPECT_EQ(r.count(), (expected >> pos).count());
+  }
+}
+
+TEST(BitsetTest, TrailingBitsStayClear) {
+  nstd::bitset<70> b;
+  b.set();
+  EXPECT_EQ(b.count(), 70u);
+  EXPECT_TRUE(b.all());
+  b <<= 3;
+  EXPECT_EQ(b.count(), 67u);
+  EXPECT_FALSE(b.all());
+  b.flip();
+  EXPECT_EQ(b.count(), 3u);
+  EXPECT_EQ((~b).count(), 67u);
+}
+
+TEST(BitsetTest, FindFirstNextLast) {
+  nstd::bitset<200> b;
+  EXPECT_EQ(b.find_first(), b.npos);
+  EXPECT_EQ(b.find_last(), b.npos);
+  b.set(3);
+  b.set(64);
+  b.set(199);
+  EXPECT_EQ(b.find_first(), 3u);
+  EXPECT_EQ(b.find_next(3), 64u);
+  EXPECT_EQ(b.find_next(64), 199u);
+  EXPECT_EQ(b.find_next(199), b.npos);
+  EXPECT_EQ(b.find_next(b.npos), b.npos);
+  EXPECT_EQ(b.find_last(), 199u);
+}
+
+TEST(BitsetTest, SetBitsView) {
+  static_assert(std::ranges::forward_range<
+                decltype(std::declval<nstd::bitset<8>>().set_bits())>);
+  nstd::bitset<300> b;
+  std::vector<std::size_t> expected;
+  for (std::size_t i = 0; i < b.size(); i += 7) {
+    b.set(i);
+    expected.push_back(i);
+  }
+  std::vector<std::size_t> got;
+  for (std::size_t i : b.set_bits()) {
+    got.push_back(i);
+  }
+  EXPECT_EQ(got, expected);
+  EXPECT_EQ(std::ranges::distance(b.set_bits()), b.count());
+  EXPECT_TRUE(nstd::bitset<300>().set_bits().empty());
+
+  std::vector<std::size_t> by_find;
+  for (auto i = b.find_first(); i != b.npos; i = b.find_next(i)) {
+    by_find.push_back(i);
+  }
+  EXPECT_EQ(by_find, expected);
+}
+
+// fills an nstd and a std bitset with the same pseudo-random bits
+template <std::size_t N, class Block>
+void fill_both(nstd::bitset<N, Block>& b, std::bitset<N>& ref,
+               std::size_t seed) {
+  for (std::size_t i = 0; i < N; i++) {
+    bool bit = (i * 2654435761u + seed * 40503u) % 7 < 3;
+    b.set(i, bit);
+    ref[i] = bit;
+  }
+}
+
+template <std::size_t N, class Block>
+void expect_same(const nstd::bitset<N, Block>& b, const std::bitset<N>& ref) {
+  for (std::size_t i = 0; i < N; i++) {
+    ASSERT_EQ(b[i], ref[i]) << i;
+  }
+  EXPECT_EQ(b.count(), ref.count());
+}
+
+TEST(BitsetTest, ExpressionsAreLazy) {
+  nstd::bitset<8> a, b;
+  static_assert(!std::is_same_v<decltype(a & b), nstd::bitset<8>>);
+  static_assert(!std::is_same_v<decltype((a & b) | ~a), nstd::bitset<8>>);
+  static_assert(std::is_same_v<decltype(nstd::bitset<8>(a & b)),
+                               nstd::bitset<8>>);
+
+  // the size of a 16 Mbit expression comes from its type
+  using big = nstd::bitset<std::size_t{1} << 24>;
+  static_assert(nstd::detail::bitset_size_v<big> == std::size_t{1} << 24);
+}
+
+TEST(BitsetTest, ExpressionsMatchStd) {
+  // 20000 bits is more than one evaluation tile and ends mid-block
+  constexpr std::size_t N = 20000;
+  nstd::bitset<N> a, b, c;
+  std::bitset<N> ra, rb, rc;
+  fill_both(a, ra, 1);
+  fill_both(b, rb, 2);
+  fill_both(c, rc, 3);
+
+  nstd::bitset<N> r = (a & b) | ~c;
+  expect_same(r, (ra & rb) | ~rc);
+  r = a ^ (b & ~(c | a));
+  expect_same(r, ra ^ (rb & ~(rc | ra)));
+  r = ~(a & b) & ~(b ^ c);
+  expect_same(r, ~(ra & rb) & ~(rb ^ rc));
+
+  r = a;
+  r |= b & c;
+  expect_same(r, ra | (rb & rc));
+  r &= ~a;
+  expect_same(r, (ra | (rb & rc)) & ~ra);
+  r ^= a | c;
+  expect_same(r, ((ra | (rb & rc)) & ~ra) ^ (ra | rc));
+}
+
+TEST(BitsetTest, ExpressionAliasing) {
+  constexpr std::size_t N = 1000;
+  nstd::bitset<N> a, b;
+  std::bitset<N> ra, rb;
+  fill_both(a, ra, 4);
+  fill_both(b, rb, 5);
+  b = a & ~b;
+  expect_same(b, ra & ~rb);
+  a ^= a & b;
+  expect_same(a, ra ^ (ra & (ra & ~rb)));
+}
+
+TEST(BitsetTest, ExpressionTemporaries) {
+  nstd::bitset<70> a(0b1100);
+  // the temporaries are moved into the expression, so e does not dangle
+  auto e = nstd::bitset<70>(0b1010) & ~nstd::bitset<70>(0b0110);
+  EXPECT_EQ(e.to_ulong(), 0b1000UL);
+  EXPECT_EQ((e | a).to_ulong(), 0b1100UL);
+  EXPECT_TRUE(e[3]);
+  EXPECT_FALSE(e.test(69));
+  EXPECT_THROW(e.test(70), std::out_of_range);
+  EXPECT_EQ((~a).to_string().substr(66), "0011");
+}
+
+TEST(BitsetTest, ExpressionReductions) {
+  constexpr std::size_t N = 20000;
+  nstd::bitset<N> a, b, c;
+  std::bitset<N> ra, rb, rc;
+  fill_both(a, ra, 6);
+  fill_both(b, rb, 7);
+
+  EXPECT_EQ(nstd::count(a & ~b), (ra & ~rb).count());
+  EXPECT_EQ(nstd::count(~c), N);
+  EXPECT_TRUE(nstd::any(a & b));
+  EXPECT_TRUE(nstd::intersects(a, b));
+  EXPECT_FALSE(nstd::intersects(a, ~a));
+  EXPECT_TRUE(nstd::none(a & ~a));
+  EXPECT_TRUE(nstd::all(a | ~a));
+  EXPECT_FALSE(nstd::all(a | b));
+  c.set(N - 1);
+  EXPECT_TRUE(nstd::intersects(c, ~a | a));
+  EXPECT_TRUE((c & b) == (b & c));
+}
+
+TEST(BitsetTest, SmallBitsetsUseSmallBlocks) {
+  static_assert(sizeof(nstd::bitset<4>) == 1);
+  static_assert(sizeof(nstd::bitset<8>) == 1);
+  static_assert(sizeof(nstd::bitset<16>) == 2);
+  static_assert(sizeof(nstd::bitset<17>) == 4);
+  static_assert(sizeof(nstd::bitset<33>) == sizeof(std::size_t));
+  static_assert(sizeof(nstd::bitset<65>) == 2 * sizeof(std::size_t));
+  static_assert(sizeof(nstd::bitset<64, std::uint8_t>) == 8);
+
+  nstd::bitset<4> b(0xffULL);
+  EXPECT_EQ(b.to_ulong(), 0xfUL);
+  EXPECT_TRUE(b.all());
+  b <<= 2;
+  EXPECT_EQ(b.to_ulong(), 0xcUL);
+  EXPECT_EQ((~b).to_ulong(), 0x3UL);
+}
+
+// runs the whole API over N = 200 bits stored in Block and checks it
+// against std::bitset
+template <class Block> void check_block() {
+  constexpr std::size_t N = 200;
+  using bs = nstd::bitset<N, Block>;
+  static_assert(std::is_same_v<typename bs::block_type, Block>);
+
+  bs v(0x8123456789abcdefULL);
+  std::bitset<N> rv(0x8123456789abcdefULL);
+  expect_same(v, rv);
+  EXPECT_EQ(v.to_ulong(), 0x8123456789abcdefUL);
+  v.set(64);
+  EXPECT_THROW(v.to_ulong(), std::overflow_error);
+  v.reset(64);
+  v.set(199);
+  EXPECT_THROW(v.to_ulong(), std::overflow_error);
+
+  bs a, b;
+  std::bitset<N> ra, rb;
+  fill_both(a, ra, 8);
+  fill_both(b, rb, 9);
+  for (std::size_t pos : {0, 1, 7, 8, 63, 64, 127, 128, 199, 200}) {
+    expect_same(bs(a << pos), ra << pos);
+    expect_same(bs(a >> pos), ra >> pos);
+  }
+  expect_same(bs((a & ~b) | (a ^ b)), (ra & ~rb) | (ra ^ rb));
+  EXPECT_EQ(nstd::count(a & b), (ra & rb).count());
+
+  bs c;
+  c.set();
+  EXPECT_TRUE(c.all());
+  EXPECT_EQ(c.count(), N);
+  c.flip();
+  EXPECT_TRUE(c.none());
+  c[150] = true;
+  typename bs::reference ref = c[150];
+  EXPECT_TRUE(static_cast<bool>(ref));
+  ref.flip();
+  EXPECT_FALSE(c.any());
+
+  c.set(5).set(100).set(199);
+  EXPECT_EQ(c.find_first(), 5u);
+  EXPECT_EQ(c.find_next(5), 100u);
+  EXPECT_EQ(c.find_last(), 199u);
+  std::vector<std::size_t> got;
+  for (auto i : c.set_bits())
+    got.push_back(i);
+  EXPECT_EQ(got, (std::vector<std::size_t>{5, 100, 199}));
+
+  std::string text = a.to_string();
+  EXPECT_EQ(text, ra.to_string());
+  std::ostringstream os;
+  os << a;
+  EXPECT_EQ(os.str(), text);
+  std::istringstream is(text);
+  bs parsed;
+  is >> parsed;
+  EXPECT_TRUE(parsed == bs(text));
+}
+
+TEST(BitsetTest, ExplicitBlockTypes) {
+  check_block<std::uint8_t>();
+  check_block<std::uint16_t>();
+  check_block<std::uint32_t>();
+  check_block<std::uint64_t>();
+#ifdef __SIZEOF_INT128__
+  __extension__ typedef unsigned __int128 u128;
+  static_assert(sizeof(nstd::bitset<256, u128>) == 32);
+  check_block<u128>();
+#endif
+}
+
+TEST(BitsetTest, StringConstructorOffset) {
+  // characters from pos on map to bits 0, 1, ...
+  nstd::bitset<8> b(std::string("xx1101"), 2);
+  EXPECT_EQ(b.to_ulong(), 0b1011u);
+  nstd::bitset<8> c(std::string("ab0110ba"), 2, 4);
+  EXPECT_EQ(c.to_ulong(), 0b0110u);
+  nstd::bitset<4> d(std::string("..**.*"), 0, std::string::npos, '.', '*');
+  EXPECT_EQ(d.to_ulong(), 0b1100u);
+  EXPECT_THROW(nstd::bitset<8>(std::string("0102")), std::invalid_argument);
+  EXPECT_THROW(nstd::bitset<8>(std::string("01"), 3), std::out_of_range);
+  // only the first N characters are looked at
+  EXPECT_NO_THROW(nstd::bitset<4>(std::string("0110x")));
+}
+
+TEST(BitsetTest, LargeTextRoundTrip) {
+  std::mt19937 gen(11);
+  nstd::bitset<1000> a;
+  std::bitset<1000> ra;
+  for (std::size_t i = 0; i < a.size(); i++) {
+    if (gen() % 3 == 0) {
+      a.set(i);
+      ra.set(i);
+    }
+  }
+  std::string text = a.to_string();
+  EXPECT_EQ(text, ra.to_string());
+  EXPECT_EQ(a.to_string('.', '#'), ra.to_string('.', '#'));
+
+  // the string constructor reads character i as bit i
+  std::string forward(text.rbegin(), text.rend());
+  EXPECT_TRUE(nstd::bitset<1000>(forward) == a);
+  forward[700] = '2';
+  EXPECT_THROW(nstd::bitset<1000>{forward}, std::invalid_argument);
+
+  std::wstring wide = a.to_string<wchar_t>();
+  EXPECT_EQ(wide, ra.to_string<wchar_t>());
+}
+
+// hands out its input a few characters per underflow
+class trickle_buf : public std::streambuf {
+public:
+  trickle_buf(std::string s, std::size_t step) : text(std::move(s)), step(step) {
+    setg(text.data(), text.data(), text.data());
+  }
+
+protected:
+  int_type underflow() override {
+    char* end = text.data() + text.size();
+    if (gptr() == end)
+      return traits_type::eof();
+    setg(gptr(), gptr(), std::min(gptr() + step, end));
+    return traits_type::to_int_type(*gptr());
+  }
+
+private:
+  std::string text;
+  std::size_t step;
+};
+
+TEST(BitsetTest, StreamExtraction) {
+  {
+    // stops at the first other character and leaves it in the stream
+    std::istringstream is("  1101x0");
+    nstd::bitset<8> b;
+    is >> b;
+    EXPECT_TRUE(is.good());
+    EXPECT_EQ(b.to_ulong(), 0b1011u);
+    EXPECT_EQ(is.peek(), 'x');
+  }
+  {
+    // stops after N characters
+    std::istringstream is("111000111");
+    nstd::bitset<4> b;
+    is >> b;
+    EXPECT_EQ(b.to_ulong(), 0b0111u);
+    EXPECT_EQ(is.get(), '0');
+  }
+  {
+    std::istringstream is("01");
+    nstd::bitset<8> b;
+    is >> b;
+    EXPECT_TRUE(is.eof());
+    EXPECT_FALSE(is.fail());
+    EXPECT_EQ(b.to_ulong(), 0b10u);
+  }
+  {
+    std::istringstream is("x");
+    nstd::bitset<8> b(0xff);
+    is >> b;
+    EXPECT_TRUE(is.fail());
+    EXPECT_EQ(b.to_ulong(), 0xffu);
+  }
+  {
+    std::string text(3000, '0');
+    for (std::size_t i = 0; i < text.size(); i += 7)
+      text[i] = '1';
+    std::string expected = text.substr(0, 2000);
+    trickle_buf buf(text + " tail", 7);
+    std::istream is(&buf);
+    nstd::bitset<2000> b;
+    is >> b;
+    EXPECT_TRUE(b == nstd::bitset<2000>(expected));
+    EXPECT_EQ(is.get(), '0');
+  }
+  {
+    trickle_buf buf("10110 z", 3);
+    std::istream is(&buf);
+    nstd::bitset<100> b;
+    std::string rest;
+    is >> b >> rest;
+    EXPECT_EQ(b.to_ulong(), 0b01101u);
+    EXPECT_EQ(rest, "z");
+  }
+}
+
+TEST(BitsetTest, StreamInsertion) {
+  nstd::bitset<5000> a;
+  for (std::size_t i = 0; i < a.size(); i += 3)
+    a.set(i);
+  std::ostringstream os;
+  os << a << '|';
+  EXPECT_EQ(os.str(), a.to_string() + "|");
+
+  std::ostringstream padded;
+  padded << std::setw(8) << std::left << nstd::bitset<4>(0b0110) << '|';
+  EXPECT_EQ(padded.str(), "0110    |");
+
+  std::wostringstream wide;
+  wide << nstd::bitset<4>(0b0110);
+  EXPECT_EQ(wide.str(), L"0110");
+}
+
+template <class Block> static void check_ranges() {
+  constexpr std::size_t n = 300;
+  using bs = nstd::bitset<n, Block>;
+  std::mt19937 gen(13);
+  for (int trial = 0; trial < 200; trial++) {
+    std::size_t first = gen() % (n + 1), last = gen() % (n + 1);
+    if (first > last)
+      std::swap(first, last);
+    bs a, b, c;
+    std::bitset<n> ra, rb, rc;
+    for (std::size_t i = 0; i < n; i++) {
+      bool bit = gen() & 1;
+      a.set(i, bit);
+      b.set(i, bit);
+      c.set(i, bit);
+      ra[i] = rb[i] = rc[i] = bit;
+    }
+    a.set_range(first, last);
+    b.reset_range(first, last);
+    c.flip_range(first, last);
+    for (std::size_t i = first; i < last; i++) {
+      ra[i] = true;
+      rb[i] = false;
+      rc.flip(i);
+    }
+    ASSERT_EQ(a.to_string(), ra.to_string()) << first << ' ' << last;
+    ASSERT_EQ(b.to_string(), rb.to_string()) << first << ' ' << last;
+    ASSERT_EQ(c.to_string(), rc.to_string()) << first << ' ' << last;
+  }
+}
+
+TEST(BitsetTest, RangeOps) {
+  check_ranges<std::uint8_t>();
+  check_ranges<std::uint32_t>();
+  check_ranges<std::uint64_t>();
+
+  nstd::bitset<100> b;
+  b.set_range(0, 100);
+  EXPECT_TRUE(b.all());
+  b.flip_range(0, 100);
+  EXPECT_TRUE(b.none());
+  b.set_range(40, 40);
+  EXPECT_TRUE(b.none());
+  EXPECT_THROW(b.set_range(10, 101), std::out_of_range);
+  EXPECT_THROW(b.reset_range(11, 10), std::out_of_range);
+  EXPECT_THROW(b.flip_range(101, 101), std::out_of_range);
+}
+
+template <class Block> static void check_fields() {
+  nstd::bitset<200, Block> b;
+  std::mt19937_64 gen(17);
+  for (std::size_t pos : {0, 1, 7, 30, 60, 63, 64, 100, 136}) {
+    std::uint64_t value = gen();
+    b.deposit(pos, value, 64);
+    EXPECT_EQ(b.template extract<64>(pos), value) << pos;
+    EXPECT_EQ(b.template extract<13>(pos), value & 0x1fff) << pos;
+    for (std::size_t i = 0; i < 64; i++)
+      ASSERT_EQ(b[pos + i], (value >> i) & 1);
+
+    // neighbours of a narrow field are untouched
+    auto before = b;
+    b.deposit(pos + 3, 0b10110, 5);
+    EXPECT_EQ(b.template extract<5>(pos + 3), 0b10110u);
+    for (std::size_t i = 0; i < 200; i++) {
+      if (i < pos + 3 || i >= pos + 8) {
+        ASSERT_EQ(b[i], before[i]) << i;
+      }
+    }
+  }
+}
+
+TEST(BitsetTest, ExtractDeposit) {
+  check_fields<std::uint8_t>();
+  check_fields<std::uint16_t>();
+  check_fields<std::uint64_t>();
+
+  nstd::bitset<70> b;
+  b.deposit(60, 0b1011, 4);
+  EXPECT_EQ(b.extract<10>(60), 0b1011u);
+  b.deposit(64, 0xff, 0);
+  EXPECT_EQ(b.extract<10>(60), 0b1011u);
+  EXPECT_THROW(b.extract<11>(60), std::out_of_range);
+  EXPECT_THROW(b.deposit(60, 0, 11), std::out_of_range);
+  EXPECT_THROW(b.deposit(0, 0, 65), std::out_of_range);
+}
+
+TEST(BitsetTest, GatherScatter) {
+  nstd::bitset<130> b;
+  std::mt19937_64 gen(19);
+  for (int trial = 0; trial < 100; trial++) {
+    std::size_t pos = gen() % 67;
+    std::uint64_t mask = gen() & gen();
+    for (std::size_t i = 0; i < 130; i++)
+      b.set(i, gen() & 1);
+
+    std::uint64_t want = 0;
+    std::size_t k = 0;
+    for (std::size_t i = 0; i < 64; i++) {
+      if ((mask >> i) & 1)
+        want |= std::uint64_t{b[pos + i]} << k++;
+    }
+    ASSERT_EQ(b.gather(pos, mask), want);
+
+    auto before = b;
+    std::uint64_t value = gen();
+    b.scatter(pos, mask, value);
+    k = 0;
+    for (std::size_t i = 0; i < 130; i++) {
+      bool in_mask = i >= pos && i < pos + 64 && ((mask >> (i - pos)) & 1);
+      bool expected = in_mask ? (value >> k++) & 1 : before[i];
+      ASSERT_EQ(b[i], expected) << i;
+    }
+    std::uint64_t low = k == 64 ? value : value & ((std::uint64_t{1} << k) - 1);
+    ASSERT_EQ(b.gather(pos, mask), low);
+  }
+  EXPECT_EQ(b.gather(130, 0), 0u);
+  EXPECT_THROW(b.gather(127, 0b1000), std::out_of_range);
+  EXPECT_THROW(b.scatter(100, std::uint64_t{1} << 40, 1), std::out_of_range);
+}
+
 TEST(BitsetTest, OutOfRange) {
   nstd::bitset<8> b;
   EXPECT_THROW(b.set(8), std::out_of_range);
@@ -185,26 +730,39 @@ TEST(BitsetTest, RefCopyCtor) {
 }
 
 TEST(BitsetTest, RefCopyAssign) {
+  // assignment copies the bit, as for std::bitset; ref2 still names b[1]
   b4_t b{1};
   b4_t::reference ref = b[0];
   b4_t::reference ref2 = b[1];
   ref2 = ref;
-  ASSERT_TRUE(static_cast<bool>(ref));
-  EXPECT_TRUE(static_cast<bool>(ref2));
+  EXPECT_TRUE(b[1]);
+  EXPECT_EQ(b.to_ulong(), 0b0011UL);
   ref = false;
-  EXPECT_EQ(static_cast<bool>(ref), static_cast<bool>(ref2));
-  EXPECT_EQ(static_cast<bool>(ref), b[0]);
-  EXPECT_FALSE(static_cast<bool>(ref));
-  ref = true;
-  EXPECT_EQ(static_cast<bool>(ref), static_cast<bool>(ref2));
-  EXPECT_EQ(static_cast<bool>(ref), b[0]);
-  EXPECT_TRUE(static_cast<bool>(ref));
-  b[0] = false;
-  EXPECT_EQ(static_cast<bool>(ref), static_cast<bool>(ref2));
-  EXPECT_EQ(static_cast<bool>(ref), b[0]);
-  EXPECT_FALSE(static_cast<bool>(ref));
+  EXPECT_TRUE(static_cast<bool>(ref2));
+  EXPECT_EQ(b.to_ulong(), 0b0010UL);
+  ref2 = ref;
+  EXPECT_EQ(b.to_ulong(), 0UL);
 }
 
+TEST(BitsetTest, RefCopyAssignAcrossBlocks) {
+  nstd::bitset<128, std::uint64_t> b;
+  b.set(64).set(65);
+  b[0] = b[64];
+  EXPECT_TRUE(b[0]);
+  EXPECT_FALSE(b[1]);
+  EXPECT_EQ(b.count(), 3u);
+  b[127] = b[2];
+  b[3] = b[65];
+  EXPECT_FALSE(b[127]);
+  EXPECT_TRUE(b[64] && b[65]);
+  EXPECT_EQ(b.count(), 4u);
+
+  nstd::bitset<32, std::uint8_t> small;
+  small.set(9);
+  small[0] = small[9];
+  EXPECT_EQ(small.count(), 2u);
+  EXPECT_FALSE(small[1]);
+}
 
 TEST(BitsetTest, RefNot) {
   b4_t b{1};
@@ -220,6 +778,122 @@ TEST(BitsetTest, RefFlip) {
   EXPECT_FALSE(b[0]);
 }
 
+template <std::size_t N> static void check_hash() {
+  using wide = nstd::bitset<N, std::uint64_t>;
+  using narrow = nstd::bitset<N, std::uint8_t>;
+  std::mt19937_64 gen(N);
+  std::unordered_set<std::size_t> seen;
+  for (int round = 0; round < 200; round++) {
+    wide w;
+    narrow b;
+    for (std::size_t i = 0; i < N; i++) {
+      bool bit = gen() % 4 == 0;
+      w.set(i, bit);
+      b.set(i, bit);
+    }
+    std::size_t h = nstd::hash<wide>{}(w);
+    // the hash only sees the bits, not the block type
+    ASSERT_EQ(h, nstd::hash<narrow>{}(b));
+    ASSERT_EQ(h, std::hash<wide>{}(w));
+    seen.insert(h);
+    // every single-bit change moves it
+    for (std::size_t i = 0; i < N; i += N / 7 + 1) {
+      w.flip(i);
+      ASSERT_NE(nstd::hash<wide>{}(w), h) << i;
+      w.flip(i);
+    }
+  }
+  // random masks practically never collide, once there are enough of them
+  if (N >= 64) {
+    EXPECT_GT(seen.size(), 195u);
+  }
+}
+
+TEST(BitsetTest, Hash) {
+  check_hash<1>();
+  check_hash<100>();
+  check_hash<512>();
+  check_hash<1000>();
+  check_hash<9000>();
+  // sizes are part of the hash, even with the same words
+  EXPECT_NE(nstd::hash<nstd::bitset<64>>{}(nstd::bitset<64>{}),
+            nstd::hash<nstd::bitset<65>>{}(nstd::bitset<65>{}));
+
+  std::unordered_set<nstd::bitset<300>> masks;
+  for (std::size_t i = 0; i < 300; i++)
+    masks.insert(nstd::bitset<300>{}.set(i));
+  EXPECT_EQ(masks.size(), 300u);
+  EXPECT_TRUE(masks.contains(nstd::bitset<300>{}.set(42)));
+}
+
+// A character-class table built at compile time. 1024 bits of 64-bit blocks
+// is past simd::min_words, so the bulk operations below would take the
+// dispatched kernels at runtime.
+using char_table = nstd::bitset<1024, std::uint64_t>;
+
+constexpr char_table char_class(char first, char last) {
+  char_table t;
+  t.set_range(static_cast<unsigned char>(first),
+              static_cast<unsigned char>(last) + 1);
+  return t;
+}
+
+constexpr char_table ident_chars = [] {
+  char_table t = char_class('a', 'z') | char_class('A', 'Z');
+  t |= char_class('0', '9');
+  t.set('_');
+  return t;
+}();
+
+static_assert(ident_chars.count() == 63);
+static_assert(ident_chars['q'] && ident_chars.test('_') && !ident_chars[' ']);
+static_assert(ident_chars.find_first() == '0');
+static_assert(ident_chars.find_last() == 'z');
+static_assert((ident_chars & ~char_class('0', '9')).count() == 53);
+static_assert(intersects(ident_chars, char_class('-', '0')));
+static_assert(ident_chars.any() && !ident_chars.all());
+
+TEST(BitsetTest, ConstantEvaluation) {
+  constexpr auto shifted = [] {
+    char_table t = ident_chars;
+    t <<= 100;
+    t >>= 99;
+    t.flip();
+    t ^= char_table{}.set();
+    return t;
+  }();
+  static_assert(shifted == ident_chars << 1);
+  static_assert((shifted ^ (ident_chars << 1)).none());
+
+  constexpr auto fields = [] {
+    nstd::bitset<100, std::uint8_t> b;
+    b.deposit(3, 0x2d, 6);
+    b.scatter(40, 0xf0f, 0x3c);
+    b[99] = true;
+    b.reset(99);
+    b.set(98, true);
+    return b;
+  }();
+  static_assert(fields.extract<6>(3) == 0x2d);
+  static_assert(fields.gather(40, 0xf0f) == 0x3c);
+  static_assert(fields.find_next(49) == 98);
+  static_assert(fields.count() == 9);
+
+  constexpr std::size_t second = [] {
+    auto bits = ident_chars.set_bits();
+    return *std::next(bits.begin());
+  }();
+  static_assert(second == '1');
+
+  // the same values at runtime, through the SIMD kernels
+  char_table t = char_class('a', 'z') | char_class('A', 'Z');
+  t |= char_class('0', '9');
+  t.set('_');
+  EXPECT_EQ(t, ident_chars);
+  EXPECT_EQ(t.count(), ident_chars.count());
+  EXPECT_EQ(t << 1, shifted);
+}
+
 
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
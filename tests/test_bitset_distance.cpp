@@ -0,0 +1,122 @@
+#include "../include/bitset_distance.hpp"
+#include "../include/simd.hpp"
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace simd = nstd::detail::simd;
+
+template <class Bitset>
+static std::vector<Bitset> random_fingerprints(std::size_t n, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::vector<Bitset> v(n);
+  for (auto& b : v) {
+    for (std::size_t i = 0; i < b.size(); i++) {
+      if (gen() % 3 == 0)
+        b.set(i);
+    }
+  }
+  return v;
+}
+
+template <class Bitset> static void check_one_to_many() {
+  auto base = random_fingerprints<Bitset>(70, 1);
+  auto query = random_fingerprints<Bitset>(1, 2)[0];
+  base[5] = query;
+  base[6].reset();
+  std::vector<std::size_t> ham(base.size()), both(base.size()),
+      either(base.size());
+  std::vector<double> jac(base.size());
+  nstd::hamming_distances(query, base, ham);
+  nstd::intersection_counts(query, base, both);
+  nstd::union_counts(query, base, either);
+  nstd::jaccard_similarities(query, base, jac);
+  for (std::size_t j = 0; j < base.size(); j++) {
+    ASSERT_EQ(ham[j], (query ^ base[j]).count()) << j;
+    ASSERT_EQ(both[j], (query & base[j]).count()) << j;
+    ASSERT_EQ(either[j], (query | base[j]).count()) << j;
+    ASSERT_DOUBLE_EQ(jac[j], double(both[j]) / double(either[j])) << j;
+  }
+  EXPECT_EQ(ham[5], 0u);
+  EXPECT_DOUBLE_EQ(jac[5], 1.0);
+  EXPECT_EQ(both[6], 0u);
+}
+
+TEST(BitsetDistanceTest, OneToMany) {
+  check_one_to_many<nstd::bitset<256>>();
+  check_one_to_many<nstd::bitset<320>>();
+  check_one_to_many<nstd::bitset<1000>>();
+  check_one_to_many<nstd::bitset<4096>>();
+  check_one_to_many<nstd::bitset<100, std::uint32_t>>();
+}
+
+TEST(BitsetDistanceTest, ManyToMany) {
+  using fp = nstd::bitset<512>;
+  // more base fingerprints than one tile holds
+  auto base = random_fingerprints<fp>(300, 3);
+  auto queries = random_fingerprints<fp>(7, 4);
+  std::vector<std::size_t> ham(queries.size() * base.size());
+  std::vector<double> jac(queries.size() * base.size());
+  nstd::hamming_distances(queries, base, ham);
+  nstd::jaccard_similarities(queries, base, jac);
+  for (std::size_t i = 0; i < queries.size(); i++) {
+    for (std::size_t j = 0; j < base.size(); j++) {
+      ASSERT_EQ(ham[i * base.size() + j], (queries[i] ^ base[j]).count());
+      ASSERT_DOUBLE_EQ(jac[i * base.size() + j],
+                       double((queries[i] & base[j]).count()) /
+                           double((queries[i] | base[j]).count()));
+    }
+  }
+}
+
+TEST(BitsetDistanceTest, EdgeCases) {
+  using fp = nstd::bitset<256>;
+  std::vector<fp> base(3);
+  fp empty;
+  std::vector<double> jac(3);
+  nstd::jaccard_similarities(empty, base, jac);
+  EXPECT_EQ(jac, std::vector<double>(3, 1.0));
+
+  std::vector<std::size_t> small(2);
+  EXPECT_THROW(nstd::hamming_distances(empty, base, small),
+               std::invalid_argument);
+  EXPECT_THROW(nstd::union_counts(base, base, small), std::invalid_argument);
+  std::vector<fp> none;
+  EXPECT_NO_THROW(nstd::hamming_distances(empty, none, small));
+}
+
+TEST(BitsetDistanceTest, KernelsAgree) {
+  std::mt19937_64 gen(5);
+  std::vector<simd::word> q(70), base(70 * 9);
+  for (auto& w : q)
+    w = gen();
+  for (auto& w : base)
+    w = gen();
+  for (auto level : {simd::isa::scalar, simd::isa::sse2, simd::isa::avx2,
+                     simd::isa::avx512}) {
+    if (level > simd::detected_isa())
+      continue;
+    auto k = simd::kernels_for(level);
+    for (std::size_t words : {1, 3, 4, 7, 8, 9, 16, 63, 70}) {
+      std::size_t got[9], want[9];
+      k.count_xor_many(q.data(), base.data(), words, 9, got);
+      simd::scalar::count_many<simd::pair_op::bit_xor>(q.data(), base.data(),
+                                                       words, 9, want);
+      EXPECT_TRUE(std::equal(got, got + 9, want)) << words;
+      k.count_and_many(q.data(), base.data(), words, 9, got);
+      simd::scalar::count_many<simd::pair_op::bit_and>(q.data(), base.data(),
+                                                       words, 9, want);
+      EXPECT_TRUE(std::equal(got, got + 9, want)) << words;
+      k.count_or_many(q.data(), base.data(), words, 9, got);
+      simd::scalar::count_many<simd::pair_op::bit_or>(q.data(), base.data(),
+                                                      words, 9, want);
+      EXPECT_TRUE(std::equal(got, got + 9, want)) << words;
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
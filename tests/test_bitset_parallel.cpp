@@ -0,0 +1,151 @@
+#include "../include/bitset_parallel.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Large enough for the parallel path: 2 MiB plus a partial last block.
+constexpr std::size_t big = (std::size_t{1} << 24) + 37;
+constexpr nstd::parallel_policy four{4};
+
+template <class Block>
+nstd::dynamic_bitset<Block> random_bits(std::size_t n, unsigned seed) {
+  std::vector<std::byte> bytes((n + 7) / 8);
+  std::mt19937_64 gen(seed);
+  for (auto& b : bytes)
+    b = static_cast<std::byte>(gen());
+  if (n % 8)
+    bytes.back() &= static_cast<std::byte>((1u << (n % 8)) - 1);
+  return nstd::dynamic_bitset<Block>::from_bytes(bytes, n);
+}
+
+template <class Block> void check_bulk_ops(std::size_t n) {
+  auto a = random_bits<Block>(n, 1), b = random_bits<Block>(n, 2);
+  EXPECT_EQ(nstd::count(four, a), a.count());
+  EXPECT_EQ(nstd::count(nstd::par, a), a.count());
+  EXPECT_TRUE(nstd::any(four, a));
+  EXPECT_FALSE(nstd::any(four, nstd::dynamic_bitset<Block>(n)));
+
+  auto expected = a;
+  expected &= b;
+  auto got = a;
+  EXPECT_EQ(nstd::and_assign(four, got, b), expected);
+
+  expected = a;
+  expected |= b;
+  got = a;
+  EXPECT_EQ(nstd::or_assign(four, got, b), expected);
+
+  expected = a;
+  expected ^= b;
+  got = a;
+  EXPECT_EQ(nstd::xor_assign(four, got, b), expected);
+
+  expected = a;
+  expected.flip();
+  got = a;
+  EXPECT_EQ(nstd::flip(four, got), expected);
+  EXPECT_EQ(nstd::count(four, got), n - a.count());
+}
+
+template <class Block> void check_shifts(std::size_t n) {
+  auto a = random_bits<Block>(n, 3);
+  // within a block, whole blocks, and past a chunk or the whole set
+  for (std::size_t pos : {std::size_t{0}, std::size_t{1}, std::size_t{7},
+                          std::size_t{63}, std::size_t{64}, std::size_t{65},
+                          std::size_t{1000003}, n / 3 + 5, n - 1, n, n + 9}) {
+    auto expected = a;
+    expected <<= pos;
+    auto got = a;
+    EXPECT_EQ(nstd::shift_left(four, got, pos), expected) << pos;
+
+    expected = a;
+    expected >>= pos;
+    got = a;
+    EXPECT_EQ(nstd::shift_right(four, got, pos), expected) << pos;
+  }
+}
+
+TEST(BitsetParallelTest, BulkOps) {
+  check_bulk_ops<std::uint64_t>(big);
+  check_bulk_ops<std::uint8_t>(big);
+}
+
+TEST(BitsetParallelTest, Shifts) {
+  check_shifts<std::uint64_t>(big);
+  check_shifts<std::uint8_t>(big);
+}
+
+TEST(BitsetParallelTest, SmallSetsRunSerially) {
+  check_bulk_ops<std::uint64_t>(1000);
+  check_shifts<std::uint64_t>(1000);
+}
+
+TEST(BitsetParallelTest, ThreadCounts) {
+  auto a = random_bits<std::uint64_t>(big, 4);
+  for (unsigned t : {1u, 2u, 3u, 7u, 64u}) {
+    EXPECT_EQ(nstd::count({t}, a), a.count()) << t;
+    auto expected = a;
+    expected <<= 4099;
+    auto got = a;
+    EXPECT_EQ(nstd::shift_left({t}, got, 4099), expected) << t;
+  }
+}
+
+TEST(BitsetParallelTest, ChunksSplitAtCacheLines) {
+  // storage starting anywhere within a line
+  constexpr std::size_t n = (std::size_t{1} << 20) + 3;
+  std::vector<std::uint64_t> buf(n + 8);
+  for (std::size_t offset = 0; offset < 8; offset++) {
+    const std::uint64_t* data = buf.data() + offset;
+    auto c = nstd::detail::make_chunks(four, data, n);
+    ASSERT_GT(c.count, 1u);
+    EXPECT_EQ(c.first(0), 0u);
+    EXPECT_EQ(c.last(c.count - 1), n);
+    for (std::size_t k = 1; k < c.count; k++) {
+      EXPECT_EQ(c.first(k), c.last(k - 1));
+      EXPECT_LT(c.first(k), c.last(k));
+      EXPECT_EQ(reinterpret_cast<std::uintptr_t>(data + c.first(k)) % 64, 0u)
+          << offset << ' ' << k;
+    }
+  }
+}
+
+TEST(BitsetParallelTest, FixedSizeBitset) {
+  using bs = nstd::bitset<big, std::uint64_t>;
+  auto a = std::make_unique<bs>(), b = std::make_unique<bs>();
+  for (std::size_t i = 0; i < big; i += 3)
+    a->set(i);
+  for (std::size_t i = 0; i < big; i += 5)
+    b->set(i);
+
+  auto expected = std::make_unique<bs>(*a);
+  *expected |= *b;
+  auto got = std::make_unique<bs>(*a);
+  nstd::or_assign(four, *got, *b);
+  EXPECT_EQ(*got, *expected);
+
+  *expected = *a;
+  *expected <<= 12345;
+  *got = *a;
+  nstd::shift_left(four, *got, 12345);
+  EXPECT_EQ(*got, *expected);
+
+  *got = *a;
+  nstd::flip(four, *got);
+  EXPECT_EQ(nstd::count(four, *got), big - a->count());
+}
+
+TEST(BitsetParallelTest, SizeMismatchThrows) {
+  nstd::dynamic_bitset<> a(big), b(big - 1);
+  EXPECT_THROW(nstd::and_assign(four, a, b), std::invalid_argument);
+  EXPECT_THROW(nstd::or_assign(four, a, b), std::invalid_argument);
+  EXPECT_THROW(nstd::xor_assign(four, a, b), std::invalid_argument);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,130 @@
+#include "../include/bitset_view.hpp"
+#include "../include/dynamic_bitset.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define HAVE_MMAP 1
+#endif
+
+static nstd::dynamic_bitset<> random_bits(std::size_t n, unsigned seed) {
+  std::mt19937 gen(seed);
+  nstd::dynamic_bitset<> b(n);
+  for (std::size_t i = 0; i < n; i++) {
+    if (gen() % 5 == 0)
+      b.set(i);
+  }
+  return b;
+}
+
+// copies bytes into 8-byte aligned storage, as a file mapping would be
+static std::vector<std::uint64_t> aligned_copy(std::span<const std::byte> b) {
+  std::vector<std::uint64_t> words((b.size() + 7) / 8);
+  if (!b.empty())
+    std::memcpy(words.data(), b.data(), b.size());
+  return words;
+}
+
+static void expect_same(const nstd::bitset_view& v,
+                        const nstd::dynamic_bitset<>& b) {
+  ASSERT_EQ(v.size(), b.size());
+  EXPECT_EQ(v.count(), b.count());
+  EXPECT_EQ(v.any(), b.any());
+  EXPECT_EQ(v.all(), b.all());
+  for (std::size_t i = 0; i < b.size(); i++)
+    ASSERT_EQ(v[i], b[i]) << i;
+  std::size_t i = v.find_first(), j = b.find_first();
+  for (; j != b.npos; i = v.find_next(i), j = b.find_next(j))
+    ASSERT_EQ(i, j);
+  EXPECT_EQ(i, v.npos);
+}
+
+TEST(BitsetViewTest, MatchesOwner) {
+  for (std::size_t n : {0, 1, 7, 8, 9, 63, 64, 65, 100, 1000, 4099}) {
+    auto b = random_bits(n, static_cast<unsigned>(n));
+    auto bytes = b.as_bytes();
+    ASSERT_EQ(bytes.size(), (n + 7) / 8);
+    auto storage = aligned_copy(bytes);
+    nstd::bitset_view v({reinterpret_cast<const std::byte*>(storage.data()),
+                         bytes.size()},
+                        n);
+    expect_same(v, b);
+    EXPECT_TRUE(nstd::dynamic_bitset<>::from_bytes(v.as_bytes(), n) == b);
+
+    b.set();
+    storage = aligned_copy(b.as_bytes());
+    nstd::bitset_view full({reinterpret_cast<const std::byte*>(storage.data()),
+                            bytes.size()},
+                           n);
+    EXPECT_TRUE(full.all());
+    EXPECT_EQ(full.count(), n);
+  }
+}
+
+TEST(BitsetViewTest, RejectsBadInput) {
+  alignas(8) std::byte buf[16] = {};
+  EXPECT_THROW(nstd::bitset_view({buf, 2}, 20), std::invalid_argument);
+  EXPECT_THROW(nstd::bitset_view({buf + 1, 2}, 12), std::invalid_argument);
+  buf[1] = std::byte{0x10};
+  EXPECT_THROW(nstd::bitset_view({buf, 2}, 12), std::invalid_argument);
+  EXPECT_NO_THROW(nstd::bitset_view({buf, 2}, 13));
+  nstd::bitset_view v({buf, 2}, 13);
+  EXPECT_THROW(v.test(13), std::out_of_range);
+  EXPECT_TRUE(v.test(12));
+}
+
+TEST(BitsetViewTest, ByteLayout) {
+  // bit i is bit i % 8 of byte i / 8, whatever the block type
+  nstd::bitset<20> a;
+  a.set(0).set(9).set(19);
+  nstd::bitset<20, std::uint8_t> b;
+  b.set(0).set(9).set(19);
+  nstd::bitset<20, std::uint64_t> c;
+  c.set(0).set(9).set(19);
+  const std::byte expected[] = {std::byte{0x01}, std::byte{0x02},
+                                std::byte{0x08}};
+  for (auto bytes : {std::span<const std::byte>(a.as_bytes()),
+                     std::span<const std::byte>(b.as_bytes()),
+                     std::span<const std::byte>(c.as_bytes())}) {
+    ASSERT_EQ(bytes.size(), 3u);
+    EXPECT_EQ(std::memcmp(bytes.data(), expected, 3), 0);
+  }
+  EXPECT_TRUE(nstd::bitset<20>::from_bytes(expected) == a);
+  EXPECT_TRUE((nstd::bitset<20, std::uint8_t>::from_bytes(expected) == b));
+  EXPECT_THROW(nstd::bitset<19>::from_bytes(expected), std::invalid_argument);
+  EXPECT_THROW(nstd::bitset<30>::from_bytes(expected), std::invalid_argument);
+}
+
+#ifdef HAVE_MMAP
+TEST(BitsetViewTest, MappedFile) {
+  auto b = random_bits(100003, 42);
+  char path[] = "/tmp/nstd_bitset_viewXXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  auto bytes = b.as_bytes();
+  ASSERT_EQ(write(fd, bytes.data(), bytes.size()),
+            static_cast<ssize_t>(bytes.size()));
+
+  void* map = mmap(nullptr, bytes.size(), PROT_READ, MAP_PRIVATE, fd, 0);
+  ASSERT_NE(map, MAP_FAILED);
+  nstd::bitset_view v({static_cast<const std::byte*>(map), bytes.size()},
+                      b.size());
+  expect_same(v, b);
+  munmap(map, bytes.size());
+  close(fd);
+  std::remove(path);
+}
+#endif
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
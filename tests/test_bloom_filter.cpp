@@ -0,0 +1,141 @@
+#include "../include/bloom_filter.hpp"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using nstd::blocked_bloom_filter;
+using nstd::split_block_bloom_filter;
+
+static std::vector<std::uint64_t> random_keys(std::size_t n, unsigned seed) {
+  std::mt19937_64 gen(seed);
+  std::vector<std::uint64_t> keys(n);
+  for (auto& k : keys)
+    k = gen();
+  return keys;
+}
+
+// no false negatives, a false-positive rate near the expected one, and the
+// batched calls agree with the single-key ones
+template <class Filter>
+static void check_filter(Filter& f, double max_fp_rate) {
+  auto keys = random_keys(20000, 1);
+  for (std::size_t i = 0; i < keys.size() / 2; i++)
+    f.insert(keys[i]);
+  f.insert_many(std::span<const std::uint64_t>(keys).subspan(keys.size() / 2));
+  for (auto k : keys)
+    ASSERT_TRUE(f.contains(k)) << k;
+
+  auto others = random_keys(100000, 2);
+  auto found = std::make_unique<bool[]>(others.size());
+  f.contains_many(others, {found.get(), others.size()});
+  std::size_t false_positives = 0;
+  for (std::size_t i = 0; i < others.size(); i++) {
+    ASSERT_EQ(found[i], f.contains(others[i])) << i;
+    false_positives += found[i];
+  }
+  EXPECT_LT(static_cast<double>(false_positives) / others.size(), max_fp_rate);
+}
+
+TEST(BloomFilterTest, SplitBlock) {
+  // 10 bits per key
+  split_block_bloom_filter<std::uint64_t> f(200000);
+  EXPECT_EQ(f.size(), f.num_blocks() * 256);
+  EXPECT_FALSE(f.contains(42));
+  check_filter(f, 0.02);
+}
+
+TEST(BloomFilterTest, Blocked) {
+  blocked_bloom_filter<std::uint64_t> f(200000, 7);
+  EXPECT_EQ(f.size(), f.num_blocks() * 512);
+  EXPECT_EQ(f.num_probes(), 7u);
+  EXPECT_FALSE(f.contains(42));
+  check_filter(f, 0.02);
+  EXPECT_THROW(blocked_bloom_filter<int>(1000, 0), std::invalid_argument);
+  EXPECT_THROW(blocked_bloom_filter<int>(1000, 17), std::invalid_argument);
+}
+
+TEST(BloomFilterTest, SplitBlockKernelsMatchScalar) {
+  namespace simd = nstd::detail::simd;
+  auto hashes = random_keys(1000, 3);
+  std::vector<simd::word> ref(64 * 4), fast(64 * 4);
+  simd::scalar::sbbf_insert(ref.data(), 64, hashes.data(), 500);
+  simd::active().sbbf_insert(fast.data(), 64, hashes.data(), 500);
+  EXPECT_EQ(ref, fast);
+  // every lane of a probe gets exactly one bit
+  std::vector<simd::word> one(4);
+  simd::scalar::sbbf_insert(one.data(), 1, hashes.data(), 1);
+  for (auto w : one) {
+    EXPECT_EQ(std::popcount(static_cast<std::uint32_t>(w)), 1);
+    EXPECT_EQ(std::popcount(static_cast<std::uint32_t>(w >> 32)), 1);
+  }
+
+  auto a = std::make_unique<bool[]>(hashes.size());
+  auto b = std::make_unique<bool[]>(hashes.size());
+  simd::scalar::sbbf_contains(ref.data(), 64, hashes.data(), hashes.size(),
+                              a.get());
+  simd::active().sbbf_contains(ref.data(), 64, hashes.data(), hashes.size(),
+                               b.get());
+  for (std::size_t i = 0; i < hashes.size(); i++) {
+    ASSERT_EQ(a[i], b[i]) << i;
+    if (i < 500) {
+      ASSERT_TRUE(a[i]);
+    }
+  }
+}
+
+TEST(BloomFilterTest, CustomHash) {
+  struct length_hash {
+    std::size_t operator()(const std::string& s) const { return s.size(); }
+  };
+  split_block_bloom_filter<std::string, length_hash> f(1024);
+  f.insert("abc");
+  // only the length is hashed
+  EXPECT_TRUE(f.contains("xyz"));
+  EXPECT_FALSE(f.contains("abcd"));
+  static_assert(sizeof(f) == sizeof(nstd::detail::bloom_words));
+}
+
+TEST(BloomFilterTest, SerializedRoundTrip) {
+  auto keys = random_keys(5000, 4);
+  split_block_bloom_filter<std::uint64_t> s(50000);
+  blocked_bloom_filter<std::uint64_t> b(50000, 5);
+  s.insert_many(keys);
+  b.insert_many(keys);
+
+  auto s_bytes = s.as_bytes();
+  EXPECT_EQ(s_bytes.size(), s.size() / 8);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(s_bytes.data()) % 64, 0u);
+  auto s2 = split_block_bloom_filter<std::uint64_t>::from_bytes(s_bytes);
+  auto b2 = blocked_bloom_filter<std::uint64_t>::from_bytes(b.as_bytes(), 5);
+  EXPECT_EQ(s2.num_blocks(), s.num_blocks());
+  EXPECT_EQ(s2.count(), s.count());
+  EXPECT_EQ(b2.count(), b.count());
+  for (auto k : random_keys(2000, 5)) {
+    ASSERT_EQ(s2.contains(k), s.contains(k));
+    ASSERT_EQ(b2.contains(k), b.contains(k));
+  }
+
+  b2.clear();
+  EXPECT_EQ(b2.count(), 0u);
+  EXPECT_THROW(split_block_bloom_filter<int>::from_bytes(s_bytes.first(40)),
+               std::invalid_argument);
+  EXPECT_THROW(blocked_bloom_filter<int>::from_bytes(s_bytes.first(32)),
+               std::invalid_argument);
+  EXPECT_THROW(split_block_bloom_filter<int>::from_bytes({}),
+               std::invalid_argument);
+}
+
+TEST(BloomFilterTest, OutputTooSmall) {
+  split_block_bloom_filter<int> f(1024);
+  std::vector<int> keys(10);
+  bool out[5];
+  EXPECT_THROW(f.contains_many(keys, out), std::invalid_argument);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,225 @@
+#include "../include/dynamic_bitset.hpp"
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using dbs = nstd::dynamic_bitset<>;
+
+// counts live allocations so tests can check every block is returned
+template <class T> struct counting_allocator {
+  using value_type = T;
+  static inline int live = 0;
+
+  counting_allocator() = default;
+  template <class U> counting_allocator(const counting_allocator<U>&) {}
+
+  T* allocate(std::size_t n) {
+    live++;
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* p, std::size_t n) {
+    live--;
+    std::allocator<T>().deallocate(p, n);
+  }
+  bool operator==(const counting_allocator&) const { return true; }
+};
+
+TEST(DynamicBitsetTest, DefaultConstructor) {
+  dbs b;
+  EXPECT_EQ(b.size(), 0u);
+  EXPECT_TRUE(b.empty());
+  EXPECT_TRUE(b.none());
+  EXPECT_TRUE(b.all());
+}
+
+TEST(DynamicBitsetTest, SizeValueConstructor) {
+  dbs b(8, 0b10101010ULL);
+  EXPECT_EQ(b.size(), 8u);
+  EXPECT_EQ(b.to_ulong(), 0b10101010UL);
+  EXPECT_EQ(b.to_string(), "10101010");
+
+  dbs truncated(4, 0xffULL);
+  EXPECT_EQ(truncated.count(), 4u);
+}
+
+TEST(DynamicBitsetTest, SmallBlocks) {
+  nstd::dynamic_bitset<std::uint8_t> b(20, 0xabcdeULL);
+  EXPECT_EQ(b.num_blocks(), 3u);
+  EXPECT_EQ(b.to_ulong(), 0xabcdeUL);
+  b <<= 4;
+  EXPECT_EQ(b.to_ulong(), 0xbcde0UL);
+  b >>= 8;
+  EXPECT_EQ(b.to_ulong(), 0xbcdUL);
+}
+
+TEST(DynamicBitsetTest, PushBackGrowsGeometrically) {
+  dbs b;
+  std::vector<bool> expected;
+  std::size_t reallocations = 0, last_capacity = 0;
+  for (std::size_t i = 0; i < 10000; i++) {
+    bool bit = (i * 31 + 7) % 3 == 0;
+    b.push_back(bit);
+    expected.push_back(bit);
+    if (b.capacity() != last_capacity) {
+      reallocations++;
+      last_capacity = b.capacity();
+    }
+  }
+  EXPECT_LE(reallocations, 10u);
+  ASSERT_EQ(b.size(), expected.size());
+  for (std::size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(b[i], expected[i]) << i;
+  }
+  b.pop_back();
+  EXPECT_EQ(b.size(), 9999u);
+}
+
+TEST(DynamicBitsetTest, Resize) {
+  dbs b(70);
+  b.set(69);
+  b.resize(100, true);
+  EXPECT_EQ(b.count(), 31u);
+  EXPECT_FALSE(b[68]);
+  EXPECT_TRUE(b[70]);
+  b.resize(65);
+  EXPECT_EQ(b.count(), 0u);
+  b.resize(130);
+  EXPECT_EQ(b.count(), 0u);
+  b.resize(3, true);
+  EXPECT_EQ(b.count(), 0u);
+}
+
+TEST(DynamicBitsetTest, ReserveKeepsContents) {
+  dbs b(10, 0b1011ULL);
+  b.reserve(1 << 16);
+  EXPECT_GE(b.capacity(), 1u << 16);
+  EXPECT_EQ(b.size(), 10u);
+  EXPECT_EQ(b.to_ulong(), 0b1011UL);
+  b.shrink_to_fit();
+  EXPECT_EQ(b.capacity(), 64u);
+}
+
+TEST(DynamicBitsetTest, BitwiseOps) {
+  dbs a(2000), b(2000);
+  for (std::size_t i = 0; i < 2000; i += 3)
+    a.set(i);
+  for (std::size_t i = 0; i < 2000; i += 5)
+    b.set(i);
+  EXPECT_EQ((a & b).count(), 134u);
+  EXPECT_EQ((a | b).count(), 667u + 400u - 134u);
+  EXPECT_EQ((a ^ b).count(), 667u + 400u - 2 * 134u);
+  EXPECT_EQ((~a).count(), 2000u - 667u);
+  EXPECT_TRUE((a | ~a).all());
+  EXPECT_THROW(a &= dbs(10), std::invalid_argument);
+}
+
+TEST(DynamicBitsetTest, Shifts) {
+  dbs b(130, 1);
+  b <<= 129;
+  EXPECT_TRUE(b[129]);
+  EXPECT_EQ(b.count(), 1u);
+  b <<= 1;
+  EXPECT_TRUE(b.none());
+  b.set(129);
+  EXPECT_TRUE((b >> 129)[0]);
+}
+
+TEST(DynamicBitsetTest, Reference) {
+  dbs b(4, 1);
+  dbs::reference ref = b[0];
+  EXPECT_TRUE(static_cast<bool>(ref));
+  ref = false;
+  EXPECT_FALSE(b[0]);
+  b[3] = true;
+  EXPECT_EQ(b.to_ulong(), 0b1000UL);
+  EXPECT_THROW(b.test(4), std::out_of_range);
+}
+
+TEST(DynamicBitsetTest, ReferenceCopyAssignsTheBit) {
+  dbs b(128);
+  b.set(64).set(65);
+  b[0] = b[64];
+  EXPECT_TRUE(b[0]);
+  EXPECT_FALSE(b[1]);
+  EXPECT_EQ(b.count(), 3u);
+  b[100] = b[1];
+  EXPECT_FALSE(b[100]);
+  EXPECT_TRUE(b[64] && b[65]);
+  EXPECT_EQ(b.count(), 3u);
+
+  nstd::dynamic_bitset<std::uint8_t> small(16);
+  small.set(9);
+  small[0] = small[9];
+  EXPECT_EQ(small.count(), 2u);
+  EXPECT_FALSE(small[1]);
+}
+
+TEST(DynamicBitsetTest, CopyMoveEquality) {
+  dbs a(100, 0xdeadbeefULL);
+  dbs b = a;
+  EXPECT_TRUE(a == b);
+  b.flip(99);
+  EXPECT_FALSE(a == b);
+  dbs c = std::move(b);
+  EXPECT_EQ(c.size(), 100u);
+  EXPECT_TRUE(c[99]);
+  a = c;
+  EXPECT_TRUE(a == c);
+  EXPECT_FALSE(a == dbs(101, 0xdeadbeefULL));
+}
+
+TEST(DynamicBitsetTest, Hash) {
+  // same bits, same hash as the fixed-size bitset, for any block type
+  nstd::bitset<1000> fixed;
+  nstd::dynamic_bitset<std::uint64_t> wide(1000);
+  nstd::dynamic_bitset<std::uint16_t> narrow(1000);
+  for (std::size_t i = 3; i < 1000; i += 7) {
+    fixed.set(i);
+    wide.set(i);
+    narrow.set(i);
+  }
+  std::size_t h = nstd::hash<nstd::bitset<1000>>{}(fixed);
+  EXPECT_EQ(std::hash<nstd::dynamic_bitset<std::uint64_t>>{}(wide), h);
+  EXPECT_EQ(nstd::hash<nstd::dynamic_bitset<std::uint16_t>>{}(narrow), h);
+  // appending a zero bit changes the size, and so the hash
+  wide.push_back(false);
+  EXPECT_NE(std::hash<nstd::dynamic_bitset<std::uint64_t>>{}(wide), h);
+}
+
+TEST(DynamicBitsetTest, Allocator) {
+  using cdbs = nstd::dynamic_bitset<std::size_t, counting_allocator<std::size_t>>;
+  {
+    cdbs b(1000);
+    for (std::size_t i = 0; i < 5000; i++)
+      b.push_back(true);
+    cdbs copy = b;
+    EXPECT_EQ(copy.count(), 5000u);
+    EXPECT_GT(counting_allocator<std::size_t>::live, 0);
+  }
+  EXPECT_EQ(counting_allocator<std::size_t>::live, 0);
+  EXPECT_EQ(sizeof(cdbs), 3 * sizeof(void*));
+}
+
+TEST(DynamicBitsetTest, FindAndSetBits) {
+  dbs b(1000);
+  EXPECT_EQ(b.find_first(), dbs::npos);
+  std::vector<std::size_t> expected = {0, 63, 64, 500, 999};
+  for (auto i : expected)
+    b.set(i);
+  EXPECT_EQ(b.find_first(), 0u);
+  EXPECT_EQ(b.find_next(0), 63u);
+  EXPECT_EQ(b.find_next(500), 999u);
+  EXPECT_EQ(b.find_next(999), dbs::npos);
+  EXPECT_EQ(b.find_last(), 999u);
+  std::vector<std::size_t> got;
+  for (auto i : b.set_bits())
+    got.push_back(i);
+  EXPECT_EQ(got, expected);
+  EXPECT_EQ(dbs().find_next(0), dbs::npos);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,114 @@
+#include "../include/hierarchical_bitset.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+// walks every set bit of h and of its level-0 bitset and compares them
+template <std::size_t N>
+static void expect_same_bits(const nstd::hierarchical_bitset<N>& h) {
+  const auto& flat = h.bits();
+  std::size_t i = h.find_first(), j = flat.find_first();
+  for (; j != flat.npos; i = h.find_next(i), j = flat.find_next(j))
+    ASSERT_EQ(i, j);
+  EXPECT_EQ(i, h.npos);
+  EXPECT_EQ(h.any(), flat.any());
+}
+
+template <std::size_t N> static void check_random_updates() {
+  nstd::hierarchical_bitset<N> h;
+  std::mt19937_64 gen(N);
+  EXPECT_TRUE(h.none());
+  EXPECT_EQ(h.find_first(), h.npos);
+  for (int round = 0; round < 2000; round++) {
+    std::size_t pos = gen() % N;
+    // clustered updates so whole words empty out and refill
+    if (round % 2)
+      pos = (pos / 256) * 256 % N;
+    h.set(pos, gen() % 3 != 0);
+    if (round % 97 == 0) {
+      expect_same_bits(h);
+      // every find_next from an arbitrary point matches the flat search
+      for (int k = 0; k < 20; k++) {
+        std::size_t from = gen() % N;
+        ASSERT_EQ(h.find_next(from), h.bits().find_next(from)) << from;
+      }
+    }
+  }
+  expect_same_bits(h);
+}
+
+TEST(HierarchicalBitsetTest, MatchesFlatSearch) {
+  check_random_updates<1>();
+  check_random_updates<64>();
+  check_random_updates<65>();
+  check_random_updates<4096>();
+  check_random_updates<4097>();
+  check_random_updates<300000>();
+}
+
+TEST(HierarchicalBitsetTest, SparseAcrossLevels) {
+  constexpr std::size_t n = std::size_t{1} << 20;
+  nstd::hierarchical_bitset<n> h;
+  std::vector<std::size_t> positions = {0, 63, 64, 4095, 4096, 262143,
+                                        262144, n - 1};
+  for (auto p : positions)
+    h.set(p);
+  std::vector<std::size_t> got;
+  for (auto i = h.find_first(); i != h.npos; i = h.find_next(i))
+    got.push_back(i);
+  EXPECT_EQ(got, positions);
+  EXPECT_EQ(h.count(), positions.size());
+
+  for (auto p : positions)
+    h.reset(p);
+  EXPECT_TRUE(h.none());
+  EXPECT_EQ(h.find_first(), h.npos);
+  h.set(n - 1);
+  EXPECT_EQ(h.find_first(), n - 1);
+  EXPECT_EQ(h.find_next(n - 1), h.npos);
+}
+
+TEST(HierarchicalBitsetTest, BulkAndConversion) {
+  nstd::hierarchical_bitset<10000> h;
+  h.set();
+  EXPECT_TRUE(h.all());
+  EXPECT_EQ(h.count(), 10000u);
+  EXPECT_EQ(h.find_next(5000), 5001u);
+  h.reset();
+  EXPECT_TRUE(h.none());
+
+  nstd::bitset<10000, std::uint64_t> flat;
+  flat.set(9000).set(7);
+  nstd::hierarchical_bitset<10000> from(flat);
+  EXPECT_EQ(from.find_first(), 7u);
+  EXPECT_EQ(from.find_next(7), 9000u);
+  EXPECT_THROW(from.set(10000), std::out_of_range);
+  EXPECT_THROW(from.reset(10000), std::out_of_range);
+
+  // past the last word, not just inside its padding
+  nstd::hierarchical_bitset<4096> whole;
+  EXPECT_THROW(whole.set(4096), std::out_of_range);
+  EXPECT_THROW(whole.set(std::size_t{1} << 40), std::out_of_range);
+  EXPECT_THROW(whole.reset(4096), std::out_of_range);
+  EXPECT_TRUE(whole.none());
+}
+
+TEST(HierarchicalBitsetTest, SlotAllocator) {
+  // free slots are set bits; take the lowest, give some back
+  nstd::hierarchical_bitset<5000> free_slots;
+  free_slots.set();
+  for (std::size_t i = 0; i < 5000; i++) {
+    std::size_t slot = free_slots.find_first();
+    ASSERT_EQ(slot, i);
+    free_slots.reset(slot);
+  }
+  EXPECT_EQ(free_slots.find_first(), free_slots.npos);
+  free_slots.set(4321);
+  free_slots.set(17);
+  EXPECT_EQ(free_slots.find_first(), 17u);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,807 @@
+#include "../include/memory.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// counts heap allocations and remembers the last one, per thread so that
+// tests may allocate from several at once
+static thread_local int allocations = 0;
+static thread_local void* last_alloc = nullptr;
+static thread_local std::size_t last_size = 0;
+
+[[gnu::noinline]] void* operator new(std::size_t n) {
+  allocations++;
+  last_size = n;
+  if (void* p = std::malloc(n ? n : 1))
+    return last_alloc = p;
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+// tracks construction and destruction
+struct TestType {
+  static int count;
+  int x{0};
+
+  TestType() { ++count; }
+  explicit TestType(int val) : x(val) { ++count; }
+  ~TestType() { --count; }
+
+  void setVal(int v) { x = v; }
+  int getVal() const { return x; }
+};
+
+int TestType::count = 0;
+
+struct Derived : TestType {
+  using TestType::TestType;
+};
+
+// stateless deleters of each kind take no room next to the pointer
+struct empty_deleter {
+  void operator()(int* p) const { delete p; }
+};
+struct final_deleter final {
+  void operator()(int* p) const { delete p; }
+};
+inline constexpr auto lambda_deleter = [](int* p) { delete p; };
+
+static_assert(sizeof(nstd::unique_ptr<int>) == sizeof(int*));
+static_assert(sizeof(nstd::unique_ptr<int[]>) == sizeof(int*));
+static_assert(sizeof(nstd::unique_ptr<TestType>) == sizeof(TestType*));
+static_assert(sizeof(nstd::unique_ptr<int, empty_deleter>) == sizeof(int*));
+static_assert(sizeof(nstd::unique_ptr<int, final_deleter>) == sizeof(int*));
+static_assert(sizeof(nstd::unique_ptr<int, decltype(lambda_deleter)>) ==
+              sizeof(int*));
+// deleters with state keep it
+static_assert(sizeof(nstd::unique_ptr<int, void (*)(int*)>) ==
+              2 * sizeof(int*));
+
+// A bump arena handing out its buffer and counting what is still live; the
+// handles are stateful, one pointer each.
+struct arena {
+  alignas(64) unsigned char buf[4096];
+  std::size_t used = 0;
+  int live = 0;
+  std::size_t last_size = 0;
+};
+
+template <class T> struct arena_allocator {
+  using value_type = T;
+  arena* a;
+
+  explicit arena_allocator(arena* a) noexcept : a(a) {}
+  template <class U>
+  arena_allocator(const arena_allocator<U>& o) noexcept : a(o.a) {}
+
+  T* allocate(std::size_t n) {
+    std::size_t bytes = n * sizeof(T);
+    a->used = (a->used + alignof(T) - 1) / alignof(T) * alignof(T);
+    if (a->used + bytes > sizeof(a->buf))
+      throw std::bad_alloc();
+    T* p = reinterpret_cast<T*>(a->buf + a->used);
+    a->used += bytes;
+    a->live++;
+    a->last_size = bytes;
+    return p;
+  }
+  void deallocate(T*, std::size_t) noexcept { a->live--; }
+
+  template <class U> bool operator==(const arena_allocator<U>& o) const {
+    return a == o.a;
+  }
+};
+
+// stateless, straight to operator new
+template <class T> struct plain_allocator {
+  using value_type = T;
+  plain_allocator() = default;
+  template <class U> plain_allocator(const plain_allocator<U>&) noexcept {}
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+  void deallocate(T* p, std::size_t) noexcept { ::operator delete(p); }
+  template <class U> bool operator==(const plain_allocator<U>&) const {
+    return true;
+  }
+};
+
+TEST(UniquePtr, DefaultConstructor) {
+  nstd::unique_ptr<int> ptr;
+  EXPECT_FALSE(ptr);
+  EXPECT_EQ(ptr.get(), nullptr);
+  EXPECT_TRUE(ptr == nullptr);
+}
+
+TEST(UniquePtr, RawPointerConstructor) {
+  nstd::unique_ptr<int> ptr(new int(10));
+  EXPECT_TRUE(ptr);
+  EXPECT_NE(ptr.get(), nullptr);
+  EXPECT_EQ(*ptr, 10);
+}
+
+TEST(UniquePtr, MoveConstructor) {
+  nstd::unique_ptr<int> ptr1(new int(42));
+  EXPECT_TRUE(ptr1);
+
+  nstd::unique_ptr<int> ptr2(nstd::move(ptr1));
+  EXPECT_FALSE(ptr1);
+  EXPECT_TRUE(ptr2);
+  EXPECT_NE(ptr2.get(), nullptr);
+  EXPECT_EQ(*ptr2, 42);
+}
+
+TEST(UniquePtr, ConvertingMove) {
+  {
+    nstd::unique_ptr<Derived> d(new Derived(7));
+    nstd::unique_ptr<TestType> b(nstd::move(d));
+    EXPECT_FALSE(d);
+    EXPECT_EQ(b->getVal(), 7);
+  }
+  EXPECT_EQ(TestType::count, 0);
+}
+
+TEST(UniquePtr, MoveAssignment) {
+  nstd::unique_ptr<int> ptr1(new int(100));
+  nstd::unique_ptr<int> ptr2(new int(200));
+  EXPECT_EQ(*ptr1, 100);
+  EXPECT_EQ(*ptr2, 200);
+
+  ptr2 = nstd::move(ptr1);
+  EXPECT_FALSE(ptr1);
+  EXPECT_TRUE(ptr2);
+  EXPECT_EQ(*ptr2, 100);
+
+  ptr2 = nullptr;
+  EXPECT_FALSE(ptr2);
+}
+
+TEST(UniquePtr, OperatorBool) {
+  nstd::unique_ptr<int> ptr;
+  EXPECT_FALSE(ptr);
+
+  ptr = nstd::unique_ptr<int>(new int(5));
+  EXPECT_TRUE(ptr);
+}
+
+TEST(UniquePtr, DereferenceOperator) {
+  nstd::unique_ptr<int> ptr(new int(5));
+  EXPECT_EQ(*ptr, 5);
+  *ptr = 10;
+  EXPECT_EQ(*ptr, 10);
+}
+
+TEST(UniquePtr, ArrowOperator) {
+  nstd::unique_ptr<TestType> ptr(new TestType(123));
+  ASSERT_NE(ptr.get(), nullptr);
+  EXPECT_EQ(ptr->getVal(), 123);
+
+  ptr->setVal(456);
+  EXPECT_EQ(ptr->getVal(), 456);
+}
+
+TEST(UniquePtr, ReleaseAndReset) {
+  nstd::unique_ptr<TestType> ptr(new TestType(1));
+  TestType* raw = ptr.release();
+  EXPECT_FALSE(ptr);
+  EXPECT_EQ(TestType::count, 1);
+
+  ptr.reset(raw);
+  ptr.reset(new TestType(2));
+  EXPECT_EQ(TestType::count, 1);
+  EXPECT_EQ(ptr->getVal(), 2);
+  ptr.reset();
+  EXPECT_EQ(TestType::count, 0);
+}
+
+TEST(UniquePtr, SwapFunction) {
+  nstd::unique_ptr<int> ptr1(new int(1));
+  nstd::unique_ptr<int> ptr2(new int(2));
+  EXPECT_EQ(*ptr1, 1);
+  EXPECT_EQ(*ptr2, 2);
+
+  swap(ptr1, ptr2);
+  EXPECT_EQ(*ptr1, 2);
+  EXPECT_EQ(*ptr2, 1);
+}
+
+TEST(UniquePtr, ArraySupport) {
+  nstd::unique_ptr<int[]> arrPtr(new int[3]{10, 20, 30});
+  EXPECT_EQ(arrPtr[0], 10);
+  EXPECT_EQ(arrPtr[1], 20);
+  EXPECT_EQ(arrPtr[2], 30);
+
+  arrPtr[1] = 999;
+  EXPECT_EQ(arrPtr[1], 999);
+
+  auto zeros = nstd::make_unique<int[]>(4);
+  for (int i = 0; i < 4; i++)
+    EXPECT_EQ(zeros[i], 0);
+}
+
+TEST(UniquePtr, MakeUnique) {
+  auto intPtr = nstd::make_unique<int>(77);
+  ASSERT_TRUE(intPtr);
+  EXPECT_EQ(*intPtr, 77);
+
+  auto objPtr = nstd::make_unique<TestType>(999);
+  ASSERT_TRUE(objPtr);
+  EXPECT_EQ(objPtr->getVal(), 999);
+}
+
+TEST(UniquePtr, DestructionTest) {
+  {
+    EXPECT_EQ(TestType::count, 0);
+    auto ptr = nstd::make_unique<TestType>(42);
+    EXPECT_EQ(TestType::count, 1);
+    EXPECT_EQ(ptr->getVal(), 42);
+  }
+  EXPECT_EQ(TestType::count, 0);
+}
+
+TEST(UniquePtr, CustomDeleters) {
+  static int closed = 0;
+  {
+    auto closer = [](std::FILE* f) {
+      closed++;
+      std::fclose(f);
+    };
+    nstd::unique_ptr<std::FILE, decltype(closer)> f(std::tmpfile(), closer);
+    ASSERT_TRUE(f);
+    static_assert(sizeof(f) == sizeof(std::FILE*));
+  }
+  EXPECT_EQ(closed, 1);
+
+  static int freed = 0;
+  void (*counted)(int*) = [](int* p) {
+    freed++;
+    delete p;
+  };
+  {
+    nstd::unique_ptr<int, void (*)(int*)> p(new int(3), counted);
+    auto q = nstd::move(p);
+    EXPECT_EQ(q.get_deleter(), counted);
+  }
+  EXPECT_EQ(freed, 1);
+}
+
+TEST(SharedPtr, DefaultConstructor) {
+  nstd::shared_ptr<int> ptr;
+  EXPECT_FALSE(ptr);
+  EXPECT_EQ(ptr.get(), nullptr);
+  EXPECT_EQ(ptr.use_count(), 0);
+}
+
+TEST(SharedPtr, RawPointerConstructor) {
+  nstd::shared_ptr<int> ptr(new int(10));
+  EXPECT_TRUE(ptr);
+  EXPECT_NE(ptr.get(), nullptr);
+  EXPECT_EQ(*ptr, 10);
+}
+
+TEST(SharedPtr, MoveConstructor) {
+  nstd::shared_ptr<int> ptr1(new int(42));
+  EXPECT_TRUE(ptr1);
+  EXPECT_EQ(ptr1.use_count(), 1);
+
+  nstd::shared_ptr<int> ptr2(nstd::move(ptr1));
+  EXPECT_FALSE(ptr1);
+  EXPECT_TRUE(ptr2);
+  EXPECT_NE(ptr2.get(), nullptr);
+  EXPECT_EQ(*ptr2, 42);
+  EXPECT_EQ(ptr2.use_count(), 1);
+}
+
+TEST(SharedPtr, MoveAssignment) {
+  nstd::shared_ptr<int> ptr1(new int(100));
+  nstd::shared_ptr<int> ptr2(new int(200));
+  EXPECT_EQ(*ptr1, 100);
+  EXPECT_EQ(*ptr2, 200);
+
+  ptr2 = nstd::move(ptr1);
+  EXPECT_FALSE(ptr1);
+  EXPECT_TRUE(ptr2);
+  EXPECT_EQ(*ptr2, 100);
+}
+
+TEST(SharedPtr, OperatorBool) {
+  nstd::shared_ptr<int> ptr;
+  EXPECT_FALSE(ptr);
+
+  ptr = nstd::shared_ptr<int>(new int(5));
+  EXPECT_TRUE(ptr);
+}
+
+TEST(SharedPtr, DereferenceOperator) {
+  nstd::shared_ptr<int> ptr(new int(5));
+  EXPECT_EQ(*ptr, 5);
+  *ptr = 10;
+  EXPECT_EQ(*ptr, 10);
+}
+
+TEST(SharedPtr, ArrowOperator) {
+  nstd::shared_ptr<TestType> ptr(new TestType(123));
+  ASSERT_NE(ptr.get(), nullptr);
+  EXPECT_EQ(ptr->getVal(), 123);
+
+  ptr->setVal(456);
+  EXPECT_EQ(ptr->getVal(), 456);
+}
+
+TEST(SharedPtr, SwapFunction) {
+  nstd::shared_ptr<int> ptr1(new int(1));
+  nstd::shared_ptr<int> ptr2(new int(2));
+  EXPECT_EQ(*ptr1, 1);
+  EXPECT_EQ(*ptr2, 2);
+
+  swap(ptr1, ptr2);
+  EXPECT_EQ(*ptr1, 2);
+  EXPECT_EQ(*ptr2, 1);
+}
+
+TEST(SharedPtr, ArraySupport) {
+  nstd::shared_ptr<int[]> arrPtr(new int[3]{10, 20, 30});
+  EXPECT_EQ(arrPtr[0], 10);
+  EXPECT_EQ(arrPtr[1], 20);
+  EXPECT_EQ(arrPtr[2], 30);
+
+  arrPtr[1] = 999;
+  EXPECT_EQ(arrPtr[1], 999);
+}
+
+TEST(SharedPtr, MakeShared) {
+  auto intPtr = nstd::make_shared<int>(77);
+  ASSERT_TRUE(intPtr);
+  EXPECT_EQ(*intPtr, 77);
+
+  auto objPtr = nstd::make_shared<TestType>(999);
+  ASSERT_TRUE(objPtr);
+  EXPECT_EQ(objPtr->getVal(), 999);
+}
+
+TEST(SharedPtr, SharingTest) {
+  auto ptr1 = nstd::make_shared<int>(42);
+  EXPECT_EQ(ptr1.use_count(), 1);
+  {
+    auto ptr2 = ptr1;
+    EXPECT_EQ(ptr1.use_count(), 2);
+    EXPECT_EQ(ptr2.use_count(), 2);
+  }
+  EXPECT_EQ(ptr1.use_count(), 1);
+}
+
+TEST(SharedPtr, DestroyedWithLastOwner) {
+  {
+    auto a = nstd::make_shared<TestType>(1);
+    nstd::shared_ptr<TestType> b(new Derived(2));
+    auto c = a;
+    b = a;
+    EXPECT_EQ(TestType::count, 1);
+    EXPECT_EQ(a.use_count(), 3);
+  }
+  EXPECT_EQ(TestType::count, 0);
+}
+
+TEST(SharedPtr, Conversions) {
+  {
+    nstd::shared_ptr<TestType> base = nstd::make_shared<Derived>(5);
+    EXPECT_EQ(base->getVal(), 5);
+
+    // aliasing: shares base's count, points at a member
+    nstd::shared_ptr<int> member(base, &base->x);
+    EXPECT_EQ(base.use_count(), 2);
+    EXPECT_FALSE(member.owner_before(base) || base.owner_before(member));
+    base.reset();
+    EXPECT_EQ(*member, 5);
+    EXPECT_EQ(TestType::count, 1);
+  }
+  EXPECT_EQ(TestType::count, 0);
+
+  nstd::shared_ptr<TestType> from_unique(nstd::make_unique<TestType>(6));
+  EXPECT_EQ(from_unique->getVal(), 6);
+  EXPECT_EQ(from_unique.use_count(), 1);
+}
+
+TEST(SharedPtr, Deleters) {
+  static int calls = 0;
+  auto counted = [](int* p) {
+    calls++;
+    delete p;
+  };
+  {
+    nstd::shared_ptr<int> p(new int(1), counted);
+    auto q = p;
+  }
+  EXPECT_EQ(calls, 1);
+  { nstd::shared_ptr<int> p(nullptr, counted); }
+  EXPECT_EQ(calls, 2);
+}
+
+TEST(SharedPtr, MakeSharedIsOneAllocation) {
+  int before = allocations;
+  auto p = nstd::make_shared<std::uint64_t>(1);
+  EXPECT_EQ(allocations - before, 1);
+
+  // the object follows the counts: vtable pointer, weak, then strong count
+  auto block = reinterpret_cast<std::uintptr_t>(last_alloc);
+  auto obj = reinterpret_cast<std::uintptr_t>(p.get());
+  EXPECT_EQ(obj - block, 3 * sizeof(void*));
+  EXPECT_EQ((block + 2 * sizeof(void*)) / 64, obj / 64);
+
+  // an over-aligned object is padded onto its own line, away from the counts
+  struct alignas(64) line {
+    int x;
+  };
+  auto padded = nstd::make_shared<line>(line{5});
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(padded.get()) % 64, 0u);
+  EXPECT_EQ(padded->x, 5);
+
+  before = allocations;
+  nstd::shared_ptr<std::uint64_t> q(new std::uint64_t(1));
+  EXPECT_EQ(allocations - before, 2);
+}
+
+TEST(SharedPtr, StatelessDeletersTakeNoRoom) {
+  nstd::shared_ptr<int> stateless(new int(1), empty_deleter());
+  std::size_t small = last_size;
+  nstd::shared_ptr<int> stateful(new int(1), +lambda_deleter);
+  EXPECT_EQ(last_size, small + sizeof(void (*)(int*)));
+}
+
+TEST(SharedPtr, ThrowingConstructorLeaksNothing) {
+  struct thrower {
+    thrower() { throw std::runtime_error("no"); }
+  };
+  EXPECT_THROW(nstd::make_shared<thrower>(), std::runtime_error);
+}
+
+TEST(SharedPtr, AllocateShared) {
+  arena ar;
+  {
+    int before = allocations;
+    auto p = nstd::allocate_shared<TestType>(arena_allocator<int>(&ar), 8);
+    EXPECT_EQ(allocations, before);
+    EXPECT_EQ(ar.live, 1);
+    EXPECT_EQ(p->getVal(), 8);
+    auto obj = reinterpret_cast<unsigned char*>(p.get());
+    EXPECT_TRUE(obj > ar.buf && obj < ar.buf + sizeof(ar.buf));
+
+    auto q = p;
+    p.reset();
+    EXPECT_EQ(ar.live, 1);
+    EXPECT_EQ(TestType::count, 1);
+  }
+  EXPECT_EQ(ar.live, 0);
+  EXPECT_EQ(TestType::count, 0);
+}
+
+TEST(SharedPtr, PointerDeleterAllocator) {
+  arena ar;
+  static int calls = 0;
+  auto counted = [](TestType* p) {
+    calls++;
+    delete p;
+  };
+  {
+    nstd::shared_ptr<TestType> p(new TestType(3), counted,
+                                 arena_allocator<char>(&ar));
+    EXPECT_EQ(ar.live, 1);
+    EXPECT_EQ(p->getVal(), 3);
+    p.reset(new TestType(4), counted, arena_allocator<char>(&ar));
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(ar.live, 1);
+  }
+  EXPECT_EQ(calls, 2);
+  EXPECT_EQ(ar.live, 0);
+
+  // a failed block allocation hands the pointer to the deleter
+  ar.used = sizeof(ar.buf);
+  EXPECT_THROW(nstd::shared_ptr<TestType>(new TestType(5), counted,
+                                          arena_allocator<char>(&ar)),
+               std::bad_alloc);
+  EXPECT_EQ(calls, 3);
+  EXPECT_EQ(TestType::count, 0);
+}
+
+TEST(SharedPtr, StatelessAllocatorsTakeNoRoom) {
+  auto a = nstd::make_shared<std::uint64_t>(1);
+  std::size_t plain = last_size;
+  auto b = nstd::allocate_shared<std::uint64_t>(plain_allocator<int>(), 1);
+  EXPECT_EQ(last_size, plain);
+
+  arena ar;
+  auto c = nstd::allocate_shared<std::uint64_t>(arena_allocator<int>(&ar), 1);
+  EXPECT_EQ(ar.last_size, plain + sizeof(arena*));
+}
+
+TEST(WeakPtr, LockAndExpire) {
+  nstd::weak_ptr<TestType> w;
+  EXPECT_TRUE(w.expired());
+  EXPECT_FALSE(w.lock());
+  {
+    auto p = nstd::make_shared<TestType>(9);
+    w = p;
+    EXPECT_FALSE(w.expired());
+    EXPECT_EQ(w.use_count(), 1);
+
+    auto q = w.lock();
+    ASSERT_TRUE(q);
+    EXPECT_EQ(q->getVal(), 9);
+    EXPECT_EQ(p.use_count(), 2);
+
+    nstd::shared_ptr<TestType> r(w);
+    EXPECT_EQ(r.use_count(), 3);
+    EXPECT_FALSE(w.owner_before(p) || p.owner_before(w));
+  }
+  EXPECT_TRUE(w.expired());
+  EXPECT_EQ(w.use_count(), 0);
+  EXPECT_FALSE(w.lock());
+  EXPECT_THROW(nstd::shared_ptr<TestType>{w}, nstd::bad_weak_ptr);
+}
+
+TEST(WeakPtr, CopyMoveAndConvert) {
+  auto p = nstd::make_shared<Derived>(4);
+  nstd::weak_ptr<Derived> a(p);
+  nstd::weak_ptr<Derived> b = a;
+  nstd::weak_ptr<TestType> c(a);
+  nstd::weak_ptr<TestType> d(nstd::move(b));
+  EXPECT_TRUE(b.expired());
+  EXPECT_EQ(c.lock()->getVal(), 4);
+  EXPECT_EQ(d.lock()->getVal(), 4);
+
+  swap(a, b);
+  EXPECT_TRUE(a.expired());
+  EXPECT_FALSE(b.expired());
+  b.reset();
+  EXPECT_TRUE(b.expired());
+}
+
+TEST(WeakPtr, ObjectAndBlockLifetimes) {
+  arena ar;
+  nstd::weak_ptr<TestType> w;
+  {
+    auto p = nstd::allocate_shared<TestType>(arena_allocator<int>(&ar), 1);
+    w = p;
+  }
+  // the object goes with the last owner, the block with the last observer
+  EXPECT_EQ(TestType::count, 0);
+  EXPECT_EQ(ar.live, 1);
+  auto w2 = w;
+  w.reset();
+  EXPECT_EQ(ar.live, 1);
+  w2.reset();
+  EXPECT_EQ(ar.live, 0);
+}
+
+TEST(WeakPtr, LockRacesLastRelease) {
+  for (int round = 0; round < 200; round++) {
+    auto p = nstd::make_shared<TestType>(round);
+    nstd::weak_ptr<TestType> w(p);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+      readers.emplace_back([&w, round] {
+        for (int i = 0; i < 100; i++) {
+          if (auto q = w.lock()) {
+            EXPECT_EQ(q->getVal(), round);
+          }
+        }
+      });
+    }
+    p.reset();
+    for (auto& t : readers)
+      t.join();
+    EXPECT_TRUE(w.expired());
+    EXPECT_EQ(TestType::count, 0);
+  }
+}
+
+TEST(LocalSharedPtr, CopyAndRelease) {
+  {
+    auto p = nstd::make_local_shared<TestType>(3);
+    EXPECT_EQ(p.use_count(), 1);
+    {
+      auto q = p;
+      nstd::local_shared_ptr<TestType> r;
+      r = q;
+      EXPECT_EQ(p.use_count(), 3);
+      EXPECT_EQ(r->getVal(), 3);
+    }
+    EXPECT_EQ(p.use_count(), 1);
+
+    nstd::local_shared_ptr<TestType> base(new Derived(4));
+    nstd::local_shared_ptr<int> member(base, &base->x);
+    base.reset();
+    EXPECT_EQ(*member, 4);
+    EXPECT_EQ(TestType::count, 2);
+  }
+  EXPECT_EQ(TestType::count, 0);
+}
+
+TEST(LocalSharedPtr, AllocatorAndDeleter) {
+  arena ar;
+  static int calls = 0;
+  auto counted = [](TestType* p) {
+    calls++;
+    delete p;
+  };
+  {
+    auto p =
+        nstd::allocate_local_shared<TestType>(arena_allocator<int>(&ar), 5);
+    nstd::local_shared_ptr<TestType> q(new TestType(6), counted,
+                                       arena_allocator<int>(&ar));
+    auto copy = q;
+    EXPECT_EQ(ar.live, 2);
+  }
+  EXPECT_EQ(ar.live, 0);
+  EXPECT_EQ(calls, 1);
+}
+
+TEST(LocalSharedPtr, CheckedConversion) {
+  auto p = nstd::make_local_shared<TestType>(7);
+  auto q = p;
+  EXPECT_THROW(nstd::shared_ptr<TestType>{nstd::move(p)},
+               std::invalid_argument);
+  EXPECT_EQ(p.use_count(), 2);
+  EXPECT_EQ(p->getVal(), 7);
+
+  q.reset();
+  nstd::shared_ptr<TestType> s(nstd::move(p));
+  EXPECT_FALSE(p);
+  EXPECT_EQ(s.use_count(), 1);
+  EXPECT_EQ(s->getVal(), 7);
+
+  // from here on the counts are atomic and reachable from other threads
+  std::thread t([copy = s] { EXPECT_EQ(copy->getVal(), 7); });
+  t.join();
+  s.reset();
+  EXPECT_EQ(TestType::count, 0);
+}
+
+// destroyed from whichever thread drops the last reference
+struct tracked {
+  static std::atomic<int> live;
+  int x;
+
+  explicit tracked(int v) : x(v) { live++; }
+  ~tracked() { live--; }
+};
+
+std::atomic<int> tracked::live = 0;
+
+TEST(AtomicSharedPtr, LoadStoreExchange) {
+  static_assert(nstd::atomic_shared_ptr<int>::is_always_lock_free);
+  {
+    nstd::atomic_shared_ptr<TestType> a;
+    EXPECT_TRUE(a.is_lock_free());
+    EXPECT_FALSE(a.load());
+
+    auto p = nstd::make_shared<TestType>(1);
+    a.store(p);
+    EXPECT_EQ(p.use_count(), 2);
+    nstd::shared_ptr<TestType> got = a;
+    EXPECT_EQ(got, p);
+    EXPECT_EQ(p.use_count(), 3);
+
+    auto old = a.exchange(nstd::make_shared<TestType>(2));
+    EXPECT_EQ(old, p);
+    EXPECT_EQ(a.load()->getVal(), 2);
+    EXPECT_EQ(TestType::count, 2);
+
+    a = nullptr;
+    EXPECT_FALSE(a.load());
+    EXPECT_EQ(TestType::count, 1);
+
+    // an empty pointer that still owns something is not a null word
+    static int deleted = 0;
+    nstd::atomic_shared_ptr<int> owning(
+        nstd::shared_ptr<int>(nullptr, [](int*) { deleted++; }));
+    EXPECT_EQ(owning.load().use_count(), 2);
+    owning.store(nullptr);
+    EXPECT_EQ(deleted, 1);
+
+    nstd::atomic_shared_ptr<TestType> initial(p);
+    EXPECT_EQ(initial.load(), p);
+  }
+  EXPECT_EQ(TestType::count, 0);
+}
+
+TEST(AtomicSharedPtr, CompareExchange) {
+  auto p = nstd::make_shared<TestType>(1);
+  auto q = nstd::make_shared<TestType>(2);
+  nstd::atomic_shared_ptr<TestType> a(p);
+
+  nstd::shared_ptr<TestType> expected = q;
+  EXPECT_FALSE(a.compare_exchange_strong(expected, q));
+  EXPECT_EQ(expected, p);
+  EXPECT_EQ(a.load(), p);
+
+  EXPECT_TRUE(a.compare_exchange_strong(expected, q));
+  EXPECT_EQ(a.load(), q);
+  EXPECT_EQ(p.use_count(), 2);
+
+  // the same pointer under another owner does not match
+  nstd::shared_ptr<TestType> alias(p, q.get());
+  expected = alias;
+  EXPECT_FALSE(a.compare_exchange_weak(expected, nullptr));
+  EXPECT_EQ(expected, q);
+  EXPECT_EQ(a.load(), q);
+
+  EXPECT_TRUE(a.compare_exchange_weak(expected, nullptr));
+  expected = nullptr;
+  EXPECT_TRUE(a.compare_exchange_strong(expected, p));
+  EXPECT_EQ(a.load(), p);
+}
+
+TEST(AtomicSharedPtr, ReadersRaceWriters) {
+  constexpr int rounds = 2000;
+  {
+    nstd::atomic_shared_ptr<tracked> a(nstd::make_shared<tracked>(0));
+    std::atomic<bool> done = false;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; t++) {
+      threads.emplace_back([&] {
+        int last = 0;
+        while (!done) {
+          auto p = a.load();
+          // a single writer only moves forward
+          EXPECT_GE(p->x, last);
+          last = p->x;
+        }
+      });
+    }
+    threads.emplace_back([&] {
+      for (int i = 1; i <= rounds; i++) {
+        if (i % 3 == 0)
+          a.store(nstd::make_shared<tracked>(i));
+        else if (i % 3 == 1)
+          a.exchange(nstd::make_shared<tracked>(i));
+        else {
+          auto cur = a.load();
+          EXPECT_TRUE(
+              a.compare_exchange_strong(cur, nstd::make_shared<tracked>(i)));
+        }
+      }
+      done = true;
+    });
+    for (auto& t : threads)
+      t.join();
+    EXPECT_EQ(a.load()->x, rounds);
+    EXPECT_EQ(tracked::live, 1);
+  }
+  EXPECT_EQ(tracked::live, 0);
+}
+
+TEST(AtomicSharedPtr, CompareExchangeCounts) {
+  constexpr int threads = 4, adds = 2000;
+  nstd::atomic_shared_ptr<tracked> a(nstd::make_shared<tracked>(0));
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; t++) {
+    pool.emplace_back([&] {
+      for (int i = 0; i < adds; i++) {
+        auto cur = a.load();
+        while (!a.compare_exchange_weak(
+            cur, nstd::make_shared<tracked>(cur->x + 1))) {
+        }
+      }
+    });
+  }
+  for (auto& t : pool)
+    t.join();
+  EXPECT_EQ(a.load()->x, threads * adds);
+  a.store(nullptr);
+  EXPECT_EQ(tracked::live, 0);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,73 @@
+#include "../include/dynamic_bitset.hpp"
+#include "../include/rank_select.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+// checks rank1 at every position and select1 for every set bit
+template <class Bitset> void check_against_scan(const Bitset& bits) {
+  nstd::rank_select<Bitset> rs(bits);
+  std::size_t rank = 0;
+  for (std::size_t i = 0; i < bits.size(); i++) {
+    ASSERT_EQ(rs.rank1(i), rank) << "i=" << i;
+    if (bits[i]) {
+      ASSERT_EQ(rs.select1(rank), i) << "k=" << rank;
+      rank++;
+    }
+  }
+  EXPECT_EQ(rs.rank1(bits.size()), rank);
+  EXPECT_EQ(rs.count(), rank);
+  EXPECT_EQ(rs.select1(rank), rs.npos);
+}
+
+TEST(RankSelectTest, Empty) {
+  nstd::dynamic_bitset<> b;
+  nstd::rank_select rs(b);
+  EXPECT_EQ(rs.rank1(0), 0u);
+  EXPECT_EQ(rs.select1(0), rs.npos);
+  EXPECT_THROW(rs.rank1(1), std::out_of_range);
+}
+
+TEST(RankSelectTest, FixedBitset) {
+  nstd::bitset<5000> b;
+  for (std::size_t i = 0; i < b.size(); i += 3)
+    b.set(i);
+  check_against_scan(b);
+  nstd::rank_select rs(b);
+  EXPECT_EQ(rs.rank0(9), 6u);
+}
+
+TEST(RankSelectTest, DenseAndSparse) {
+  std::mt19937_64 gen(7);
+  for (double density : {0.001, 0.05, 0.5, 0.97, 1.0}) {
+    std::bernoulli_distribution coin(density);
+    nstd::dynamic_bitset<> b(100000 + 37);
+    for (std::size_t i = 0; i < b.size(); i++)
+      b[i] = coin(gen);
+    check_against_scan(b);
+  }
+}
+
+TEST(RankSelectTest, ClusteredOnes) {
+  // long empty stretches between samples exercise the binary search
+  nstd::dynamic_bitset<> b(1 << 20);
+  for (std::size_t i = 0; i < 20000; i++)
+    b.set(i);
+  for (std::size_t i = 700000; i < 720000; i++)
+    b.set(i);
+  b.set(b.size() - 1);
+  check_against_scan(b);
+}
+
+TEST(RankSelectTest, SpaceOverhead) {
+  nstd::dynamic_bitset<> b(1 << 24);
+  nstd::rank_select rs(b);
+  double overhead =
+      static_cast<double>(rs.directory_bytes()) / static_cast<double>(b.size() / 8);
+  EXPECT_LT(overhead, 0.04);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
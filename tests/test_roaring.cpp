@@ -0,0 +1,134 @@
+#include "../include/roaring.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+using nstd::roaring_bitmap;
+
+static std::vector<std::uint32_t> as_vector(const std::set<std::uint32_t>& s) {
+  return {s.begin(), s.end()};
+}
+
+// a mix of sparse values, a dense chunk and long runs
+static std::set<std::uint32_t> sample(unsigned seed) {
+  std::mt19937 gen(seed);
+  std::set<std::uint32_t> s;
+  for (int i = 0; i < 3000; i++)
+    s.insert(gen());
+  for (int i = 0; i < 20000; i++)
+    s.insert((7u << 16) | (gen() & 0xffff));
+  std::uint32_t start = (9u << 16) + (gen() & 0xfff);
+  for (std::uint32_t v = start; v < start + 30000; v++)
+    s.insert(v);
+  return s;
+}
+
+static roaring_bitmap build(const std::set<std::uint32_t>& s) {
+  roaring_bitmap r;
+  for (auto v : s)
+    r.add(v);
+  return r;
+}
+
+TEST(RoaringTest, AddContainsRemove) {
+  roaring_bitmap r{1, 5, 70000, 0xffffffffu};
+  EXPECT_EQ(r.cardinality(), 4u);
+  EXPECT_TRUE(r.contains(5));
+  EXPECT_TRUE(r.contains(0xffffffffu));
+  EXPECT_FALSE(r.contains(6));
+  r.add(5);
+  EXPECT_EQ(r.cardinality(), 4u);
+  r.remove(70000);
+  r.remove(70001);
+  EXPECT_FALSE(r.contains(70000));
+  EXPECT_EQ(r.to_vector(), (std::vector<std::uint32_t>{1, 5, 0xffffffffu}));
+}
+
+TEST(RoaringTest, ArrayBitmapTransitions) {
+  roaring_bitmap r;
+  for (std::uint32_t v = 0; v < 10000; v++)
+    r.add(v * 2);
+  EXPECT_EQ(r.cardinality(), 10000u);
+  for (std::uint32_t v = 0; v < 10000; v++)
+    ASSERT_TRUE(r.contains(v * 2));
+  for (std::uint32_t v = 0; v < 9990; v++)
+    r.remove(v * 2);
+  EXPECT_EQ(r.cardinality(), 10u);
+  r.optimize();
+  EXPECT_LT(r.memory_bytes(), 1024u);
+  for (std::uint32_t v = 9990; v < 10000; v++)
+    r.remove(v * 2);
+  EXPECT_TRUE(r.empty());
+}
+
+TEST(RoaringTest, RunsAreCompact) {
+  roaring_bitmap r;
+  for (std::uint32_t v = 100; v < 200000; v++)
+    r.add(v);
+  r.optimize();
+  EXPECT_EQ(r.cardinality(), 199900u);
+  EXPECT_LT(r.memory_bytes(), 1024u);
+  EXPECT_TRUE(r.contains(100));
+  EXPECT_TRUE(r.contains(199999));
+  EXPECT_FALSE(r.contains(99));
+  EXPECT_FALSE(r.contains(200000));
+  // mutating a run chunk decodes it and keeps the contents
+  r.remove(150);
+  r.add(250000);
+  EXPECT_FALSE(r.contains(150));
+  EXPECT_EQ(r.cardinality(), 199900u);
+}
+
+TEST(RoaringTest, SetOperationsMatchStdSet) {
+  auto a = sample(1), b = sample(2);
+  auto ra = build(a), rb = build(b);
+  for (int pass = 0; pass < 2; pass++) {
+    std::set<std::uint32_t> expected;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                          std::inserter(expected, expected.end()));
+    EXPECT_EQ((ra & rb).to_vector(), as_vector(expected));
+
+    expected.clear();
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                   std::inserter(expected, expected.end()));
+    EXPECT_EQ((ra | rb).to_vector(), as_vector(expected));
+
+    expected.clear();
+    std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(),
+                                  std::inserter(expected, expected.end()));
+    EXPECT_EQ((ra ^ rb).to_vector(), as_vector(expected));
+
+    expected.clear();
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(),
+                        std::inserter(expected, expected.end()));
+    EXPECT_EQ(and_not(ra, rb).to_vector(), as_vector(expected));
+
+    // second pass with run containers on both sides
+    ra.optimize();
+    rb.optimize();
+  }
+}
+
+TEST(RoaringTest, CompoundAssignmentAndEquality) {
+  auto a = sample(3);
+  auto r = build(a);
+  auto copy = r;
+  copy.optimize();
+  EXPECT_TRUE(r == copy);
+  r |= roaring_bitmap{42};
+  EXPECT_FALSE(r == copy || !r.contains(42));
+  r &= copy;
+  EXPECT_TRUE(r == copy || a.count(42));
+  r ^= copy;
+  EXPECT_TRUE(r.empty());
+  copy.and_not(copy);
+  EXPECT_TRUE(copy.empty());
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
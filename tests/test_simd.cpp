@@ -0,0 +1,193 @@
+#include "../include/bitset.hpp"
+#include "../include/simd.hpp"
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace simd = nstd::detail::simd;
+
+// every level up to the one this CPU supports, checked against scalar
+static std::vector<simd::isa> supported_levels() {
+  std::vector<simd::isa> levels;
+  for (auto level : {simd::isa::scalar, simd::isa::sse2, simd::isa::avx2,
+                     simd::isa::avx512}) {
+    if (level <= simd::detected_isa())
+      levels.push_back(level);
+  }
+  return levels;
+}
+
+static std::vector<simd::word> random_words(std::size_t n, unsigned seed) {
+  std::mt19937_64 gen(seed);
+  std::vector<simd::word> v(n);
+  for (auto& w : v)
+    w = gen();
+  return v;
+}
+
+// lengths straddling every vector width and the Harley-Seal block of 64
+static const std::size_t lengths[] = {0,  1,  2,  3,  7,   8,   9,  15,
+                                      16, 17, 63, 64, 65, 127, 128, 200};
+
+TEST(SimdTest, BinaryOps) {
+  for (auto level : supported_levels()) {
+    auto k = simd::kernels_for(level);
+    for (std::size_t n : lengths) {
+      auto a = random_words(n, 1), b = random_words(n, 2);
+      auto x = a, y = a, z = a;
+      k.bit_and(x.data(), b.data(), n);
+      k.bit_or(y.data(), b.data(), n);
+      k.bit_xor(z.data(), b.data(), n);
+      for (std::size_t i = 0; i < n; i++) {
+        ASSERT_EQ(x[i], a[i] & b[i]) << "level " << int(level) << " n " << n;
+        ASSERT_EQ(y[i], a[i] | b[i]) << "level " << int(level) << " n " << n;
+        ASSERT_EQ(z[i], a[i] ^ b[i]) << "level " << int(level) << " n " << n;
+      }
+      k.bit_not(x.data(), n);
+      for (std::size_t i = 0; i < n; i++) {
+        ASSERT_EQ(x[i], ~(a[i] & b[i]));
+      }
+    }
+  }
+}
+
+TEST(SimdTest, Count) {
+  for (auto level : supported_levels()) {
+    auto k = simd::kernels_for(level);
+    for (std::size_t n : lengths) {
+      auto a = random_words(n, 3);
+      EXPECT_EQ(k.count(a.data(), n), simd::scalar::count(a.data(), n))
+          << "level " << int(level) << " n " << n;
+    }
+    std::vector<simd::word> ones(1000, ~simd::word{0});
+    EXPECT_EQ(k.count(ones.data(), ones.size()), 64000u);
+  }
+}
+
+TEST(SimdTest, Predicates) {
+  for (auto level : supported_levels()) {
+    auto k = simd::kernels_for(level);
+    for (std::size_t n : lengths) {
+      std::vector<simd::word> zeros(n, 0), ones(n, ~simd::word{0});
+      EXPECT_FALSE(k.any(zeros.data(), n));
+      EXPECT_TRUE(k.all(ones.data(), n));
+      EXPECT_TRUE(k.equal(zeros.data(), zeros.data(), n));
+      // a single differing bit in each position must be noticed
+      for (std::size_t i = 0; i < n; i++) {
+        zeros[i] = 1;
+        ones[i] = ~simd::word{2};
+        auto copy = zeros;
+        copy[i] = 0;
+        ASSERT_TRUE(k.any(zeros.data(), n)) << "n " << n << " i " << i;
+        ASSERT_FALSE(k.all(ones.data(), n)) << "n " << n << " i " << i;
+        ASSERT_FALSE(k.equal(zeros.data(), copy.data(), n));
+        zeros[i] = 0;
+        ones[i] = ~simd::word{0};
+      }
+    }
+  }
+}
+
+TEST(SimdTest, ParseText) {
+  std::mt19937 gen(7);
+  for (auto level : supported_levels()) {
+    auto k = simd::kernels_for(level);
+    for (std::size_t n : {0, 1, 15, 16, 31, 32, 33, 63, 64, 65, 100, 128, 129,
+                          300}) {
+      std::string text(n, 'a');
+      for (auto& c : text)
+        c = gen() % 2 ? 'b' : 'a';
+      std::size_t words = (n + 63) / 64;
+      std::vector<simd::word> got(words + 1, 0xdead), want(words + 1, 0xdead);
+      ASSERT_EQ(k.parse(text.data(), n, 'a', 'b', got.data()), n);
+      simd::scalar::parse(text.data(), n, 'a', 'b', want.data());
+      EXPECT_EQ(got, want) << "level " << int(level) << " n " << n;
+      for (std::size_t i = 0; i < n; i++)
+        ASSERT_EQ((got[i / 64] >> (i % 64)) & 1, text[i] == 'b' ? 1u : 0u);
+
+      // the first bad character wins, wherever it falls
+      for (std::size_t bad = 0; bad < n; bad += 13) {
+        std::string broken = text;
+        broken[bad] = 'x';
+        if (bad + 40 < n)
+          broken[bad + 40] = 'y';
+        EXPECT_EQ(k.parse(broken.data(), n, 'a', 'b', got.data()), bad)
+            << "level " << int(level) << " n " << n;
+      }
+    }
+  }
+}
+
+TEST(SimdTest, FormatText) {
+  for (auto level : supported_levels()) {
+    auto k = simd::kernels_for(level);
+    for (std::size_t n : {0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 128,
+                          129, 300}) {
+      auto src = random_words((n + 63) / 64, 8);
+      std::string got(n + 1, '#'), want(n + 1, '#');
+      k.format(src.data(), n, '.', '|', got.data());
+      simd::scalar::format(src.data(), n, '.', '|', want.data());
+      EXPECT_EQ(got, want) << "level " << int(level) << " n " << n;
+      for (std::size_t j = 0; j < n; j++) {
+        std::size_t i = n - 1 - j;
+        ASSERT_EQ(want[j], (src[i / 64] >> (i % 64)) & 1 ? '|' : '.');
+      }
+    }
+  }
+}
+
+TEST(SimdTest, GatherScatter) {
+  auto& k = simd::active();
+  std::mt19937_64 gen(9);
+  for (int i = 0; i < 1000; i++) {
+    simd::word src = gen(), mask = gen() & gen();
+    if (i % 10 == 0)
+      mask = i % 20 ? ~simd::word{0} : 0;
+    simd::word packed = simd::scalar::pext(src, mask);
+    EXPECT_EQ(k.pext(src, mask), packed);
+    EXPECT_EQ(k.pdep(src, mask), simd::scalar::pdep(src, mask));
+    // deposit undoes extract on the bits under the mask
+    EXPECT_EQ(simd::scalar::pdep(packed, mask), src & mask);
+  }
+}
+
+TEST(SimdTest, HashStripes) {
+  auto src = random_words(8 * 40, 10);
+  for (auto level : supported_levels()) {
+    auto k = simd::kernels_for(level);
+    // 40 stripes cross the scramble interval twice
+    for (std::size_t stripes : {1, 15, 16, 17, 40}) {
+      simd::word expected[8], got[8];
+      for (std::size_t l = 0; l < 8; l++)
+        expected[l] = got[l] = l * 12345;
+      simd::scalar::hash_stripes(expected, src.data(), stripes);
+      k.hash_stripes(got, src.data(), stripes);
+      for (std::size_t l = 0; l < 8; l++)
+        ASSERT_EQ(got[l], expected[l]) << "level " << int(level);
+    }
+  }
+}
+
+TEST(SimdTest, LargeBitset) {
+  nstd::bitset<4000> a, b;
+  for (std::size_t i = 0; i < a.size(); i += 3)
+    a.set(i);
+  for (std::size_t i = 0; i < b.size(); i += 5)
+    b.set(i);
+  EXPECT_EQ(a.count(), 1334u);
+  EXPECT_EQ((a & b).count(), 267u);
+  EXPECT_EQ((a | b).count(), 1334u + 800u - 267u);
+  EXPECT_EQ((a ^ b).count(), 1334u + 800u - 2 * 267u);
+  EXPECT_EQ((~a).count(), 4000u - 1334u);
+  EXPECT_TRUE((a | ~a).all());
+  EXPECT_FALSE((a & ~a).any());
+  EXPECT_TRUE(a == nstd::bitset<4000>(a));
+  EXPECT_FALSE(a == b);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}